@@ -1,5 +1,7 @@
 #ifdef DL_TRACK_ALLOCS
 #include <cstdlib>
+#include <cstring>
+#include <stdexcept>
 #include "AllocTracker.h"
 
 namespace ducklib::Internal::Memory
@@ -11,10 +13,27 @@ AllocTracker& GetAllocTracker()
 }
 
 AllocTracker::AllocTracker()
-	: entries(nullptr)
-	, length(0)
-	, capacity(0)
+	: snapshot(nullptr)
+	, snapshotCapacity(0)
 {
+	for (Shard& shard : shards)
+	{
+		shard.ptrs = nullptr;
+		shard.files = nullptr;
+		shard.functions = nullptr;
+		shard.sizes = nullptr;
+		shard.lines = nullptr;
+		shard.count = 0;
+		shard.capacityLog2 = 0;
+	}
+}
+
+AllocTracker::~AllocTracker()
+{
+	for (Shard& shard : shards)
+		FreeShard(shard);
+
+	free(snapshot);
 }
 
 void AllocTracker::Track(
@@ -24,23 +43,15 @@ void AllocTracker::Track(
 	const char* function,
 	uint32 line)
 {
-	lock.lock();
+	// nullptr marks empty slots, and like free(nullptr) there is nothing to track
+	if (!ptr)
+		return;
 
-	if (length == capacity)
-	{
-		capacity = capacity == 0 ? START_CAPACITY : (uint32)(capacity * 1.6);
-		entries = (Entry*)realloc(entries, capacity * sizeof(Entry));
-	}
-
-	entries[length].ptr = ptr;
-	entries[length].file = file;
-	entries[length].function = function;
-	entries[length].size = size;
-	entries[length].line = line;
+	uint64 hash = Hash(ptr);
+	Shard& shard = GetShard(hash);
+	std::lock_guard<std::mutex> guard(shard.lock);
 
-	++length;
-
-	lock.unlock();
+	Insert(shard, hash, ptr, size, file, function, line);
 }
 
 void AllocTracker::Modify(
@@ -51,59 +62,254 @@ void AllocTracker::Modify(
 	const char* function,
 	uint32 line)
 {
-	lock.lock();
+	// Same as realloc, from nullptr is a new allocation and to nullptr a free
+	if (!ptr)
+	{
+		Track(newPtr, size, file, function, line);
+		return;
+	}
+
+	if (!newPtr)
+	{
+		Remove(ptr);
+		return;
+	}
+
+	uint64 hash = Hash(ptr);
+	Shard& shard = GetShard(hash);
 
-	uint32 i = FindAlloc(ptr);
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+		uint32 slot = FindSlot(shard, hash, ptr);
 
-	entries[i].ptr = newPtr;
-	entries[i].file = file;
-	entries[i].function = function;
-	entries[i].size = size;
-	entries[i].line = line;
+		if (slot == NOT_FOUND)
+			throw std::runtime_error("Alloc not found in tracker");
 
-	lock.unlock();
+		if (newPtr == ptr)
+		{
+			shard.files[slot] = file;
+			shard.functions[slot] = function;
+			shard.sizes[slot] = size;
+			shard.lines[slot] = line;
+			return;
+		}
+
+		RemoveSlot(shard, slot);
+	}
+
+	// The new pointer most likely hashes to another shard
+	Track(newPtr, size, file, function, line);
 }
 
 void AllocTracker::Remove(void* ptr)
 {
-	lock.lock();
+	if (!ptr)
+		return;
 
-	uint32 i = FindAlloc(ptr);
-	uint32 newLength = length - 1;
+	uint64 hash = Hash(ptr);
+	Shard& shard = GetShard(hash);
+	std::lock_guard<std::mutex> guard(shard.lock);
+	uint32 slot = FindSlot(shard, hash, ptr);
 
-	entries[i].ptr = entries[newLength].ptr;
-	entries[i].file = entries[newLength].file;
-	entries[i].function = entries[newLength].function;
-	entries[i].size = entries[newLength].size;
-	entries[i].line = entries[newLength].line;
+	if (slot == NOT_FOUND)
+		throw std::runtime_error("Alloc not found in tracker");
 
-	length = newLength;
-
-	lock.unlock();
+	RemoveSlot(shard, slot);
 }
 
 const AllocTracker::Entry* AllocTracker::GetEntries()
 {
-	return entries;
+	for (Shard& shard : shards)
+		shard.lock.lock();
+
+	uint32 entryCount = 0;
+
+	for (const Shard& shard : shards)
+		entryCount += shard.count;
+
+	if (entryCount > snapshotCapacity)
+	{
+		snapshotCapacity = entryCount;
+		snapshot = (Entry*)realloc(snapshot, snapshotCapacity * sizeof(Entry));
+	}
+
+	uint32 entryIndex = 0;
+
+	for (const Shard& shard : shards)
+	{
+		uint32 capacity = shard.ptrs ? 1u << shard.capacityLog2 : 0;
+
+		for (uint32 i = 0; i < capacity; ++i)
+		{
+			if (!shard.ptrs[i])
+				continue;
+
+			Entry& entry = snapshot[entryIndex++];
+			entry.ptr = shard.ptrs[i];
+			entry.file = shard.files[i];
+			entry.function = shard.functions[i];
+			entry.size = shard.sizes[i];
+			entry.line = shard.lines[i];
+		}
+	}
+
+	for (Shard& shard : shards)
+		shard.lock.unlock();
+
+	return snapshot;
 }
 
 uint32 AllocTracker::GetEntryCount()
 {
-	return length;
+	uint32 entryCount = 0;
+
+	for (Shard& shard : shards)
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+		entryCount += shard.count;
+	}
+
+	return entryCount;
 }
 
 void AllocTracker::Clear()
 {
-	length = 0;
+	for (Shard& shard : shards)
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+
+		if (shard.ptrs)
+			memset(shard.ptrs, 0, sizeof(void*) << shard.capacityLog2);
+
+		shard.count = 0;
+	}
+}
+
+uint64 AllocTracker::Hash(const void* ptr)
+{
+	// Fibonacci hashing spreads the aligned (low zero bit) pointers over the high bits
+	return (uint64)(uintptr_t)ptr * 0x9E3779B97F4A7C15ull;
+}
+
+AllocTracker::Shard& AllocTracker::GetShard(uint64 hash)
+{
+	return shards[hash >> (64 - SHARD_COUNT_LOG2)];
+}
+
+void AllocTracker::Insert(
+	Shard& shard,
+	uint64 hash,
+	void* ptr,
+	uint64 size,
+	const char* file,
+	const char* function,
+	uint32 line)
+{
+	// Keep the load factor under 3/4
+	if (!shard.ptrs || (shard.count + 1) * 4 > (3u << shard.capacityLog2))
+		Grow(shard);
+
+	uint32 mask = (1u << shard.capacityLog2) - 1;
+	uint32 slot = (uint32)(hash >> (64 - SHARD_COUNT_LOG2 - shard.capacityLog2)) & mask;
+
+	while (shard.ptrs[slot] && shard.ptrs[slot] != ptr)
+		slot = (slot + 1) & mask;
+
+	if (!shard.ptrs[slot])
+		++shard.count;
+
+	shard.ptrs[slot] = ptr;
+	shard.files[slot] = file;
+	shard.functions[slot] = function;
+	shard.sizes[slot] = size;
+	shard.lines[slot] = line;
+}
+
+uint32 AllocTracker::FindSlot(const Shard& shard, uint64 hash, const void* ptr)
+{
+	if (!shard.ptrs)
+		return NOT_FOUND;
+
+	uint32 mask = (1u << shard.capacityLog2) - 1;
+	uint32 slot = (uint32)(hash >> (64 - SHARD_COUNT_LOG2 - shard.capacityLog2)) & mask;
+
+	while (shard.ptrs[slot])
+	{
+		if (shard.ptrs[slot] == ptr)
+			return slot;
+
+		slot = (slot + 1) & mask;
+	}
+
+	return NOT_FOUND;
+}
+
+void AllocTracker::RemoveSlot(Shard& shard, uint32 slot)
+{
+	uint32 mask = (1u << shard.capacityLog2) - 1;
+	uint32 hole = slot;
+
+	// Shift following entries back into the hole instead of leaving tombstones so lookups stay short
+	for (uint32 i = (slot + 1) & mask; shard.ptrs[i]; i = (i + 1) & mask)
+	{
+		uint64 hash = Hash(shard.ptrs[i]);
+		uint32 home = (uint32)(hash >> (64 - SHARD_COUNT_LOG2 - shard.capacityLog2)) & mask;
+
+		// Only move entries whose home slot is not between the hole and their current slot
+		if (((i - home) & mask) < ((i - hole) & mask))
+			continue;
+
+		shard.ptrs[hole] = shard.ptrs[i];
+		shard.files[hole] = shard.files[i];
+		shard.functions[hole] = shard.functions[i];
+		shard.sizes[hole] = shard.sizes[i];
+		shard.lines[hole] = shard.lines[i];
+		hole = i;
+	}
+
+	shard.ptrs[hole] = nullptr;
+	--shard.count;
 }
 
-uint32 AllocTracker::FindAlloc(const void* ptr)
+void AllocTracker::Grow(Shard& shard)
 {
-	for (uint32 i = 0; i < length; ++i)
-		if (entries[i].ptr == ptr)
-			return i;
+	Shard old;
+	old.ptrs = shard.ptrs;
+	old.files = shard.files;
+	old.functions = shard.functions;
+	old.sizes = shard.sizes;
+	old.lines = shard.lines;
+	old.capacityLog2 = shard.capacityLog2;
+
+	uint32 oldCapacity = shard.ptrs ? 1u << shard.capacityLog2 : 0;
+
+	shard.capacityLog2 = shard.ptrs ? shard.capacityLog2 + 1 : START_CAPACITY_LOG2;
 
-	throw std::runtime_error("Alloc not found in tracker");
+	uint32 capacity = 1u << shard.capacityLog2;
+
+	shard.ptrs = (void**)calloc(capacity, sizeof(void*));
+	shard.files = (const char**)malloc(capacity * sizeof(const char*));
+	shard.functions = (const char**)malloc(capacity * sizeof(const char*));
+	shard.sizes = (uint64*)malloc(capacity * sizeof(uint64));
+	shard.lines = (uint32*)malloc(capacity * sizeof(uint32));
+	shard.count = 0;
+
+	for (uint32 i = 0; i < oldCapacity; ++i)
+	{
+		if (old.ptrs[i])
+			Insert(shard, Hash(old.ptrs[i]), old.ptrs[i], old.sizes[i], old.files[i], old.functions[i], old.lines[i]);
+	}
+
+	FreeShard(old);
+}
+
+void AllocTracker::FreeShard(Shard& shard)
+{
+	free(shard.ptrs);
+	free(shard.files);
+	free(shard.functions);
+	free(shard.sizes);
+	free(shard.lines);
 }
 }
 #endif
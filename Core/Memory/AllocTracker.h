@@ -11,10 +11,14 @@ class AllocTracker;
 
 AllocTracker& GetAllocTracker();
 
+/**
+ * Keeps track of live allocations and where they were made. Allocations are hashed by pointer into shards that each
+ * have their own lock and open addressing table, so Track/Modify/Remove are O(1) and threads allocating different
+ * memory rarely contend.
+ */
 class AllocTracker
 {
 public:
-	// TODO: AoS -> SoA? Even map?
 	struct Entry
 	{
 		void* ptr;
@@ -25,24 +29,53 @@ public:
 	};
 
 	AllocTracker();
+	~AllocTracker();
+
+	AllocTracker(const AllocTracker&) = delete;
+	AllocTracker& operator=(const AllocTracker&) = delete;
 
 	void Track(void* ptr, uint64 size, const char* file, const char* function, uint32 line);
 	void Modify(void* ptr, void* newPtr, uint64 size, const char* file, const char* function, uint32 line);
 	void Remove(void* ptr);
 
+	// Gathers a snapshot of all entries, valid until the next call to GetEntries() or Clear()
 	const Entry* GetEntries();
 	uint32 GetEntryCount();
 	void Clear();
 
+	static constexpr uint32 SHARD_COUNT_LOG2 = 6;
+	static constexpr uint32 SHARD_COUNT = 1 << SHARD_COUNT_LOG2;
+
 protected:
-	uint32 FindAlloc(const void* ptr);
+	// Linear probing table stored as separate arrays so that probing only touches the pointers
+	struct alignas(CACHE_LINE_SIZE) Shard
+	{
+		std::mutex lock;
+		void** ptrs;
+		const char** files;
+		const char** functions;
+		uint64* sizes;
+		uint32* lines;
+		uint32 count;
+		uint32 capacityLog2;
+	};
+
+	static uint64 Hash(const void* ptr);
+	Shard& GetShard(uint64 hash);
+
+	static void Insert(Shard& shard, uint64 hash, void* ptr, uint64 size, const char* file, const char* function, uint32 line);
+	static uint32 FindSlot(const Shard& shard, uint64 hash, const void* ptr);
+	static void RemoveSlot(Shard& shard, uint32 slot);
+	static void Grow(Shard& shard);
+	static void FreeShard(Shard& shard);
+
+	static constexpr uint32 START_CAPACITY_LOG2 = 4;
+	static constexpr uint32 NOT_FOUND = ~0u;
 
-	const uint32 START_CAPACITY = 16;
+	Shard shards[SHARD_COUNT];
 
-	std::mutex lock;
-	Entry* entries;
-	uint32 length;
-	uint32 capacity;
+	Entry* snapshot;
+	uint32 snapshotCapacity;
 };
 }
 #endif
@@ -0,0 +1,425 @@
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include "ArraySearch.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DL_ARRAY_SEARCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only allow intrinsics of instruction sets enabled for the function, so the kernels of each instruction
+// set are compiled with it enabled while the rest of the library keeps the baseline target. MSVC allows them anywhere.
+#define DL_PRAGMA(x) _Pragma(#x)
+#if defined(__clang__)
+#define DL_BEGIN_TARGET(isa) DL_PRAGMA(clang attribute push (__attribute__((target(isa))), apply_to = function))
+#define DL_END_TARGET DL_PRAGMA(clang attribute pop)
+#elif defined(__GNUC__)
+#define DL_BEGIN_TARGET(isa) DL_PRAGMA(GCC push_options) DL_PRAGMA(GCC target(isa))
+#define DL_END_TARGET DL_PRAGMA(GCC pop_options)
+#else
+#define DL_BEGIN_TARGET(isa)
+#define DL_END_TARGET
+#endif
+
+namespace ducklib
+{
+namespace Internal::Memory
+{
+namespace
+{
+ArraySimdLevel DetectArraySimdLevel()
+{
+#if defined(DL_ARRAY_SEARCH_X86) && defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse42 = (info[2] & (1 << 20)) && (info[2] & (1 << 23));
+	// The OS has to save the AVX registers on context switches too
+	bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+	bool avx2 = false;
+
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = osAvx && (info[1] & (1 << 5));
+	}
+#elif defined(DL_ARRAY_SEARCH_X86)
+	__builtin_cpu_init();
+	bool sse42 = __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+	bool avx2 = __builtin_cpu_supports("avx2");
+#else
+	bool sse42 = false;
+	bool avx2 = false;
+#endif
+
+	if (sse42 && avx2)
+		return ArraySimdLevel::AVX2;
+
+	return sse42 ? ArraySimdLevel::SSE42 : ArraySimdLevel::SCALAR;
+}
+
+const ArraySimdLevel supportedLevel = DetectArraySimdLevel();
+// Zero initialized to scalar until dynamic initialization, in case arrays are searched by other static initializers
+std::atomic<ArraySimdLevel> currentLevel = supportedLevel;
+
+template <typename T, typename V>
+T BitCast(V value)
+{
+	T result;
+
+	memcpy(&result, &value, sizeof(T));
+
+	return result;
+}
+
+namespace Scalar
+{
+template <typename T>
+uint32 Find(const T* items, uint32 count, T value)
+{
+	for (uint32 i = 0; i < count; ++i)
+	{
+		if (items[i] == value)
+			return i;
+	}
+
+	return count;
+}
+
+template <typename T>
+uint32 Count(const T* items, uint32 count, T value)
+{
+	uint32 matchCount = 0;
+
+	for (uint32 i = 0; i < count; ++i)
+		matchCount += items[i] == value;
+
+	return matchCount;
+}
+
+template <typename T>
+void Fill(T* items, uint32 count, T value)
+{
+	for (uint32 i = 0; i < count; ++i)
+		items[i] = value;
+}
+
+template <typename T>
+void MinMax(const T* items, uint32 count, T& min, T& max)
+{
+	min = items[0];
+	max = items[0];
+
+	for (uint32 i = 1; i < count; ++i)
+	{
+		min = items[i] < min ? items[i] : min;
+		max = max < items[i] ? items[i] : max;
+	}
+}
+}
+
+#ifdef DL_ARRAY_SEARCH_X86
+DL_BEGIN_TARGET("sse4.2,popcnt")
+namespace Sse42
+{
+struct Ops
+{
+	// Floating point values are kept in integer vectors too and only reinterpreted for comparisons
+	using Vec = __m128i;
+
+	static constexpr uint32 WIDTH = 16;
+
+	static Vec Load(const void* ptr) { return _mm_loadu_si128((const __m128i*)ptr); }
+	static void Store(void* ptr, Vec v) { _mm_storeu_si128((__m128i*)ptr, v); }
+	static Vec Or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+	static uint32 MoveMask(Vec v) { return (uint32)_mm_movemask_epi8(v); }
+
+	template <typename T>
+	static Vec Set1(T value)
+	{
+		if constexpr (sizeof(T) == 1)
+			return _mm_set1_epi8(BitCast<char>(value));
+		else if constexpr (sizeof(T) == 2)
+			return _mm_set1_epi16(BitCast<short>(value));
+		else if constexpr (sizeof(T) == 4)
+			return _mm_set1_epi32(BitCast<int>(value));
+		else
+			return _mm_set1_epi64x(BitCast<long long>(value));
+	}
+
+	template <typename T>
+	static Vec Equal(Vec a, Vec b)
+	{
+		if constexpr (std::is_same_v<T, float>)
+			return _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+		else if constexpr (std::is_same_v<T, double>)
+			return _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b)));
+		else if constexpr (sizeof(T) == 1)
+			return _mm_cmpeq_epi8(a, b);
+		else if constexpr (sizeof(T) == 2)
+			return _mm_cmpeq_epi16(a, b);
+		else if constexpr (sizeof(T) == 4)
+			return _mm_cmpeq_epi32(a, b);
+		else
+			return _mm_cmpeq_epi64(a, b);
+	}
+
+	// Lanes where a > b. There is no unsigned 64-bit compare, so unsigned values are flipped into signed order.
+	template <typename T>
+	static Vec Greater64(Vec a, Vec b)
+	{
+		if constexpr (std::is_signed_v<T>)
+			return _mm_cmpgt_epi64(a, b);
+		else
+		{
+			Vec signBit = _mm_set1_epi64x(INT64_MIN);
+
+			return _mm_cmpgt_epi64(_mm_xor_si128(a, signBit), _mm_xor_si128(b, signBit));
+		}
+	}
+
+	template <typename T>
+	static Vec Min(Vec a, Vec b)
+	{
+		if constexpr (std::is_same_v<T, float>)
+			return _mm_castps_si128(_mm_min_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+		else if constexpr (std::is_same_v<T, double>)
+			return _mm_castpd_si128(_mm_min_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b)));
+		else if constexpr (sizeof(T) == 1)
+			return std::is_signed_v<T> ? _mm_min_epi8(a, b) : _mm_min_epu8(a, b);
+		else if constexpr (sizeof(T) == 2)
+			return std::is_signed_v<T> ? _mm_min_epi16(a, b) : _mm_min_epu16(a, b);
+		else if constexpr (sizeof(T) == 4)
+			return std::is_signed_v<T> ? _mm_min_epi32(a, b) : _mm_min_epu32(a, b);
+		else
+			return _mm_blendv_epi8(a, b, Greater64<T>(a, b));
+	}
+
+	template <typename T>
+	static Vec Max(Vec a, Vec b)
+	{
+		if constexpr (std::is_same_v<T, float>)
+			return _mm_castps_si128(_mm_max_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+		else if constexpr (std::is_same_v<T, double>)
+			return _mm_castpd_si128(_mm_max_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b)));
+		else if constexpr (sizeof(T) == 1)
+			return std::is_signed_v<T> ? _mm_max_epi8(a, b) : _mm_max_epu8(a, b);
+		else if constexpr (sizeof(T) == 2)
+			return std::is_signed_v<T> ? _mm_max_epi16(a, b) : _mm_max_epu16(a, b);
+		else if constexpr (sizeof(T) == 4)
+			return std::is_signed_v<T> ? _mm_max_epi32(a, b) : _mm_max_epu32(a, b);
+		else
+			return _mm_blendv_epi8(b, a, Greater64<T>(a, b));
+	}
+};
+
+#include "ArraySearchKernels.inl"
+}
+DL_END_TARGET
+
+DL_BEGIN_TARGET("avx2,popcnt")
+namespace Avx2
+{
+struct Ops
+{
+	using Vec = __m256i;
+
+	static constexpr uint32 WIDTH = 32;
+
+	static Vec Load(const void* ptr) { return _mm256_loadu_si256((const __m256i*)ptr); }
+	static void Store(void* ptr, Vec v) { _mm256_storeu_si256((__m256i*)ptr, v); }
+	static Vec Or(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+	static uint32 MoveMask(Vec v) { return (uint32)_mm256_movemask_epi8(v); }
+
+	template <typename T>
+	static Vec Set1(T value)
+	{
+		if constexpr (sizeof(T) == 1)
+			return _mm256_set1_epi8(BitCast<char>(value));
+		else if constexpr (sizeof(T) == 2)
+			return _mm256_set1_epi16(BitCast<short>(value));
+		else if constexpr (sizeof(T) == 4)
+			return _mm256_set1_epi32(BitCast<int>(value));
+		else
+			return _mm256_set1_epi64x(BitCast<long long>(value));
+	}
+
+	template <typename T>
+	static Vec Equal(Vec a, Vec b)
+	{
+		if constexpr (std::is_same_v<T, float>)
+			return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ));
+		else if constexpr (std::is_same_v<T, double>)
+			return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_OQ));
+		else if constexpr (sizeof(T) == 1)
+			return _mm256_cmpeq_epi8(a, b);
+		else if constexpr (sizeof(T) == 2)
+			return _mm256_cmpeq_epi16(a, b);
+		else if constexpr (sizeof(T) == 4)
+			return _mm256_cmpeq_epi32(a, b);
+		else
+			return _mm256_cmpeq_epi64(a, b);
+	}
+
+	template <typename T>
+	static Vec Greater64(Vec a, Vec b)
+	{
+		if constexpr (std::is_signed_v<T>)
+			return _mm256_cmpgt_epi64(a, b);
+		else
+		{
+			Vec signBit = _mm256_set1_epi64x(INT64_MIN);
+
+			return _mm256_cmpgt_epi64(_mm256_xor_si256(a, signBit), _mm256_xor_si256(b, signBit));
+		}
+	}
+
+	template <typename T>
+	static Vec Min(Vec a, Vec b)
+	{
+		if constexpr (std::is_same_v<T, float>)
+			return _mm256_castps_si256(_mm256_min_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+		else if constexpr (std::is_same_v<T, double>)
+			return _mm256_castpd_si256(_mm256_min_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b)));
+		else if constexpr (sizeof(T) == 1)
+			return std::is_signed_v<T> ? _mm256_min_epi8(a, b) : _mm256_min_epu8(a, b);
+		else if constexpr (sizeof(T) == 2)
+			return std::is_signed_v<T> ? _mm256_min_epi16(a, b) : _mm256_min_epu16(a, b);
+		else if constexpr (sizeof(T) == 4)
+			return std::is_signed_v<T> ? _mm256_min_epi32(a, b) : _mm256_min_epu32(a, b);
+		else
+			return _mm256_blendv_epi8(a, b, Greater64<T>(a, b));
+	}
+
+	template <typename T>
+	static Vec Max(Vec a, Vec b)
+	{
+		if constexpr (std::is_same_v<T, float>)
+			return _mm256_castps_si256(_mm256_max_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+		else if constexpr (std::is_same_v<T, double>)
+			return _mm256_castpd_si256(_mm256_max_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b)));
+		else if constexpr (sizeof(T) == 1)
+			return std::is_signed_v<T> ? _mm256_max_epi8(a, b) : _mm256_max_epu8(a, b);
+		else if constexpr (sizeof(T) == 2)
+			return std::is_signed_v<T> ? _mm256_max_epi16(a, b) : _mm256_max_epu16(a, b);
+		else if constexpr (sizeof(T) == 4)
+			return std::is_signed_v<T> ? _mm256_max_epi32(a, b) : _mm256_max_epu32(a, b);
+		else
+			return _mm256_blendv_epi8(b, a, Greater64<T>(a, b));
+	}
+};
+
+#include "ArraySearchKernels.inl"
+}
+DL_END_TARGET
+#endif
+}
+
+template <typename T>
+uint32 SimdFind(const T* items, uint32 count, T value)
+{
+	switch (currentLevel.load(std::memory_order_relaxed))
+	{
+#ifdef DL_ARRAY_SEARCH_X86
+	case ArraySimdLevel::AVX2:
+		return Avx2::Find(items, count, value);
+	case ArraySimdLevel::SSE42:
+		return Sse42::Find(items, count, value);
+#endif
+	default:
+		return Scalar::Find(items, count, value);
+	}
+}
+
+template <typename T>
+uint32 SimdCount(const T* items, uint32 count, T value)
+{
+	switch (currentLevel.load(std::memory_order_relaxed))
+	{
+#ifdef DL_ARRAY_SEARCH_X86
+	case ArraySimdLevel::AVX2:
+		return Avx2::Count(items, count, value);
+	case ArraySimdLevel::SSE42:
+		return Sse42::Count(items, count, value);
+#endif
+	default:
+		return Scalar::Count(items, count, value);
+	}
+}
+
+template <typename T>
+void SimdFill(T* items, uint32 count, T value)
+{
+	switch (currentLevel.load(std::memory_order_relaxed))
+	{
+#ifdef DL_ARRAY_SEARCH_X86
+	case ArraySimdLevel::AVX2:
+		return Avx2::Fill(items, count, value);
+	case ArraySimdLevel::SSE42:
+		return Sse42::Fill(items, count, value);
+#endif
+	default:
+		return Scalar::Fill(items, count, value);
+	}
+}
+
+template <typename T>
+void SimdMinMax(const T* items, uint32 count, T& min, T& max)
+{
+	switch (currentLevel.load(std::memory_order_relaxed))
+	{
+#ifdef DL_ARRAY_SEARCH_X86
+	case ArraySimdLevel::AVX2:
+		return Avx2::MinMax(items, count, min, max);
+	case ArraySimdLevel::SSE42:
+		return Sse42::MinMax(items, count, min, max);
+#endif
+	default:
+		return Scalar::MinMax(items, count, min, max);
+	}
+}
+
+#define DL_INSTANTIATE_ARRAY_SEARCH(T) \
+	template uint32 SimdFind<T>(const T*, uint32, T); \
+	template uint32 SimdCount<T>(const T*, uint32, T); \
+	template void SimdFill<T>(T*, uint32, T); \
+	template void SimdMinMax<T>(const T*, uint32, T&, T&);
+
+DL_INSTANTIATE_ARRAY_SEARCH(int8)
+DL_INSTANTIATE_ARRAY_SEARCH(uint8)
+DL_INSTANTIATE_ARRAY_SEARCH(int16)
+DL_INSTANTIATE_ARRAY_SEARCH(uint16)
+DL_INSTANTIATE_ARRAY_SEARCH(int32)
+DL_INSTANTIATE_ARRAY_SEARCH(uint32)
+DL_INSTANTIATE_ARRAY_SEARCH(int64)
+DL_INSTANTIATE_ARRAY_SEARCH(uint64)
+DL_INSTANTIATE_ARRAY_SEARCH(float)
+DL_INSTANTIATE_ARRAY_SEARCH(double)
+
+#undef DL_INSTANTIATE_ARRAY_SEARCH
+}
+
+ArraySimdLevel GetSupportedArraySimdLevel()
+{
+	return Internal::Memory::supportedLevel;
+}
+
+ArraySimdLevel GetArraySimdLevel()
+{
+	return Internal::Memory::currentLevel.load(std::memory_order_relaxed);
+}
+
+void SetArraySimdLevel(ArraySimdLevel level)
+{
+	ArraySimdLevel supportedLevel = Internal::Memory::supportedLevel;
+
+	Internal::Memory::currentLevel.store(level > supportedLevel ? supportedLevel : level, std::memory_order_relaxed);
+}
+}
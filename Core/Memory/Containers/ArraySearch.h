@@ -0,0 +1,145 @@
+#pragma once
+#include <type_traits>
+#include "../../Types.h"
+
+namespace ducklib
+{
+enum class ArraySimdLevel : uint8
+{
+	SCALAR,
+	SSE42,
+	AVX2,
+};
+
+// Highest level supported by the CPU, which is what's used unless overridden
+ArraySimdLevel GetSupportedArraySimdLevel();
+ArraySimdLevel GetArraySimdLevel();
+
+// For comparing the kernels, e.g. in benchmarks. Levels above the supported one are clamped to it.
+void SetArraySimdLevel(ArraySimdLevel level);
+
+namespace Internal::Memory
+{
+// Arithmetic and pointer types are searched with SIMD kernels, everything else with plain loops
+template <typename T>
+constexpr bool IS_SIMD_ELEMENT = (std::is_arithmetic_v<T> && sizeof(T) <= 8 && !std::is_same_v<T, long double>)
+	|| std::is_pointer_v<T>;
+
+template <typename T>
+struct SimdElementSelector
+{
+	using Type = std::conditional_t<
+		std::is_floating_point_v<T>,
+		T,
+		std::conditional_t<
+			sizeof(T) == 1,
+			std::conditional_t<std::is_signed_v<T>, int8, uint8>,
+			std::conditional_t<
+				sizeof(T) == 2,
+				std::conditional_t<std::is_signed_v<T>, int16, uint16>,
+				std::conditional_t<
+					sizeof(T) == 4,
+					std::conditional_t<std::is_signed_v<T>, int32, uint32>,
+					std::conditional_t<std::is_signed_v<T>, int64, uint64>>>>>;
+};
+
+template <typename T>
+struct SimdElementSelector<T*>
+{
+	using Type = std::conditional_t<sizeof(T*) == 8, uint64, uint32>;
+};
+
+// Fixed size type with the same representation and ordering that the kernels are instantiated for
+template <typename T>
+using SimdElement = typename SimdElementSelector<std::remove_cv_t<T>>::Type;
+
+// Return count if the value isn't found
+template <typename T>
+uint32 SimdFind(const T* items, uint32 count, T value);
+template <typename T>
+uint32 SimdCount(const T* items, uint32 count, T value);
+template <typename T>
+void SimdFill(T* items, uint32 count, T value);
+
+// Only for non-empty ranges. Results are unspecified if floating point items contain NaNs.
+template <typename T>
+void SimdMinMax(const T* items, uint32 count, T& min, T& max);
+
+template <typename T>
+uint32 FindElement(const T* items, uint32 count, const T& value)
+{
+	if constexpr (IS_SIMD_ELEMENT<T>)
+	{
+		using E = SimdElement<T>;
+
+		return SimdFind((const E*)items, count, (E)(std::conditional_t<std::is_pointer_v<T>, uintptr_t, T>)value);
+	}
+	else
+	{
+		for (uint32 i = 0; i < count; ++i)
+		{
+			if (items[i] == value)
+				return i;
+		}
+
+		return count;
+	}
+}
+
+template <typename T>
+uint32 CountElement(const T* items, uint32 count, const T& value)
+{
+	if constexpr (IS_SIMD_ELEMENT<T>)
+	{
+		using E = SimdElement<T>;
+
+		return SimdCount((const E*)items, count, (E)(std::conditional_t<std::is_pointer_v<T>, uintptr_t, T>)value);
+	}
+	else
+	{
+		uint32 matchCount = 0;
+
+		for (uint32 i = 0; i < count; ++i)
+			matchCount += items[i] == value;
+
+		return matchCount;
+	}
+}
+
+template <typename T>
+void FillElements(T* items, uint32 count, const T& value)
+{
+	if constexpr (IS_SIMD_ELEMENT<T>)
+	{
+		using E = SimdElement<T>;
+
+		SimdFill((E*)items, count, (E)(std::conditional_t<std::is_pointer_v<T>, uintptr_t, T>)value);
+	}
+	else
+	{
+		for (uint32 i = 0; i < count; ++i)
+			items[i] = value;
+	}
+}
+
+template <typename T>
+void MinMaxElements(const T* items, uint32 count, T& min, T& max)
+{
+	static_assert(std::is_arithmetic_v<T>, "MinMax is only for arithmetic types");
+
+	if constexpr (IS_SIMD_ELEMENT<T>)
+		SimdMinMax((const SimdElement<T>*)items, count, (SimdElement<T>&)min, (SimdElement<T>&)max);
+	else
+	{
+		min = items[0];
+		max = items[0];
+
+		for (uint32 i = 1; i < count; ++i)
+		{
+			min = items[i] < min ? items[i] : min;
+			max = max < items[i] ? items[i] : max;
+		}
+	}
+}
+}
+}
@@ -0,0 +1,121 @@
+// Generic search kernels, included once per instruction set with Ops set to that instruction set's operations
+
+template <typename T>
+uint32 Find(const T* items, uint32 count, T value)
+{
+	constexpr uint32 lanes = Ops::WIDTH / sizeof(T);
+	typename Ops::Vec needle = Ops::Set1(value);
+	uint32 i = 0;
+
+	// Four vectors per iteration keep more loads in flight and test them with a single branch
+	for (; i + 4 * lanes <= count; i += 4 * lanes)
+	{
+		typename Ops::Vec equal0 = Ops::template Equal<T>(Ops::Load(items + i), needle);
+		typename Ops::Vec equal1 = Ops::template Equal<T>(Ops::Load(items + i + lanes), needle);
+		typename Ops::Vec equal2 = Ops::template Equal<T>(Ops::Load(items + i + 2 * lanes), needle);
+		typename Ops::Vec equal3 = Ops::template Equal<T>(Ops::Load(items + i + 3 * lanes), needle);
+
+		if (Ops::MoveMask(Ops::Or(Ops::Or(equal0, equal1), Ops::Or(equal2, equal3))) == 0)
+			continue;
+
+		typename Ops::Vec equals[4] = { equal0, equal1, equal2, equal3 };
+
+		for (uint32 u = 0; u < 4; ++u)
+		{
+			uint32 mask = Ops::MoveMask(equals[u]);
+
+			if (mask != 0)
+				return i + u * lanes + (uint32)std::countr_zero(mask) / sizeof(T);
+		}
+	}
+
+	for (; i + lanes <= count; i += lanes)
+	{
+		uint32 mask = Ops::MoveMask(Ops::template Equal<T>(Ops::Load(items + i), needle));
+
+		if (mask != 0)
+			return i + (uint32)std::countr_zero(mask) / sizeof(T);
+	}
+
+	for (; i < count; ++i)
+	{
+		if (items[i] == value)
+			return i;
+	}
+
+	return count;
+}
+
+template <typename T>
+uint32 Count(const T* items, uint32 count, T value)
+{
+	constexpr uint32 lanes = Ops::WIDTH / sizeof(T);
+	typename Ops::Vec needle = Ops::Set1(value);
+	uint32 matchingBytes = 0;
+	uint32 matchCount = 0;
+	uint32 i = 0;
+
+	// Each matching element sets sizeof(T) bits of the mask
+	for (; i + lanes <= count; i += lanes)
+		matchingBytes += (uint32)std::popcount(Ops::MoveMask(Ops::template Equal<T>(Ops::Load(items + i), needle)));
+
+	for (; i < count; ++i)
+		matchCount += items[i] == value;
+
+	return matchCount + matchingBytes / sizeof(T);
+}
+
+template <typename T>
+void Fill(T* items, uint32 count, T value)
+{
+	constexpr uint32 lanes = Ops::WIDTH / sizeof(T);
+	typename Ops::Vec values = Ops::Set1(value);
+	uint32 i = 0;
+
+	for (; i + lanes <= count; i += lanes)
+		Ops::Store(items + i, values);
+
+	for (; i < count; ++i)
+		items[i] = value;
+}
+
+template <typename T>
+void MinMax(const T* items, uint32 count, T& min, T& max)
+{
+	constexpr uint32 lanes = Ops::WIDTH / sizeof(T);
+	uint32 i = 0;
+
+	min = items[0];
+	max = items[0];
+
+	if (count >= lanes)
+	{
+		typename Ops::Vec minValues = Ops::Load(items);
+		typename Ops::Vec maxValues = minValues;
+		T laneValues[lanes];
+
+		for (i = lanes; i + lanes <= count; i += lanes)
+		{
+			typename Ops::Vec values = Ops::Load(items + i);
+
+			minValues = Ops::template Min<T>(minValues, values);
+			maxValues = Ops::template Max<T>(maxValues, values);
+		}
+
+		Ops::Store(laneValues, minValues);
+
+		for (uint32 u = 0; u < lanes; ++u)
+			min = laneValues[u] < min ? laneValues[u] : min;
+
+		Ops::Store(laneValues, maxValues);
+
+		for (uint32 u = 0; u < lanes; ++u)
+			max = max < laneValues[u] ? laneValues[u] : max;
+	}
+
+	for (; i < count; ++i)
+	{
+		min = items[i] < min ? items[i] : min;
+		max = max < items[i] ? items[i] : max;
+	}
+}
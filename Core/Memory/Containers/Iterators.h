@@ -1,59 +1,136 @@
 #pragma once
-
-#include "TArray.h"
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
 
 namespace ducklib
 {
+/**
+ * Contiguous iterator over TArray elements, usable with std algorithms and their parallel execution policies. T is
+ * const for const iterators, which non-const iterators convert to.
+ */
 template <typename T>
 class TArrayIt
 {
 public:
+	using iterator_category = std::random_access_iterator_tag;
+	using iterator_concept = std::contiguous_iterator_tag;
+	using value_type = std::remove_cv_t<T>;
+	using difference_type = std::ptrdiff_t;
+	using pointer = T*;
+	using reference = T&;
+
+	TArrayIt();
 	TArrayIt(T* it);
 
-	T& operator*();
-	bool operator!=(const TArrayIt& o);
-	void operator++();
+	template <typename U, std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>, int> = 0>
+	TArrayIt(const TArrayIt<U>& other);
+
+	T& operator*() const;
+	T* operator->() const;
+	T& operator[](difference_type n) const;
+
+	TArrayIt& operator++();
+	TArrayIt operator++(int);
+	TArrayIt& operator--();
+	TArrayIt operator--(int);
+	TArrayIt& operator+=(difference_type n);
+	TArrayIt& operator-=(difference_type n);
+
+	friend TArrayIt operator+(TArrayIt it, difference_type n) { return it += n; }
+	friend TArrayIt operator+(difference_type n, TArrayIt it) { return it += n; }
+	friend TArrayIt operator-(TArrayIt it, difference_type n) { return it -= n; }
+	friend difference_type operator-(const TArrayIt& a, const TArrayIt& b) { return a.it - b.it; }
+
+	friend bool operator==(const TArrayIt& a, const TArrayIt& b) = default;
+	friend auto operator<=>(const TArrayIt& a, const TArrayIt& b) = default;
 
 private:
+	template <typename U>
+	friend class TArrayIt;
+
 	T* it;
 };
 
+template <typename T>
+TArrayIt<T>::TArrayIt()
+	: it(nullptr) {}
+
 template <typename T>
 TArrayIt<T>::TArrayIt(T* it)
+	: it(it) {}
+
+template <typename T>
+template <typename U, std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>, int>>
+TArrayIt<T>::TArrayIt(const TArrayIt<U>& other)
+	: it(other.it) {}
+
+template <typename T>
+T& TArrayIt<T>::operator*() const
 {
-	this->it = it;
+	return *it;
 }
 
 template <typename T>
-T& TArrayIt<T>::operator*()
+T* TArrayIt<T>::operator->() const
 {
-	return *it;
+	return it;
 }
 
 template <typename T>
-bool TArrayIt<T>::operator!=(const TArrayIt& o)
+T& TArrayIt<T>::operator[](difference_type n) const
 {
-	return it != o.it;
+	return it[n];
 }
 
 template <typename T>
-void TArrayIt<T>::operator++()
+TArrayIt<T>& TArrayIt<T>::operator++()
 {
 	++it;
+
+	return *this;
 }
 
 template <typename T>
-TArrayIt<T> begin(TArray<T>& array)
+TArrayIt<T> TArrayIt<T>::operator++(int)
 {
-	return TArrayIt(array.Data());
+	TArrayIt previous = *this;
+	++it;
+
+	return previous;
+}
+
+template <typename T>
+TArrayIt<T>& TArrayIt<T>::operator--()
+{
+	--it;
+
+	return *this;
+}
+
+template <typename T>
+TArrayIt<T> TArrayIt<T>::operator--(int)
+{
+	TArrayIt previous = *this;
+	--it;
+
+	return previous;
+}
+
+template <typename T>
+TArrayIt<T>& TArrayIt<T>::operator+=(difference_type n)
+{
+	it += n;
+
+	return *this;
 }
 
 template <typename T>
-TArrayIt<T> end(TArray<T>& array)
+TArrayIt<T>& TArrayIt<T>::operator-=(difference_type n)
 {
-	T* dataPtr = array.Data();
-	T* itPtr = dataPtr != nullptr ? &dataPtr[array.Length() - 1] : nullptr;
+	it -= n;
 
-	return TArrayIt(itPtr);
+	return *this;
 }
 }
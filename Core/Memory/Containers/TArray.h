@@ -1,24 +1,116 @@
 #pragma once
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "ArraySearch.h"
+#include "Iterators.h"
 #include "../IAllocator.h"
 
 namespace ducklib
 {
+/**
+ * Types that can be moved to a new address with memcpy, without running constructors or destructors. Arrays of these
+ * grow with Reallocate, everything else is move constructed into the new memory. Specialize for types that are
+ * relocatable without being trivially copyable.
+ */
+template <typename T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+namespace Internal::Memory
+{
+template <typename T>
+void CopyConstructElements(T* dest, const T* source, uint32 count)
+{
+	if constexpr (std::is_trivially_copyable_v<T>)
+	{
+		if (count > 0)
+			memcpy(dest, source, count * sizeof(T));
+	}
+	else
+	{
+		for (uint32 i = 0; i < count; ++i)
+			new (&dest[i]) T(source[i]);
+	}
+}
+
+template <typename T>
+void DefaultConstructElements(T* dest, uint32 count)
+{
+	if constexpr (!std::is_trivially_default_constructible_v<T>)
+	{
+		for (uint32 i = 0; i < count; ++i)
+			new (&dest[i]) T;
+	}
+}
+
+template <typename T>
+void DestroyElements(T* elements, uint32 count)
+{
+	if constexpr (!std::is_trivially_destructible_v<T>)
+	{
+		for (uint32 i = 0; i < count; ++i)
+			elements[i].~T();
+	}
+}
+
+// Moves the elements to dest and ends their lifetime at source
+template <typename T>
+void RelocateElements(T* dest, T* source, uint32 count)
+{
+	if constexpr (IsTriviallyRelocatable<T>::value)
+	{
+		if (count > 0)
+			memcpy((void*)dest, (const void*)source, count * sizeof(T));
+	}
+	else
+	{
+		for (uint32 i = 0; i < count; ++i)
+		{
+			new (&dest[i]) T(std::move(source[i]));
+			source[i].~T();
+		}
+	}
+}
+}
+
 template <typename T>
 class TArray
 {
 public:
 	TArray();
+	explicit TArray(IAllocator* alloc);
 	TArray(uint32 initialCapacity);
+	TArray(uint32 initialCapacity, IAllocator* alloc);
 	TArray(const T* other, uint32 otherLength);
 	TArray(const T* other, uint32 otherLength, uint32 startCapacity);
+	TArray(const T* other, uint32 otherLength, uint32 startCapacity, IAllocator* alloc);
 	TArray(const TArray& other);
-	TArray(TArray&& other) noexcept;
+	// Not noexcept, moving from a TInlineArray that hasn't spilled yet has to allocate
+	TArray(TArray&& other);
 	~TArray();
 
 	void Append(T&& item);
 	void Append(const T& item);
 
+	template <typename... Args>
+	T& EmplaceBack(Args&&... args);
+
+	// Reserves space once and copies all the items, which must not be in the array itself
+	void AppendRange(const T* items, uint32 count);
+
+	// Destroys the last item, unlike Resize this works for types without a default constructor
+	void RemoveLast();
+
+	// Arithmetic and pointer elements are searched with the SIMD kernels in ArraySearch.h
 	bool Contains(const T& item) const;
+	// Index of the first matching item or NOT_FOUND
+	uint32 Find(const T& item) const;
+	uint32 Count(const T& item) const;
+	void Fill(const T& item);
+
+	// Only for arithmetic types. Returns false for empty arrays.
+	bool MinMax(T& min, T& max) const;
 
 	uint32 Length() const;
 	uint32 Capacity() const;
@@ -34,10 +126,23 @@ public:
 	T* Data();
 	const T* Data() const;
 
+	using Iterator = TArrayIt<T>;
+	using ConstIterator = TArrayIt<const T>;
+
+	Iterator begin();
+	Iterator end();
+	ConstIterator begin() const;
+	ConstIterator end() const;
+
 	static TArray Attach(T* externalArray, uint32 size, IAllocator* alloc = nullptr);
 	static TArray Attach(T* externalArray, uint32 size, uint32 capacity, IAllocator* alloc = nullptr);
 
+	static constexpr uint32 NOT_FOUND = ~0u;
+
 protected:
+	// For derived arrays with inline storage, which is used until it runs out
+	TArray(T* inlineArray, uint32 inlineCapacity, IAllocator* alloc);
+
 	bool EnsureCapacity(uint32 requiredCapacity);
 	void Destroy();
 
@@ -46,6 +151,7 @@ protected:
 	uint32 length;
 	uint32 capacity;
 	bool isExternalArray;
+	bool isInlineArray;
 };
 
 template <typename T>
@@ -54,11 +160,23 @@ TArray<T>::TArray()
 	, array(nullptr)
 	, length(0)
 	, capacity(0)
-	, isExternalArray(false) {}
+	, isExternalArray(false)
+	, isInlineArray(false) {}
 
 template <typename T>
-TArray<T>::TArray(uint32 initialCapacity)
+TArray<T>::TArray(IAllocator* alloc)
 	: TArray()
+{
+	this->alloc = alloc;
+}
+
+template <typename T>
+TArray<T>::TArray(uint32 initialCapacity)
+	: TArray(initialCapacity, DefAlloc()) {}
+
+template <typename T>
+TArray<T>::TArray(uint32 initialCapacity, IAllocator* alloc)
+	: TArray(alloc)
 {
 	EnsureCapacity(initialCapacity);
 }
@@ -69,15 +187,32 @@ TArray<T>::TArray(const T* other, uint32 otherLength)
 
 template <typename T>
 TArray<T>::TArray(const T* other, uint32 otherLength, uint32 startCapacity)
-	: TArray()
+	: TArray(other, otherLength, startCapacity, DefAlloc()) {}
+
+// Without other, the elements are default initialized
+template <typename T>
+TArray<T>::TArray(const T* other, uint32 otherLength, uint32 startCapacity, IAllocator* alloc)
+	: TArray(alloc)
 {
-	EnsureCapacity(startCapacity);
-	length = otherLength;
+	EnsureCapacity(startCapacity > otherLength ? startCapacity : otherLength);
 
 	if (other)
-		memcpy(array, other, sizeof(T) * otherLength);
+		Internal::Memory::CopyConstructElements(array, other, otherLength);
+	else
+		Internal::Memory::DefaultConstructElements(array, otherLength);
+
+	length = otherLength;
 }
 
+template <typename T>
+TArray<T>::TArray(T* inlineArray, uint32 inlineCapacity, IAllocator* alloc)
+	: alloc(alloc)
+	, array(inlineArray)
+	, length(0)
+	, capacity(inlineCapacity)
+	, isExternalArray(false)
+	, isInlineArray(true) {}
+
 template <typename T>
 TArray<T>::TArray(const TArray& other)
 	: TArray()
@@ -93,17 +228,31 @@ TArray<T>::TArray(const TArray& other)
 	else
 	{
 		EnsureCapacity(other.length);
+		Internal::Memory::CopyConstructElements(array, other.array, other.length);
 		length = other.length;
-		memcpy(array, other.array, sizeof(T) * other.length);
 		isExternalArray = false;
 	}
 }
 
 template <typename T>
-TArray<T>::TArray(TArray&& other) noexcept
+TArray<T>::TArray(TArray&& other)
 	: TArray()
 {
 	alloc = other.alloc;
+
+	// Inline storage can't be taken over
+	if (other.isInlineArray)
+	{
+		if (!EnsureCapacity(other.length))
+			throw std::runtime_error("Failed to move array because of limited capacity");
+
+		Internal::Memory::RelocateElements(array, other.array, other.length);
+		length = other.length;
+		other.length = 0;
+
+		return;
+	}
+
 	array = other.array;
 	length = other.length;
 	capacity = other.capacity;
@@ -125,29 +274,83 @@ TArray<T>::~TArray()
 template <typename T>
 void TArray<T>::Append(T&& item)
 {
+	EmplaceBack(std::move(item));
+}
+
+template <typename T>
+void TArray<T>::Append(const T& item)
+{
+	EmplaceBack(item);
+}
+
+template <typename T>
+template <typename... Args>
+T& TArray<T>::EmplaceBack(Args&&... args)
+{
+	if (length < capacity)
+		return *new (&array[length++]) T(std::forward<Args>(args)...);
+
+	// The arguments may refer to elements of the array, so they are used before growing moves them
+	T item(std::forward<Args>(args)...);
+
 	if (!EnsureCapacity(length + 1))
 		throw std::runtime_error("Failed to append in array because of limited capacity");
 
-	array[length++] = std::move(item);
+	return *new (&array[length++]) T(std::move(item));
 }
 
 template <typename T>
-void TArray<T>::Append(const T& item)
+void TArray<T>::AppendRange(const T* items, uint32 count)
 {
-	if (!EnsureCapacity(length + 1))
+	if (!EnsureCapacity(length + count))
 		throw std::runtime_error("Failed to append in array because of limited capacity");
 
-	array[length++] = item;
+	Internal::Memory::CopyConstructElements(array + length, items, count);
+	length += count;
+}
+
+template <typename T>
+void TArray<T>::RemoveLast()
+{
+	Internal::Memory::DestroyElements(array + length - 1, 1);
+	--length;
 }
 
 template <typename T>
 bool TArray<T>::Contains(const T& item) const
 {
-	for (uint32 i = 0; i < length; ++i)
-		if (array[i] == item)
-			return true;
+	return Find(item) != NOT_FOUND;
+}
+
+template <typename T>
+uint32 TArray<T>::Find(const T& item) const
+{
+	uint32 index = Internal::Memory::FindElement(array, length, item);
 
-	return false;
+	return index != length ? index : NOT_FOUND;
+}
+
+template <typename T>
+uint32 TArray<T>::Count(const T& item) const
+{
+	return Internal::Memory::CountElement(array, length, item);
+}
+
+template <typename T>
+void TArray<T>::Fill(const T& item)
+{
+	Internal::Memory::FillElements(array, length, item);
+}
+
+template <typename T>
+bool TArray<T>::MinMax(T& min, T& max) const
+{
+	if (length == 0)
+		return false;
+
+	Internal::Memory::MinMaxElements(array, length, min, max);
+
+	return true;
 }
 
 template <typename T>
@@ -168,10 +371,20 @@ bool TArray<T>::IsEmpty() const
 	return length == 0;
 }
 
+// New elements are default initialized, i.e. left uninitialized for trivial types
 template <typename T>
 void TArray<T>::Resize(uint32 newLength)
 {
-	EnsureCapacity(newLength);
+	if (newLength < length)
+		Internal::Memory::DestroyElements(array + newLength, length - newLength);
+	else
+	{
+		if (!EnsureCapacity(newLength))
+			throw std::runtime_error("Failed to resize array because of limited capacity");
+
+		Internal::Memory::DefaultConstructElements(array + length, newLength - length);
+	}
+
 	length = newLength;
 }
 
@@ -218,6 +431,30 @@ const T* TArray<T>::Data() const
 	return array;
 }
 
+template <typename T>
+typename TArray<T>::Iterator TArray<T>::begin()
+{
+	return Iterator(array);
+}
+
+template <typename T>
+typename TArray<T>::Iterator TArray<T>::end()
+{
+	return Iterator(array + length);
+}
+
+template <typename T>
+typename TArray<T>::ConstIterator TArray<T>::begin() const
+{
+	return ConstIterator(array);
+}
+
+template <typename T>
+typename TArray<T>::ConstIterator TArray<T>::end() const
+{
+	return ConstIterator(array + length);
+}
+
 template <typename T>
 TArray<T> TArray<T>::Attach(T* externalArray, uint32 size, IAllocator* alloc)
 {
@@ -230,7 +467,7 @@ TArray<T> TArray<T>::Attach(T* externalArray, uint32 size, uint32 capacity, IAll
 	TArray tarray;
 
 	tarray.alloc = alloc;
-	tarray.array = (uint32*)externalArray;
+	tarray.array = externalArray;
 	tarray.length = size;
 	tarray.capacity = capacity;
 	tarray.isExternalArray = true;
@@ -250,10 +487,20 @@ bool TArray<T>::EnsureCapacity(uint32 requiredCapacity)
 	uint32 exponentiallyIncreasedSize = (uint32)((float)(capacity == 0 ? 4 : capacity) * 1.5f);
 	uint32 newCapacity = requiredCapacity <= exponentiallyIncreasedSize ? exponentiallyIncreasedSize : requiredCapacity;
 
-	if (array)
-		array = (T*)alloc->Reallocate(array, newCapacity * sizeof(T));
+	if (array && !isInlineArray && IsTriviallyRelocatable<T>::value)
+		array = (T*)alloc->Reallocate(array, capacity * sizeof(T), newCapacity * sizeof(T), alignof(T));
 	else
-		array = (T*)alloc->Allocate(newCapacity * sizeof(T), alignof(T));
+	{
+		T* newArray = (T*)alloc->Allocate(newCapacity * sizeof(T), alignof(T));
+
+		Internal::Memory::RelocateElements(newArray, array, length);
+
+		if (array && !isInlineArray)
+			alloc->Free(array, capacity * sizeof(T));
+
+		array = newArray;
+		isInlineArray = false;
+	}
 
 	capacity = newCapacity;
 
@@ -266,7 +513,13 @@ void TArray<T>::Destroy()
 	if (isExternalArray)
 		return;
 
-	if (array)
-		alloc->Free(array);
+	Internal::Memory::DestroyElements(array, length);
+
+	if (array && !isInlineArray)
+		alloc->Free(array, capacity * sizeof(T));
 }
+
+// Never points at its own storage, so it can be moved with memcpy, e.g. when growing an array of arrays
+template <typename T>
+struct IsTriviallyRelocatable<TArray<T>> : std::true_type {};
 }
@@ -0,0 +1,125 @@
+#pragma once
+#include "TRingBuffer.h"
+
+namespace ducklib
+{
+/**
+ * TRingBuffer that doubles its capacity when full instead of rejecting pushes.
+ */
+template <typename T>
+class TDeque : public TRingBuffer<T>
+{
+public:
+	explicit TDeque(IAllocator* alloc = DefAlloc());
+	TDeque(uint32 initialCapacity, IAllocator* alloc = DefAlloc());
+
+	void PushBack(const T& item);
+	void PushBack(T&& item);
+	void PushFront(const T& item);
+	void PushFront(T&& item);
+
+	template <typename... Args>
+	T& EmplaceBack(Args&&... args);
+	template <typename... Args>
+	T& EmplaceFront(Args&&... args);
+
+	// Reserves space once and copies all the items, which must not be in the deque itself
+	void AppendRange(const T* items, uint32 count);
+
+	void Reserve(uint32 newCapacity);
+
+protected:
+	static constexpr uint32 MIN_CAPACITY = 8;
+
+	void Grow(uint32 requiredCapacity);
+};
+
+template <typename T>
+TDeque<T>::TDeque(IAllocator* alloc)
+	: TRingBuffer<T>(alloc) {}
+
+template <typename T>
+TDeque<T>::TDeque(uint32 initialCapacity, IAllocator* alloc)
+	: TRingBuffer<T>(initialCapacity, alloc) {}
+
+template <typename T>
+void TDeque<T>::PushBack(const T& item)
+{
+	EmplaceBack(item);
+}
+
+template <typename T>
+void TDeque<T>::PushBack(T&& item)
+{
+	EmplaceBack(std::move(item));
+}
+
+template <typename T>
+void TDeque<T>::PushFront(const T& item)
+{
+	EmplaceFront(item);
+}
+
+template <typename T>
+void TDeque<T>::PushFront(T&& item)
+{
+	EmplaceFront(std::move(item));
+}
+
+template <typename T>
+template <typename... Args>
+T& TDeque<T>::EmplaceBack(Args&&... args)
+{
+	if (this->IsFull())
+	{
+		// The arguments may refer to elements of the deque, so they are used before growing moves them
+		T item(std::forward<Args>(args)...);
+
+		Grow(this->length + 1);
+		this->ConstructBack(std::move(item));
+	}
+	else
+		this->ConstructBack(std::forward<Args>(args)...);
+
+	return this->Back();
+}
+
+template <typename T>
+template <typename... Args>
+T& TDeque<T>::EmplaceFront(Args&&... args)
+{
+	if (this->IsFull())
+	{
+		T item(std::forward<Args>(args)...);
+
+		Grow(this->length + 1);
+		this->ConstructFront(std::move(item));
+	}
+	else
+		this->ConstructFront(std::forward<Args>(args)...);
+
+	return this->Front();
+}
+
+template <typename T>
+void TDeque<T>::AppendRange(const T* items, uint32 count)
+{
+	Reserve(this->length + count);
+	this->PushBackRange(items, count);
+}
+
+template <typename T>
+void TDeque<T>::Reserve(uint32 newCapacity)
+{
+	if (newCapacity > this->capacity)
+		this->Reallocate(this->RoundUpToPowerOfTwo(newCapacity));
+}
+
+template <typename T>
+void TDeque<T>::Grow(uint32 requiredCapacity)
+{
+	uint32 newCapacity = this->capacity < MIN_CAPACITY ? MIN_CAPACITY : this->capacity * 2;
+
+	Reserve(newCapacity > requiredCapacity ? newCapacity : requiredCapacity);
+}
+}
@@ -0,0 +1,740 @@
+#pragma once
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "../IAllocator.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define DL_HASH_MAP_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DL_HASH_MAP_SSE2
+#endif
+
+namespace ducklib
+{
+namespace Internal::Memory
+{
+// Control bytes of full slots hold the 7 lowest bits of the hash
+enum HashControl : int8
+{
+	HASH_CONTROL_EMPTY = -128,
+	HASH_CONTROL_DELETED = -2,
+};
+
+// Positions of matching control bytes in a group
+class HashGroupMask
+{
+public:
+	HashGroupMask(uint64 mask, uint32 shift)
+		: mask(mask)
+		, shift(shift) {}
+
+	bool HasAny() const { return mask != 0; }
+	uint32 Lowest() const { return (uint32)std::countr_zero(mask) >> shift; }
+	void RemoveLowest() { mask &= mask - 1; }
+
+private:
+	uint64 mask;
+	uint32 shift;
+};
+
+/**
+ * Compares a whole group of control bytes at once, 32 with AVX2, 16 with SSE2 and 8 with portable 64-bit integer
+ * operations otherwise.
+ */
+class HashGroup
+{
+public:
+#if defined(DL_HASH_MAP_AVX2)
+	static constexpr uint32 WIDTH = 32;
+
+	explicit HashGroup(const int8* controls)
+		: controls(_mm256_load_si256((const __m256i*)controls)) {}
+
+	HashGroupMask Match(int8 h2) const
+	{
+		return { (uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(controls, _mm256_set1_epi8(h2))), 0 };
+	}
+
+	HashGroupMask MatchEmpty() const
+	{
+		return { (uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(controls, _mm256_set1_epi8(HASH_CONTROL_EMPTY))), 0 };
+	}
+
+	HashGroupMask MatchEmptyOrDeleted() const
+	{
+		return { (uint32)_mm256_movemask_epi8(controls), 0 };
+	}
+
+private:
+	__m256i controls;
+#elif defined(DL_HASH_MAP_SSE2)
+	static constexpr uint32 WIDTH = 16;
+
+	explicit HashGroup(const int8* controls)
+		: controls(_mm_load_si128((const __m128i*)controls)) {}
+
+	HashGroupMask Match(int8 h2) const
+	{
+		return { (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8(h2))), 0 };
+	}
+
+	HashGroupMask MatchEmpty() const
+	{
+		return { (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8(HASH_CONTROL_EMPTY))), 0 };
+	}
+
+	HashGroupMask MatchEmptyOrDeleted() const
+	{
+		return { (uint32)_mm_movemask_epi8(controls), 0 };
+	}
+
+private:
+	__m128i controls;
+#else
+	static constexpr uint32 WIDTH = 8;
+
+	explicit HashGroup(const int8* controls)
+	{
+		memcpy(&this->controls, controls, sizeof(this->controls));
+	}
+
+	// May report false positives, which the key comparison filters out
+	HashGroupMask Match(int8 h2) const
+	{
+		uint64 x = controls ^ (LSBS * (uint8)h2);
+
+		return { (x - LSBS) & ~x & MSBS, 3 };
+	}
+
+	HashGroupMask MatchEmpty() const
+	{
+		return { controls & ~(controls << 6) & MSBS, 3 };
+	}
+
+	HashGroupMask MatchEmptyOrDeleted() const
+	{
+		return { controls & MSBS, 3 };
+	}
+
+private:
+	static constexpr uint64 LSBS = 0x0101010101010101ull;
+	static constexpr uint64 MSBS = 0x8080808080808080ull;
+
+	uint64 controls;
+#endif
+};
+
+// Spreads the bits of weak hashes, e.g. the identity hash of integers, over the whole value
+inline uint64 MixHash(uint64 hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+}
+
+template <typename K, typename V>
+struct THashMapEntry
+{
+	// Changing the key of an entry in a map breaks the map
+	K key;
+	V value;
+};
+
+/**
+ * Open addressing hash map in the style of Swiss tables. Each slot has a control byte with 7 bits of its hash, which
+ * are compared a group at a time with SIMD so most lookups touch a single cache line of control bytes before the
+ * one entry they need. Control bytes and entries share a single allocation.
+ *
+ * With a Hash and KeyEqual that both define is_transparent, lookups take any key type they accept, e.g. a string view
+ * for string keys. Pointers to values are invalidated by inserts that grow the map.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class THashMap
+{
+	using Group = Internal::Memory::HashGroup;
+	using Entry = THashMapEntry<K, V>;
+
+	template <typename Q>
+	using LookupKey = std::conditional_t<
+		requires { typename Hash::is_transparent; typename KeyEqual::is_transparent; },
+		Q,
+		K>;
+
+public:
+	template <typename E>
+	class Iter;
+
+	using Iterator = Iter<Entry>;
+	using ConstIterator = Iter<const Entry>;
+
+	THashMap();
+	explicit THashMap(IAllocator* alloc);
+	THashMap(uint32 initialCapacity, IAllocator* alloc = DefAlloc());
+	THashMap(const THashMap& other);
+	THashMap(THashMap&& other) noexcept;
+	~THashMap();
+
+	THashMap& operator=(THashMap other) noexcept;
+
+	// Returns true if the key was added and false if it existed, in which case the value is assigned
+	bool Insert(const K& key, V value);
+
+	// Constructs the value only if the key doesn't exist yet
+	template <typename... Args>
+	std::pair<V*, bool> Emplace(const K& key, Args&&... args);
+
+	V& operator[](const K& key);
+
+	template <typename Q = K>
+	V* Find(const Q& key);
+	template <typename Q = K>
+	const V* Find(const Q& key) const;
+	template <typename Q = K>
+	bool Contains(const Q& key) const;
+	template <typename Q = K>
+	bool Remove(const Q& key);
+
+	void Clear();
+
+	uint32 Length() const;
+	uint32 Capacity() const;
+	bool IsEmpty() const;
+
+	// Makes room for count entries without growing
+	void Reserve(uint32 count);
+
+	// Rebuilds the table with at least the given capacity, which is also how tombstones are removed
+	void Rehash(uint32 newCapacity);
+
+	Iterator begin();
+	Iterator end();
+	ConstIterator begin() const;
+	ConstIterator end() const;
+
+	static constexpr uint32 GROUP_WIDTH = Group::WIDTH;
+
+	template <typename E>
+	class Iter
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = std::remove_cv_t<E>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = E*;
+		using reference = E&;
+
+		Iter()
+			: controls(nullptr)
+			, entries(nullptr)
+			, index(0)
+			, capacity(0) {}
+
+		Iter(const int8* controls, E* entries, uint32 index, uint32 capacity)
+			: controls(controls)
+			, entries(entries)
+			, index(index)
+			, capacity(capacity)
+		{
+			SkipFree();
+		}
+
+		E& operator*() const { return entries[index]; }
+		E* operator->() const { return &entries[index]; }
+
+		Iter& operator++()
+		{
+			++index;
+			SkipFree();
+
+			return *this;
+		}
+
+		Iter operator++(int)
+		{
+			Iter previous = *this;
+			++*this;
+
+			return previous;
+		}
+
+		friend bool operator==(const Iter& a, const Iter& b) { return a.index == b.index; }
+
+	private:
+		void SkipFree()
+		{
+			while (index < capacity && controls[index] < 0)
+				++index;
+		}
+
+		const int8* controls;
+		E* entries;
+		uint32 index;
+		uint32 capacity;
+	};
+
+protected:
+	static uint32 CapacityForCount(uint32 count);
+	static uint32 MaxLength(uint32 capacity);
+	static uint64 EntriesOffset(uint32 capacity);
+	static uint64 AllocationSize(uint32 capacity);
+
+	template <typename Q>
+	uint64 HashKey(const Q& key) const;
+
+	// Index of the entry with the key or capacity if not found
+	template <typename Q>
+	uint32 FindIndex(const Q& key, uint64 hash) const;
+
+	// Finds a free slot for a key known not to be in the map, growing the map if needed
+	uint32 PrepareInsert(uint64 hash);
+	uint32 FindFreeIndex(uint64 hash) const;
+	void SetControl(uint32 index, int8 control);
+	void RemoveAt(uint32 index);
+
+	void Allocate(uint32 newCapacity);
+	void Destroy();
+
+	IAllocator* alloc;
+	Hash hasher;
+	KeyEqual keyEqual;
+
+	int8* controls;
+	Entry* entries;
+	uint32 length;
+	uint32 capacity;
+
+	// Inserts left before the map has to grow, counting tombstones as used
+	uint32 growthLeft;
+};
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+THashMap<K, V, Hash, KeyEqual>::THashMap()
+	: THashMap(DefAlloc()) {}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+THashMap<K, V, Hash, KeyEqual>::THashMap(IAllocator* alloc)
+	: alloc(alloc)
+	, controls(nullptr)
+	, entries(nullptr)
+	, length(0)
+	, capacity(0)
+	, growthLeft(0) {}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+THashMap<K, V, Hash, KeyEqual>::THashMap(uint32 initialCapacity, IAllocator* alloc)
+	: THashMap(alloc)
+{
+	Reserve(initialCapacity);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+THashMap<K, V, Hash, KeyEqual>::THashMap(const THashMap& other)
+	: THashMap(other.alloc)
+{
+	hasher = other.hasher;
+	keyEqual = other.keyEqual;
+	Reserve(other.length);
+
+	for (const Entry& entry : other)
+	{
+		uint32 index = PrepareInsert(HashKey(entry.key));
+
+		new (&entries[index]) Entry(entry);
+		++length;
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+THashMap<K, V, Hash, KeyEqual>::THashMap(THashMap&& other) noexcept
+	: alloc(other.alloc)
+	, hasher(std::move(other.hasher))
+	, keyEqual(std::move(other.keyEqual))
+	, controls(other.controls)
+	, entries(other.entries)
+	, length(other.length)
+	, capacity(other.capacity)
+	, growthLeft(other.growthLeft)
+{
+	other.controls = nullptr;
+	other.entries = nullptr;
+	other.length = 0;
+	other.capacity = 0;
+	other.growthLeft = 0;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+THashMap<K, V, Hash, KeyEqual>::~THashMap()
+{
+	Destroy();
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+THashMap<K, V, Hash, KeyEqual>& THashMap<K, V, Hash, KeyEqual>::operator=(THashMap other) noexcept
+{
+	std::swap(alloc, other.alloc);
+	std::swap(hasher, other.hasher);
+	std::swap(keyEqual, other.keyEqual);
+	std::swap(controls, other.controls);
+	std::swap(entries, other.entries);
+	std::swap(length, other.length);
+	std::swap(capacity, other.capacity);
+	std::swap(growthLeft, other.growthLeft);
+
+	return *this;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool THashMap<K, V, Hash, KeyEqual>::Insert(const K& key, V value)
+{
+	auto [valuePtr, inserted] = Emplace(key, std::move(value));
+
+	if (!inserted)
+		*valuePtr = std::move(value);
+
+	return inserted;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename... Args>
+std::pair<V*, bool> THashMap<K, V, Hash, KeyEqual>::Emplace(const K& key, Args&&... args)
+{
+	uint64 hash = HashKey(key);
+	uint32 index = FindIndex(key, hash);
+
+	if (index != capacity)
+		return { &entries[index].value, false };
+
+	index = PrepareInsert(hash);
+	new (&entries[index]) Entry{ key, V(std::forward<Args>(args)...) };
+	++length;
+
+	return { &entries[index].value, true };
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+V& THashMap<K, V, Hash, KeyEqual>::operator[](const K& key)
+{
+	return *Emplace(key).first;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename Q>
+V* THashMap<K, V, Hash, KeyEqual>::Find(const Q& key)
+{
+	const LookupKey<Q>& lookupKey = key;
+	uint32 index = FindIndex(lookupKey, HashKey(lookupKey));
+
+	return index != capacity ? &entries[index].value : nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename Q>
+const V* THashMap<K, V, Hash, KeyEqual>::Find(const Q& key) const
+{
+	return const_cast<THashMap*>(this)->Find(key);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename Q>
+bool THashMap<K, V, Hash, KeyEqual>::Contains(const Q& key) const
+{
+	return Find(key) != nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename Q>
+bool THashMap<K, V, Hash, KeyEqual>::Remove(const Q& key)
+{
+	const LookupKey<Q>& lookupKey = key;
+	uint32 index = FindIndex(lookupKey, HashKey(lookupKey));
+
+	if (index == capacity)
+		return false;
+
+	RemoveAt(index);
+
+	return true;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void THashMap<K, V, Hash, KeyEqual>::Clear()
+{
+	if constexpr (!std::is_trivially_destructible_v<Entry>)
+	{
+		for (Entry& entry : *this)
+			entry.~Entry();
+	}
+
+	if (controls)
+		memset(controls, Internal::Memory::HASH_CONTROL_EMPTY, capacity);
+
+	length = 0;
+	growthLeft = MaxLength(capacity);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint32 THashMap<K, V, Hash, KeyEqual>::Length() const
+{
+	return length;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint32 THashMap<K, V, Hash, KeyEqual>::Capacity() const
+{
+	return capacity;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool THashMap<K, V, Hash, KeyEqual>::IsEmpty() const
+{
+	return length == 0;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void THashMap<K, V, Hash, KeyEqual>::Reserve(uint32 count)
+{
+	if (count > length + growthLeft)
+		Rehash(CapacityForCount(count));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void THashMap<K, V, Hash, KeyEqual>::Rehash(uint32 newCapacity)
+{
+	uint32 requiredCapacity = CapacityForCount(length);
+
+	newCapacity = CapacityForCount(MaxLength(newCapacity > requiredCapacity ? newCapacity : requiredCapacity));
+
+	if (newCapacity == 0)
+	{
+		Destroy();
+		controls = nullptr;
+		entries = nullptr;
+		capacity = 0;
+		growthLeft = 0;
+
+		return;
+	}
+
+	int8* oldControls = controls;
+	Entry* oldEntries = entries;
+	uint32 oldCapacity = capacity;
+
+	Allocate(newCapacity);
+
+	for (uint32 i = 0; i < oldCapacity; ++i)
+	{
+		if (oldControls[i] < 0)
+			continue;
+
+		uint32 index = FindFreeIndex(HashKey(oldEntries[i].key));
+
+		SetControl(index, oldControls[i]);
+		new (&entries[index]) Entry(std::move(oldEntries[i]));
+		oldEntries[i].~Entry();
+	}
+
+	growthLeft -= length;
+
+	if (oldControls)
+		alloc->Free(oldControls, AllocationSize(oldCapacity));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+typename THashMap<K, V, Hash, KeyEqual>::Iterator THashMap<K, V, Hash, KeyEqual>::begin()
+{
+	return Iterator(controls, entries, 0, capacity);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+typename THashMap<K, V, Hash, KeyEqual>::Iterator THashMap<K, V, Hash, KeyEqual>::end()
+{
+	return Iterator(controls, entries, capacity, capacity);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+typename THashMap<K, V, Hash, KeyEqual>::ConstIterator THashMap<K, V, Hash, KeyEqual>::begin() const
+{
+	return ConstIterator(controls, entries, 0, capacity);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+typename THashMap<K, V, Hash, KeyEqual>::ConstIterator THashMap<K, V, Hash, KeyEqual>::end() const
+{
+	return ConstIterator(controls, entries, capacity, capacity);
+}
+
+// Capacities are powers of two and at least one group
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint32 THashMap<K, V, Hash, KeyEqual>::CapacityForCount(uint32 count)
+{
+	if (count == 0)
+		return 0;
+
+	uint32 capacity = GROUP_WIDTH;
+
+	while (MaxLength(capacity) < count)
+		capacity *= 2;
+
+	return capacity;
+}
+
+// Load factor of 7/8
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint32 THashMap<K, V, Hash, KeyEqual>::MaxLength(uint32 capacity)
+{
+	return capacity - capacity / 8;
+}
+
+// Control bytes come first, followed by the entries
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint64 THashMap<K, V, Hash, KeyEqual>::EntriesOffset(uint32 capacity)
+{
+	return ((uint64)capacity + alignof(Entry) - 1) / alignof(Entry) * alignof(Entry);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint64 THashMap<K, V, Hash, KeyEqual>::AllocationSize(uint32 capacity)
+{
+	return EntriesOffset(capacity) + (uint64)capacity * sizeof(Entry);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename Q>
+uint64 THashMap<K, V, Hash, KeyEqual>::HashKey(const Q& key) const
+{
+	return Internal::Memory::MixHash((uint64)hasher(key));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename Q>
+uint32 THashMap<K, V, Hash, KeyEqual>::FindIndex(const Q& key, uint64 hash) const
+{
+	if (capacity == 0)
+		return capacity;
+
+	int8 h2 = (int8)(hash & 0x7F);
+	uint32 groupMask = capacity / GROUP_WIDTH - 1;
+	uint32 group = (uint32)(hash >> 7) & groupMask;
+
+	// Triangular probing visits every group once
+	for (uint32 probeCount = 1;; ++probeCount)
+	{
+		uint32 groupStart = group * GROUP_WIDTH;
+		Group controlGroup(controls + groupStart);
+
+		for (Internal::Memory::HashGroupMask matches = controlGroup.Match(h2); matches.HasAny(); matches.RemoveLowest())
+		{
+			uint32 index = groupStart + matches.Lowest();
+
+			if (keyEqual(entries[index].key, key))
+				return index;
+		}
+
+		if (controlGroup.MatchEmpty().HasAny() || probeCount > groupMask)
+			return capacity;
+
+		group = (group + probeCount) & groupMask;
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint32 THashMap<K, V, Hash, KeyEqual>::PrepareInsert(uint64 hash)
+{
+	uint32 index = capacity > 0 ? FindFreeIndex(hash) : 0;
+
+	// Reusing a tombstone doesn't use up any growth
+	if (capacity == 0 || (growthLeft == 0 && controls[index] != Internal::Memory::HASH_CONTROL_DELETED))
+	{
+		// Mostly tombstones are cleaned up at the same capacity instead of growing
+		uint32 newCapacity = length + 1 > MaxLength(capacity) / 2 ? capacity * 2 : capacity;
+
+		Rehash(newCapacity > GROUP_WIDTH ? newCapacity : GROUP_WIDTH);
+		index = FindFreeIndex(hash);
+	}
+
+	if (controls[index] == Internal::Memory::HASH_CONTROL_EMPTY)
+		--growthLeft;
+
+	SetControl(index, (int8)(hash & 0x7F));
+
+	return index;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint32 THashMap<K, V, Hash, KeyEqual>::FindFreeIndex(uint64 hash) const
+{
+	uint32 groupMask = capacity / GROUP_WIDTH - 1;
+	uint32 group = (uint32)(hash >> 7) & groupMask;
+
+	for (uint32 probeCount = 1;; ++probeCount)
+	{
+		Internal::Memory::HashGroupMask freeSlots = Group(controls + group * GROUP_WIDTH).MatchEmptyOrDeleted();
+
+		if (freeSlots.HasAny())
+			return group * GROUP_WIDTH + freeSlots.Lowest();
+
+		group = (group + probeCount) & groupMask;
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void THashMap<K, V, Hash, KeyEqual>::SetControl(uint32 index, int8 control)
+{
+	controls[index] = control;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void THashMap<K, V, Hash, KeyEqual>::RemoveAt(uint32 index)
+{
+	entries[index].~Entry();
+	--length;
+
+	// Lookups stop at groups with an empty slot, so one more can't break any probe sequence through this group
+	if (Group(controls + index / GROUP_WIDTH * GROUP_WIDTH).MatchEmpty().HasAny())
+	{
+		SetControl(index, Internal::Memory::HASH_CONTROL_EMPTY);
+		++growthLeft;
+	}
+	else
+		SetControl(index, Internal::Memory::HASH_CONTROL_DELETED);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void THashMap<K, V, Hash, KeyEqual>::Allocate(uint32 newCapacity)
+{
+	constexpr uint32 align = alignof(Entry) > GROUP_WIDTH ? alignof(Entry) : GROUP_WIDTH;
+	char* memory = (char*)alloc->Allocate(AllocationSize(newCapacity), align);
+
+	controls = (int8*)memory;
+	entries = (Entry*)(memory + EntriesOffset(newCapacity));
+	capacity = newCapacity;
+	growthLeft = MaxLength(newCapacity);
+
+	memset(controls, Internal::Memory::HASH_CONTROL_EMPTY, newCapacity);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void THashMap<K, V, Hash, KeyEqual>::Destroy()
+{
+	if (!controls)
+		return;
+
+	if constexpr (!std::is_trivially_destructible_v<Entry>)
+	{
+		for (Entry& entry : *this)
+			entry.~Entry();
+	}
+
+	alloc->Free(controls, AllocationSize(capacity));
+}
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "TArray.h"
+
+namespace ducklib
+{
+/**
+ * TArray that keeps up to N elements inline and only allocates once it grows beyond that, so small temporary arrays
+ * don't touch the allocator at all. Can be passed anywhere a TArray is expected.
+ */
+template <typename T, uint32 N>
+class TInlineArray : public TArray<T>
+{
+public:
+	TInlineArray();
+	explicit TInlineArray(IAllocator* alloc);
+	TInlineArray(uint32 initialCapacity);
+	TInlineArray(uint32 initialCapacity, IAllocator* alloc);
+	TInlineArray(const T* other, uint32 otherLength);
+	TInlineArray(const T* other, uint32 otherLength, uint32 startCapacity);
+	TInlineArray(const T* other, uint32 otherLength, uint32 startCapacity, IAllocator* alloc);
+	TInlineArray(const TInlineArray& other);
+	TInlineArray(TInlineArray&& other) noexcept;
+
+	// False once the elements have spilled to the allocator
+	bool IsInline() const;
+
+	static constexpr uint32 INLINE_CAPACITY = N;
+
+private:
+	alignas(T) char inlineStorage[N * sizeof(T)];
+};
+
+template <typename T, uint32 N>
+TInlineArray<T, N>::TInlineArray()
+	: TInlineArray(DefAlloc()) {}
+
+template <typename T, uint32 N>
+TInlineArray<T, N>::TInlineArray(IAllocator* alloc)
+	: TArray<T>((T*)inlineStorage, N, alloc) {}
+
+template <typename T, uint32 N>
+TInlineArray<T, N>::TInlineArray(uint32 initialCapacity)
+	: TInlineArray(initialCapacity, DefAlloc()) {}
+
+template <typename T, uint32 N>
+TInlineArray<T, N>::TInlineArray(uint32 initialCapacity, IAllocator* alloc)
+	: TInlineArray(alloc)
+{
+	this->Reserve(initialCapacity);
+}
+
+template <typename T, uint32 N>
+TInlineArray<T, N>::TInlineArray(const T* other, uint32 otherLength)
+	: TInlineArray(other, otherLength, otherLength) {}
+
+template <typename T, uint32 N>
+TInlineArray<T, N>::TInlineArray(const T* other, uint32 otherLength, uint32 startCapacity)
+	: TInlineArray(other, otherLength, startCapacity, DefAlloc()) {}
+
+template <typename T, uint32 N>
+TInlineArray<T, N>::TInlineArray(const T* other, uint32 otherLength, uint32 startCapacity, IAllocator* alloc)
+	: TInlineArray(alloc)
+{
+	this->Reserve(startCapacity > otherLength ? startCapacity : otherLength);
+
+	if (other)
+		Internal::Memory::CopyConstructElements(this->array, other, otherLength);
+	else
+		Internal::Memory::DefaultConstructElements(this->array, otherLength);
+
+	this->length = otherLength;
+}
+
+template <typename T, uint32 N>
+TInlineArray<T, N>::TInlineArray(const TInlineArray& other)
+	: TInlineArray(other.array, other.length, other.length, other.alloc) {}
+
+template <typename T, uint32 N>
+TInlineArray<T, N>::TInlineArray(TInlineArray&& other) noexcept
+	: TInlineArray(other.alloc)
+{
+	if (other.isInlineArray)
+	{
+		Internal::Memory::RelocateElements(this->array, other.array, other.length);
+		this->length = other.length;
+	}
+	else
+	{
+		this->array = other.array;
+		this->length = other.length;
+		this->capacity = other.capacity;
+		this->isInlineArray = false;
+
+		other.array = (T*)other.inlineStorage;
+		other.capacity = N;
+		other.isInlineArray = true;
+	}
+
+	other.length = 0;
+}
+
+template <typename T, uint32 N>
+bool TInlineArray<T, N>::IsInline() const
+{
+	return this->isInlineArray;
+}
+}
@@ -0,0 +1,412 @@
+#pragma once
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include "TArray.h"
+
+namespace ducklib
+{
+/**
+ * Bounded double-ended queue in a single contiguous buffer. The capacity is rounded up to a power of two so indices
+ * wrap with a mask instead of a modulo. Pushing to a full ring buffer fails instead of allocating, see TDeque for a
+ * growing one. Not thread safe.
+ *
+ * Since the elements may wrap around the end of the buffer, bulk access goes through GetSpans(), which returns the
+ * elements in order as at most two contiguous spans.
+ */
+template <typename T>
+class TRingBuffer
+{
+public:
+	explicit TRingBuffer(uint32 capacity, IAllocator* alloc = DefAlloc());
+	TRingBuffer(const TRingBuffer& other);
+	TRingBuffer(TRingBuffer&& other) noexcept;
+	~TRingBuffer();
+
+	bool TryPushBack(const T& item);
+	bool TryPushBack(T&& item);
+	bool TryPushFront(const T& item);
+	bool TryPushFront(T&& item);
+	bool TryPopFront(T* item);
+	bool TryPopBack(T* item);
+
+	// Returns how many of the items fit
+	uint32 PushBackRange(const T* items, uint32 count);
+	// Returns how many items were popped
+	uint32 PopFrontRange(T* items, uint32 count);
+
+	T& Front();
+	const T& Front() const;
+	T& Back();
+	const T& Back() const;
+
+	// Counted from the front
+	T& operator[](uint32 i);
+	const T& operator[](uint32 i) const;
+
+	uint32 Length() const;
+	uint32 Capacity() const;
+	bool IsEmpty() const;
+	bool IsFull() const;
+	void Clear();
+
+	// The second span is only non-empty when the elements wrap around the end of the buffer
+	void GetSpans(std::span<T>& first, std::span<T>& second);
+	void GetSpans(std::span<const T>& first, std::span<const T>& second) const;
+
+protected:
+	explicit TRingBuffer(IAllocator* alloc);
+
+	static uint32 RoundUpToPowerOfTwo(uint32 value);
+
+	uint32 PhysicalIndex(uint32 i) const;
+
+	template <typename... Args>
+	void ConstructBack(Args&&... args);
+	template <typename... Args>
+	void ConstructFront(Args&&... args);
+
+	// Moves the elements to a new buffer, starting at its beginning
+	void Reallocate(uint32 newCapacity);
+	void Destroy();
+
+	IAllocator* alloc;
+	T* items;
+	uint32 head;
+	uint32 length;
+	uint32 capacity;
+};
+
+template <typename T>
+TRingBuffer<T>::TRingBuffer(IAllocator* alloc)
+	: alloc(alloc)
+	, items(nullptr)
+	, head(0)
+	, length(0)
+	, capacity(0) {}
+
+template <typename T>
+TRingBuffer<T>::TRingBuffer(uint32 capacity, IAllocator* alloc)
+	: TRingBuffer(alloc)
+{
+	if (capacity > 0)
+		Reallocate(RoundUpToPowerOfTwo(capacity));
+}
+
+template <typename T>
+TRingBuffer<T>::TRingBuffer(const TRingBuffer& other)
+	: TRingBuffer(other.alloc)
+{
+	std::span<const T> first;
+	std::span<const T> second;
+
+	if (other.capacity > 0)
+		Reallocate(other.capacity);
+
+	other.GetSpans(first, second);
+	Internal::Memory::CopyConstructElements(items, first.data(), (uint32)first.size());
+	Internal::Memory::CopyConstructElements(items + first.size(), second.data(), (uint32)second.size());
+	length = other.length;
+}
+
+template <typename T>
+TRingBuffer<T>::TRingBuffer(TRingBuffer&& other) noexcept
+	: alloc(other.alloc)
+	, items(other.items)
+	, head(other.head)
+	, length(other.length)
+	, capacity(other.capacity)
+{
+	other.items = nullptr;
+	other.head = 0;
+	other.length = 0;
+	other.capacity = 0;
+}
+
+template <typename T>
+TRingBuffer<T>::~TRingBuffer()
+{
+	Destroy();
+}
+
+template <typename T>
+bool TRingBuffer<T>::TryPushBack(const T& item)
+{
+	if (IsFull())
+		return false;
+
+	ConstructBack(item);
+
+	return true;
+}
+
+template <typename T>
+bool TRingBuffer<T>::TryPushBack(T&& item)
+{
+	if (IsFull())
+		return false;
+
+	ConstructBack(std::move(item));
+
+	return true;
+}
+
+template <typename T>
+bool TRingBuffer<T>::TryPushFront(const T& item)
+{
+	if (IsFull())
+		return false;
+
+	ConstructFront(item);
+
+	return true;
+}
+
+template <typename T>
+bool TRingBuffer<T>::TryPushFront(T&& item)
+{
+	if (IsFull())
+		return false;
+
+	ConstructFront(std::move(item));
+
+	return true;
+}
+
+template <typename T>
+bool TRingBuffer<T>::TryPopFront(T* item)
+{
+	if (IsEmpty())
+		return false;
+
+	T& front = items[head];
+
+	*item = std::move(front);
+	front.~T();
+	head = PhysicalIndex(1);
+	--length;
+
+	return true;
+}
+
+template <typename T>
+bool TRingBuffer<T>::TryPopBack(T* item)
+{
+	if (IsEmpty())
+		return false;
+
+	T& back = Back();
+
+	*item = std::move(back);
+	back.~T();
+	--length;
+
+	return true;
+}
+
+template <typename T>
+uint32 TRingBuffer<T>::PushBackRange(const T* items, uint32 count)
+{
+	uint32 pushCount = capacity - length < count ? capacity - length : count;
+
+	if (pushCount == 0)
+		return 0;
+
+	// Split where the free space wraps around the end of the buffer
+	uint32 start = PhysicalIndex(length);
+	uint32 firstCount = capacity - start < pushCount ? capacity - start : pushCount;
+
+	Internal::Memory::CopyConstructElements(this->items + start, items, firstCount);
+	Internal::Memory::CopyConstructElements(this->items, items + firstCount, pushCount - firstCount);
+	length += pushCount;
+
+	return pushCount;
+}
+
+template <typename T>
+uint32 TRingBuffer<T>::PopFrontRange(T* items, uint32 count)
+{
+	uint32 popCount = length < count ? length : count;
+
+	if constexpr (std::is_trivially_copyable_v<T>)
+	{
+		uint32 firstCount = capacity - head < popCount ? capacity - head : popCount;
+
+		if (popCount > 0)
+		{
+			memcpy(items, this->items + head, firstCount * sizeof(T));
+			memcpy(items + firstCount, this->items, (popCount - firstCount) * sizeof(T));
+		}
+
+		head = PhysicalIndex(popCount);
+		length -= popCount;
+	}
+	else
+	{
+		for (uint32 i = 0; i < popCount; ++i)
+			TryPopFront(&items[i]);
+	}
+
+	return popCount;
+}
+
+template <typename T>
+T& TRingBuffer<T>::Front()
+{
+	return items[head];
+}
+
+template <typename T>
+const T& TRingBuffer<T>::Front() const
+{
+	return items[head];
+}
+
+template <typename T>
+T& TRingBuffer<T>::Back()
+{
+	return items[PhysicalIndex(length - 1)];
+}
+
+template <typename T>
+const T& TRingBuffer<T>::Back() const
+{
+	return items[PhysicalIndex(length - 1)];
+}
+
+template <typename T>
+T& TRingBuffer<T>::operator[](uint32 i)
+{
+	return items[PhysicalIndex(i)];
+}
+
+template <typename T>
+const T& TRingBuffer<T>::operator[](uint32 i) const
+{
+	return items[PhysicalIndex(i)];
+}
+
+template <typename T>
+uint32 TRingBuffer<T>::Length() const
+{
+	return length;
+}
+
+template <typename T>
+uint32 TRingBuffer<T>::Capacity() const
+{
+	return capacity;
+}
+
+template <typename T>
+bool TRingBuffer<T>::IsEmpty() const
+{
+	return length == 0;
+}
+
+template <typename T>
+bool TRingBuffer<T>::IsFull() const
+{
+	return length == capacity;
+}
+
+template <typename T>
+void TRingBuffer<T>::Clear()
+{
+	std::span<T> first;
+	std::span<T> second;
+
+	GetSpans(first, second);
+	Internal::Memory::DestroyElements(first.data(), (uint32)first.size());
+	Internal::Memory::DestroyElements(second.data(), (uint32)second.size());
+	head = 0;
+	length = 0;
+}
+
+template <typename T>
+void TRingBuffer<T>::GetSpans(std::span<T>& first, std::span<T>& second)
+{
+	uint32 firstCount = capacity - head < length ? capacity - head : length;
+
+	first = { items + head, firstCount };
+	second = { items, length - firstCount };
+}
+
+template <typename T>
+void TRingBuffer<T>::GetSpans(std::span<const T>& first, std::span<const T>& second) const
+{
+	uint32 firstCount = capacity - head < length ? capacity - head : length;
+
+	first = { items + head, firstCount };
+	second = { items, length - firstCount };
+}
+
+template <typename T>
+uint32 TRingBuffer<T>::RoundUpToPowerOfTwo(uint32 value)
+{
+	uint32 powerOfTwo = 1;
+
+	while (powerOfTwo < value)
+	{
+		if (powerOfTwo == 1u << 31)
+			throw std::runtime_error("Ring buffer capacity too large");
+
+		powerOfTwo <<= 1;
+	}
+
+	return powerOfTwo;
+}
+
+template <typename T>
+uint32 TRingBuffer<T>::PhysicalIndex(uint32 i) const
+{
+	return (head + i) & (capacity - 1);
+}
+
+template <typename T>
+template <typename... Args>
+void TRingBuffer<T>::ConstructBack(Args&&... args)
+{
+	new (&items[PhysicalIndex(length)]) T(std::forward<Args>(args)...);
+	++length;
+}
+
+template <typename T>
+template <typename... Args>
+void TRingBuffer<T>::ConstructFront(Args&&... args)
+{
+	uint32 newHead = PhysicalIndex(capacity - 1);
+
+	new (&items[newHead]) T(std::forward<Args>(args)...);
+	head = newHead;
+	++length;
+}
+
+template <typename T>
+void TRingBuffer<T>::Reallocate(uint32 newCapacity)
+{
+	T* newItems = (T*)alloc->Allocate((uint64)newCapacity * sizeof(T), alignof(T));
+	std::span<T> first;
+	std::span<T> second;
+
+	GetSpans(first, second);
+	Internal::Memory::RelocateElements(newItems, first.data(), (uint32)first.size());
+	Internal::Memory::RelocateElements(newItems + first.size(), second.data(), (uint32)second.size());
+
+	if (items)
+		alloc->Free(items, (uint64)capacity * sizeof(T));
+
+	items = newItems;
+	head = 0;
+	capacity = newCapacity;
+}
+
+template <typename T>
+void TRingBuffer<T>::Destroy()
+{
+	Clear();
+
+	if (items)
+		alloc->Free(items, (uint64)capacity * sizeof(T));
+}
+}
@@ -0,0 +1,293 @@
+#pragma once
+#include <stdexcept>
+#include <utility>
+#include "TArray.h"
+
+namespace ducklib
+{
+/**
+ * Handle to an object in a TSlotMap. Type and index keep the layout of Render::Handle, the generation detects handles
+ * to objects that have been removed even if their slot has been reused since. Default constructed handles are never
+ * valid.
+ */
+struct SlotHandle
+{
+	uint32 type : 6;
+	uint32 index : 25;
+	uint32 generation;
+
+	friend bool operator==(const SlotHandle& a, const SlotHandle& b) = default;
+};
+
+/**
+ * Pool of objects referred to by generation checked handles. Insert, Remove and lookups are O(1), and the objects
+ * are kept densely packed so iterating over them is a linear scan. Removing moves the last object into the hole, so
+ * pointers to objects are only valid until the next insert or remove, but handles stay valid until their object is
+ * removed.
+ *
+ * Handles carry the type given to the map, so handles of one map are rejected by maps of another type.
+ */
+template <typename T>
+class TSlotMap
+{
+public:
+	explicit TSlotMap(uint32 type = 0, IAllocator* alloc = DefAlloc());
+
+	SlotHandle Insert(const T& value);
+	SlotHandle Insert(T&& value);
+
+	template <typename... Args>
+	SlotHandle Emplace(Args&&... args);
+
+	// Returns false for stale or invalid handles
+	bool Remove(SlotHandle handle);
+
+	T* Get(SlotHandle handle);
+	const T* Get(SlotHandle handle) const;
+	bool Contains(SlotHandle handle) const;
+
+	// Handle of the object at the given position in the dense storage
+	SlotHandle HandleAt(uint32 denseIndex) const;
+
+	uint32 Length() const;
+	bool IsEmpty() const;
+	void Reserve(uint32 capacity);
+	void Clear();
+
+	T* Data();
+	const T* Data() const;
+
+	typename TArray<T>::Iterator begin();
+	typename TArray<T>::Iterator end();
+	typename TArray<T>::ConstIterator begin() const;
+	typename TArray<T>::ConstIterator end() const;
+
+	static constexpr uint32 MAX_TYPE = (1u << 6) - 1;
+	static constexpr uint32 MAX_SLOTS = 1u << 25;
+
+protected:
+	struct Slot
+	{
+		// Index in the dense storage when used and the next free slot otherwise
+		uint32 denseIndexOrNextFree;
+		uint32 generation;
+	};
+
+	uint32 AllocateSlot();
+	uint32 FindDenseIndex(SlotHandle handle) const;
+
+	static constexpr uint32 NO_SLOT = ~0u;
+
+	TArray<T> values;
+	TArray<uint32> denseToSlot;
+	TArray<Slot> slots;
+	uint32 freeSlot;
+	uint32 type;
+};
+
+template <typename T>
+TSlotMap<T>::TSlotMap(uint32 type, IAllocator* alloc)
+	: values(alloc)
+	, denseToSlot(alloc)
+	, slots(alloc)
+	, freeSlot(NO_SLOT)
+	, type(type)
+{
+	if (type > MAX_TYPE)
+		throw std::runtime_error("Slot map type doesn't fit in a handle");
+}
+
+template <typename T>
+SlotHandle TSlotMap<T>::Insert(const T& value)
+{
+	return Emplace(value);
+}
+
+template <typename T>
+SlotHandle TSlotMap<T>::Insert(T&& value)
+{
+	return Emplace(std::move(value));
+}
+
+template <typename T>
+template <typename... Args>
+SlotHandle TSlotMap<T>::Emplace(Args&&... args)
+{
+	values.EmplaceBack(std::forward<Args>(args)...);
+
+	uint32 slotIndex;
+
+	try
+	{
+		slotIndex = AllocateSlot();
+	}
+	catch (...)
+	{
+		values.RemoveLast();
+		throw;
+	}
+
+	slots[slotIndex].denseIndexOrNextFree = values.Length() - 1;
+	denseToSlot.Append(slotIndex);
+
+	return { type, slotIndex, slots[slotIndex].generation };
+}
+
+template <typename T>
+bool TSlotMap<T>::Remove(SlotHandle handle)
+{
+	uint32 denseIndex = FindDenseIndex(handle);
+
+	if (denseIndex == NO_SLOT)
+		return false;
+
+	uint32 lastIndex = values.Length() - 1;
+
+	// Keep the storage dense by moving the last object into the hole
+	if (denseIndex != lastIndex)
+	{
+		values[denseIndex] = std::move(values[lastIndex]);
+		denseToSlot[denseIndex] = denseToSlot[lastIndex];
+		slots[denseToSlot[denseIndex]].denseIndexOrNextFree = denseIndex;
+	}
+
+	values.RemoveLast();
+	denseToSlot.RemoveLast();
+
+	Slot& slot = slots[handle.index];
+
+	// 0 is skipped so default constructed handles never match
+	if (++slot.generation == 0)
+		slot.generation = 1;
+
+	slot.denseIndexOrNextFree = freeSlot;
+	freeSlot = handle.index;
+
+	return true;
+}
+
+template <typename T>
+T* TSlotMap<T>::Get(SlotHandle handle)
+{
+	uint32 denseIndex = FindDenseIndex(handle);
+
+	return denseIndex != NO_SLOT ? &values[denseIndex] : nullptr;
+}
+
+template <typename T>
+const T* TSlotMap<T>::Get(SlotHandle handle) const
+{
+	uint32 denseIndex = FindDenseIndex(handle);
+
+	return denseIndex != NO_SLOT ? &values[denseIndex] : nullptr;
+}
+
+template <typename T>
+bool TSlotMap<T>::Contains(SlotHandle handle) const
+{
+	return FindDenseIndex(handle) != NO_SLOT;
+}
+
+template <typename T>
+SlotHandle TSlotMap<T>::HandleAt(uint32 denseIndex) const
+{
+	uint32 slotIndex = denseToSlot[denseIndex];
+
+	return { type, slotIndex, slots[slotIndex].generation };
+}
+
+template <typename T>
+uint32 TSlotMap<T>::Length() const
+{
+	return values.Length();
+}
+
+template <typename T>
+bool TSlotMap<T>::IsEmpty() const
+{
+	return values.IsEmpty();
+}
+
+template <typename T>
+void TSlotMap<T>::Reserve(uint32 capacity)
+{
+	values.Reserve(capacity);
+	denseToSlot.Reserve(capacity);
+	slots.Reserve(capacity);
+}
+
+template <typename T>
+void TSlotMap<T>::Clear()
+{
+	for (uint32 i = values.Length(); i > 0; --i)
+		Remove(HandleAt(i - 1));
+}
+
+template <typename T>
+T* TSlotMap<T>::Data()
+{
+	return values.Data();
+}
+
+template <typename T>
+const T* TSlotMap<T>::Data() const
+{
+	return values.Data();
+}
+
+template <typename T>
+typename TArray<T>::Iterator TSlotMap<T>::begin()
+{
+	return values.begin();
+}
+
+template <typename T>
+typename TArray<T>::Iterator TSlotMap<T>::end()
+{
+	return values.end();
+}
+
+template <typename T>
+typename TArray<T>::ConstIterator TSlotMap<T>::begin() const
+{
+	return values.begin();
+}
+
+template <typename T>
+typename TArray<T>::ConstIterator TSlotMap<T>::end() const
+{
+	return values.end();
+}
+
+template <typename T>
+uint32 TSlotMap<T>::AllocateSlot()
+{
+	if (freeSlot != NO_SLOT)
+	{
+		uint32 slotIndex = freeSlot;
+
+		freeSlot = slots[slotIndex].denseIndexOrNextFree;
+
+		return slotIndex;
+	}
+
+	if (slots.Length() == MAX_SLOTS)
+		throw std::runtime_error("Slot map ran out of handle indices");
+
+	slots.Append({ 0, 1 });
+
+	return slots.Length() - 1;
+}
+
+template <typename T>
+uint32 TSlotMap<T>::FindDenseIndex(SlotHandle handle) const
+{
+	if (handle.type != type || handle.index >= slots.Length())
+		return NO_SLOT;
+
+	const Slot& slot = slots[handle.index];
+
+	// Free slots always have a newer generation than any handle given out for them
+	return slot.generation == handle.generation ? slot.denseIndexOrNextFree : NO_SLOT;
+}
+}
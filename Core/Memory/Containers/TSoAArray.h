@@ -0,0 +1,477 @@
+#pragma once
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include "TArray.h"
+
+namespace ducklib
+{
+/**
+ * Array of rows stored as structure of arrays, i.e. each of the Ts in its own contiguous column, so scanning one
+ * field touches only that field's memory. All columns share a single allocation, length and capacity, and each
+ * column starts at COLUMN_ALIGN so it can be processed with aligned SIMD loads.
+ *
+ * Columns are accessed by index, e.g. Column<0>() for a span of the first column, and rows as tuples of references
+ * which work with structured bindings: for (auto [ptr, size] : allocations).
+ */
+template <typename... Ts>
+class TSoAArray
+{
+	template <size_t... Is>
+	using IndexSequence = std::index_sequence<Is...>;
+	using Indices = std::index_sequence_for<Ts...>;
+
+public:
+	template <uint32 I>
+	using ColumnType = std::tuple_element_t<I, std::tuple<Ts...>>;
+	using Row = std::tuple<Ts&...>;
+	using ConstRow = std::tuple<const Ts&...>;
+
+	template <typename R, typename Array>
+	class RowIt;
+
+	using Iterator = RowIt<Row, TSoAArray>;
+	using ConstIterator = RowIt<ConstRow, const TSoAArray>;
+
+	TSoAArray();
+	explicit TSoAArray(IAllocator* alloc);
+	TSoAArray(uint32 initialCapacity, IAllocator* alloc = DefAlloc());
+	TSoAArray(const TSoAArray& other);
+	TSoAArray(TSoAArray&& other) noexcept;
+	~TSoAArray();
+
+	template <typename... Args>
+	void Append(Args&&... values);
+
+	// Moves the last row into the removed one, so the order of rows isn't kept
+	void RemoveAtSwap(uint32 index);
+
+	uint32 Length() const;
+	uint32 Capacity() const;
+	bool IsEmpty() const;
+	void Resize(uint32 newLength);
+	void Reserve(uint32 newCapacity);
+	void Clear();
+
+	template <uint32 I>
+	ColumnType<I>* Data();
+	template <uint32 I>
+	const ColumnType<I>* Data() const;
+
+	template <uint32 I>
+	std::span<ColumnType<I>> Column();
+	template <uint32 I>
+	std::span<const ColumnType<I>> Column() const;
+
+	template <uint32 I>
+	ColumnType<I>& Get(uint32 i);
+	template <uint32 I>
+	const ColumnType<I>& Get(uint32 i) const;
+
+	Row operator[](uint32 i);
+	ConstRow operator[](uint32 i) const;
+
+	Iterator begin();
+	Iterator end();
+	ConstIterator begin() const;
+	ConstIterator end() const;
+
+	static constexpr uint32 COLUMN_COUNT = sizeof...(Ts);
+	static constexpr uint32 COLUMN_ALIGN = 64;
+
+	template <typename R, typename Array>
+	class RowIt
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = R;
+		using difference_type = std::ptrdiff_t;
+		using reference = R;
+
+		RowIt()
+			: array(nullptr)
+			, index(0) {}
+
+		RowIt(Array* array, uint32 index)
+			: array(array)
+			, index(index) {}
+
+		R operator*() const { return (*array)[index]; }
+
+		RowIt& operator++()
+		{
+			++index;
+
+			return *this;
+		}
+
+		RowIt operator++(int)
+		{
+			RowIt previous = *this;
+			++index;
+
+			return previous;
+		}
+
+		friend bool operator==(const RowIt& a, const RowIt& b) { return a.index == b.index; }
+
+	private:
+		Array* array;
+		uint32 index;
+	};
+
+protected:
+	static_assert(sizeof...(Ts) > 0, "TSoAArray needs at least one column");
+	static_assert(((alignof(Ts) <= COLUMN_ALIGN) && ...), "Column types can't be aligned beyond COLUMN_ALIGN");
+
+	static uint64 ColumnSize(uint64 elementSize, uint32 capacity);
+	static uint64 AllocationSize(uint32 capacity);
+
+	bool EnsureCapacity(uint32 requiredCapacity);
+
+	template <size_t... Is>
+	void RelocateColumns(void* const* newColumns, IndexSequence<Is...>);
+	template <size_t... Is>
+	void CopyColumns(const TSoAArray& other, IndexSequence<Is...>);
+	template <size_t... Is>
+	void DestroyRows(uint32 start, uint32 count, IndexSequence<Is...>);
+	template <size_t... Is>
+	void DefaultConstructRows(uint32 start, uint32 count, IndexSequence<Is...>);
+	template <size_t... Is, typename... Args>
+	void ConstructRow(uint32 i, IndexSequence<Is...>, Args&&... values);
+	template <size_t... Is>
+	void MoveRow(uint32 dest, uint32 source, IndexSequence<Is...>);
+	template <size_t... Is>
+	Row GetRow(uint32 i, IndexSequence<Is...>);
+	template <size_t... Is>
+	ConstRow GetRow(uint32 i, IndexSequence<Is...>) const;
+
+	void Destroy();
+
+	IAllocator* alloc;
+	void* columns[COLUMN_COUNT];
+	uint32 length;
+	uint32 capacity;
+};
+
+template <typename... Ts>
+TSoAArray<Ts...>::TSoAArray()
+	: TSoAArray(DefAlloc()) {}
+
+template <typename... Ts>
+TSoAArray<Ts...>::TSoAArray(IAllocator* alloc)
+	: alloc(alloc)
+	, columns{}
+	, length(0)
+	, capacity(0) {}
+
+template <typename... Ts>
+TSoAArray<Ts...>::TSoAArray(uint32 initialCapacity, IAllocator* alloc)
+	: TSoAArray(alloc)
+{
+	Reserve(initialCapacity);
+}
+
+template <typename... Ts>
+TSoAArray<Ts...>::TSoAArray(const TSoAArray& other)
+	: TSoAArray(other.alloc)
+{
+	Reserve(other.length);
+	CopyColumns(other, Indices());
+	length = other.length;
+}
+
+template <typename... Ts>
+TSoAArray<Ts...>::TSoAArray(TSoAArray&& other) noexcept
+	: TSoAArray(other.alloc)
+{
+	for (uint32 i = 0; i < COLUMN_COUNT; ++i)
+	{
+		columns[i] = other.columns[i];
+		other.columns[i] = nullptr;
+	}
+
+	length = other.length;
+	capacity = other.capacity;
+	other.length = 0;
+	other.capacity = 0;
+}
+
+template <typename... Ts>
+TSoAArray<Ts...>::~TSoAArray()
+{
+	Destroy();
+}
+
+template <typename... Ts>
+template <typename... Args>
+void TSoAArray<Ts...>::Append(Args&&... values)
+{
+	static_assert(sizeof...(Args) == COLUMN_COUNT, "Append takes a value for every column");
+
+	if (length == capacity)
+	{
+		// The values may refer to rows of the array, so they are copied before growing moves them
+		std::tuple<Ts...> row(std::forward<Args>(values)...);
+
+		if (!EnsureCapacity(length + 1))
+			throw std::runtime_error("Failed to append in array because of limited capacity");
+
+		std::apply([this](Ts&... rowValues) { ConstructRow(length, Indices(), std::move(rowValues)...); }, row);
+	}
+	else
+		ConstructRow(length, Indices(), std::forward<Args>(values)...);
+
+	++length;
+}
+
+template <typename... Ts>
+void TSoAArray<Ts...>::RemoveAtSwap(uint32 index)
+{
+	if (index != length - 1)
+		MoveRow(index, length - 1, Indices());
+
+	DestroyRows(length - 1, 1, Indices());
+	--length;
+}
+
+template <typename... Ts>
+uint32 TSoAArray<Ts...>::Length() const
+{
+	return length;
+}
+
+template <typename... Ts>
+uint32 TSoAArray<Ts...>::Capacity() const
+{
+	return capacity;
+}
+
+template <typename... Ts>
+bool TSoAArray<Ts...>::IsEmpty() const
+{
+	return length == 0;
+}
+
+// New rows are default initialized, i.e. left uninitialized for trivial types
+template <typename... Ts>
+void TSoAArray<Ts...>::Resize(uint32 newLength)
+{
+	if (newLength < length)
+		DestroyRows(newLength, length - newLength, Indices());
+	else
+	{
+		if (!EnsureCapacity(newLength))
+			throw std::runtime_error("Failed to resize array because of limited capacity");
+
+		DefaultConstructRows(length, newLength - length, Indices());
+	}
+
+	length = newLength;
+}
+
+template <typename... Ts>
+void TSoAArray<Ts...>::Reserve(uint32 newCapacity)
+{
+	if (!EnsureCapacity(newCapacity))
+		throw std::runtime_error("Failed to reserve array capacity");
+}
+
+template <typename... Ts>
+void TSoAArray<Ts...>::Clear()
+{
+	DestroyRows(0, length, Indices());
+	length = 0;
+}
+
+template <typename... Ts>
+template <uint32 I>
+typename TSoAArray<Ts...>::template ColumnType<I>* TSoAArray<Ts...>::Data()
+{
+	return (ColumnType<I>*)columns[I];
+}
+
+template <typename... Ts>
+template <uint32 I>
+const typename TSoAArray<Ts...>::template ColumnType<I>* TSoAArray<Ts...>::Data() const
+{
+	return (const ColumnType<I>*)columns[I];
+}
+
+template <typename... Ts>
+template <uint32 I>
+std::span<typename TSoAArray<Ts...>::template ColumnType<I>> TSoAArray<Ts...>::Column()
+{
+	return { Data<I>(), length };
+}
+
+template <typename... Ts>
+template <uint32 I>
+std::span<const typename TSoAArray<Ts...>::template ColumnType<I>> TSoAArray<Ts...>::Column() const
+{
+	return { Data<I>(), length };
+}
+
+template <typename... Ts>
+template <uint32 I>
+typename TSoAArray<Ts...>::template ColumnType<I>& TSoAArray<Ts...>::Get(uint32 i)
+{
+	return Data<I>()[i];
+}
+
+template <typename... Ts>
+template <uint32 I>
+const typename TSoAArray<Ts...>::template ColumnType<I>& TSoAArray<Ts...>::Get(uint32 i) const
+{
+	return Data<I>()[i];
+}
+
+template <typename... Ts>
+typename TSoAArray<Ts...>::Row TSoAArray<Ts...>::operator[](uint32 i)
+{
+	return GetRow(i, Indices());
+}
+
+template <typename... Ts>
+typename TSoAArray<Ts...>::ConstRow TSoAArray<Ts...>::operator[](uint32 i) const
+{
+	return GetRow(i, Indices());
+}
+
+template <typename... Ts>
+typename TSoAArray<Ts...>::Iterator TSoAArray<Ts...>::begin()
+{
+	return Iterator(this, 0);
+}
+
+template <typename... Ts>
+typename TSoAArray<Ts...>::Iterator TSoAArray<Ts...>::end()
+{
+	return Iterator(this, length);
+}
+
+template <typename... Ts>
+typename TSoAArray<Ts...>::ConstIterator TSoAArray<Ts...>::begin() const
+{
+	return ConstIterator(this, 0);
+}
+
+template <typename... Ts>
+typename TSoAArray<Ts...>::ConstIterator TSoAArray<Ts...>::end() const
+{
+	return ConstIterator(this, length);
+}
+
+template <typename... Ts>
+uint64 TSoAArray<Ts...>::ColumnSize(uint64 elementSize, uint32 capacity)
+{
+	return (elementSize * capacity + COLUMN_ALIGN - 1) / COLUMN_ALIGN * COLUMN_ALIGN;
+}
+
+template <typename... Ts>
+uint64 TSoAArray<Ts...>::AllocationSize(uint32 capacity)
+{
+	return (ColumnSize(sizeof(Ts), capacity) + ...);
+}
+
+template <typename... Ts>
+bool TSoAArray<Ts...>::EnsureCapacity(uint32 requiredCapacity)
+{
+	if (requiredCapacity <= capacity)
+		return true;
+
+	if (!alloc)
+		return false;
+
+	uint32 exponentiallyIncreasedSize = (uint32)((float)(capacity == 0 ? 4 : capacity) * 1.5f);
+	uint32 newCapacity = requiredCapacity <= exponentiallyIncreasedSize ? exponentiallyIncreasedSize : requiredCapacity;
+	char* memory = (char*)alloc->Allocate(AllocationSize(newCapacity), COLUMN_ALIGN);
+	void* newColumns[COLUMN_COUNT];
+	uint64 elementSizes[COLUMN_COUNT] = { sizeof(Ts)... };
+
+	for (uint32 i = 0; i < COLUMN_COUNT; ++i)
+	{
+		newColumns[i] = memory;
+		memory += ColumnSize(elementSizes[i], newCapacity);
+	}
+
+	RelocateColumns(newColumns, Indices());
+
+	if (columns[0])
+		alloc->Free(columns[0], AllocationSize(capacity));
+
+	for (uint32 i = 0; i < COLUMN_COUNT; ++i)
+		columns[i] = newColumns[i];
+
+	capacity = newCapacity;
+
+	return true;
+}
+
+template <typename... Ts>
+template <size_t... Is>
+void TSoAArray<Ts...>::RelocateColumns(void* const* newColumns, IndexSequence<Is...>)
+{
+	(Internal::Memory::RelocateElements((ColumnType<Is>*)newColumns[Is], Data<Is>(), length), ...);
+}
+
+template <typename... Ts>
+template <size_t... Is>
+void TSoAArray<Ts...>::CopyColumns(const TSoAArray& other, IndexSequence<Is...>)
+{
+	(Internal::Memory::CopyConstructElements(Data<Is>(), other.Data<Is>(), other.length), ...);
+}
+
+template <typename... Ts>
+template <size_t... Is>
+void TSoAArray<Ts...>::DestroyRows(uint32 start, uint32 count, IndexSequence<Is...>)
+{
+	(Internal::Memory::DestroyElements(Data<Is>() + start, count), ...);
+}
+
+template <typename... Ts>
+template <size_t... Is>
+void TSoAArray<Ts...>::DefaultConstructRows(uint32 start, uint32 count, IndexSequence<Is...>)
+{
+	(Internal::Memory::DefaultConstructElements(Data<Is>() + start, count), ...);
+}
+
+template <typename... Ts>
+template <size_t... Is, typename... Args>
+void TSoAArray<Ts...>::ConstructRow(uint32 i, IndexSequence<Is...>, Args&&... values)
+{
+	(new (&Data<Is>()[i]) ColumnType<Is>(std::forward<Args>(values)), ...);
+}
+
+template <typename... Ts>
+template <size_t... Is>
+void TSoAArray<Ts...>::MoveRow(uint32 dest, uint32 source, IndexSequence<Is...>)
+{
+	((Data<Is>()[dest] = std::move(Data<Is>()[source])), ...);
+}
+
+template <typename... Ts>
+template <size_t... Is>
+typename TSoAArray<Ts...>::Row TSoAArray<Ts...>::GetRow(uint32 i, IndexSequence<Is...>)
+{
+	return Row(Data<Is>()[i]...);
+}
+
+template <typename... Ts>
+template <size_t... Is>
+typename TSoAArray<Ts...>::ConstRow TSoAArray<Ts...>::GetRow(uint32 i, IndexSequence<Is...>) const
+{
+	return ConstRow(Data<Is>()[i]...);
+}
+
+template <typename... Ts>
+void TSoAArray<Ts...>::Destroy()
+{
+	DestroyRows(0, length, Indices());
+
+	if (columns[0])
+		alloc->Free(columns[0], AllocationSize(capacity));
+}
+}
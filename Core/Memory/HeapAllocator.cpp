@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 #include "HeapAllocator.h"
 #include "../Utility.h"
 
@@ -12,12 +13,11 @@ HeapAllocator::~HeapAllocator()
 		Utility::DebugOutput("Not all allocations freed in heap allocator");
 }
 
-void* HeapAllocator::AllocateInternal(uint64 size, uint8_t align)
+void* HeapAllocator::AllocateInternal(uint64 size, uint32 align)
 {
 	uint64 totalSize = SizeWithHeaderAndAlignment(size, align);
-	Header* header = (Header*)malloc(totalSize);
-
-	WriteAllocHeader(header, totalSize, align);
+	void* allocationPtr = malloc(totalSize);
+	Header* header = WriteAllocHeader(allocationPtr, size, align);
 
 	totalAllocatedSize += totalSize;
 	allocatedSize += size;
@@ -29,13 +29,20 @@ void* HeapAllocator::AllocateInternal(uint64 size, uint8_t align)
 void* HeapAllocator::ReallocateInternal(void* ptr, uint64 size)
 {
 	Header* header = GetHeader(ptr);
-	uint8_t align = header->align;
-	uint64 oldTotalSize = header->totalSize;
+	uint32 align = header->align;
+	uint32 oldOffset = header->offset;
 	uint64 oldAllocationSize = GetAllocationSize(header);
+	uint64 oldTotalSize = SizeWithHeaderAndAlignment(oldAllocationSize, align);
 	uint64 newTotalSize = SizeWithHeaderAndAlignment(size, align);
 
-	header = (Header*)realloc(header, newTotalSize);
-	WriteAllocHeader(header, newTotalSize, align);
+	char* allocationPtr = (char*)realloc(GetAllocationPtr(header), newTotalSize);
+	char* dataPtr = (char*)NextAlign(allocationPtr + sizeof(Header), align);
+
+	// realloc keeps the data at the old offset, which may not be aligned anymore from the new address
+	if (dataPtr != allocationPtr + oldOffset)
+		memmove(dataPtr, allocationPtr + oldOffset, oldAllocationSize < size ? oldAllocationSize : size);
+
+	header = WriteAllocHeader(allocationPtr, size, align);
 
 	totalAllocatedSize += newTotalSize - oldTotalSize;
 	allocatedSize += size - oldAllocationSize;
@@ -48,58 +55,56 @@ void HeapAllocator::FreeInternal(void* ptr)
 	Header* header = GetHeader(ptr);
 	uint64 allocationSize = GetAllocationSize(header);
 
-	totalAllocatedSize -= header->totalSize;
+	totalAllocatedSize -= SizeWithHeaderAndAlignment(allocationSize, header->align);
 	allocatedSize -= allocationSize;
 	--allocationCount;
 
-	free(header);
+	free(GetAllocationPtr(header));
 }
 
 namespace Internal::Memory
 {
-uint64 SizeWithHeaderAndAlignment(uint64 sizeWithoutHeader, uint8_t align)
+uint64 SizeWithHeaderAndAlignment(uint64 sizeWithoutHeader, uint32 align)
 {
-	return sizeWithoutHeader + sizeof(Header) + align;
+	// malloc already aligns the header so padding is only needed for stricter alignments
+	uint64 padding = align > MALLOC_ALIGN ? align - MALLOC_ALIGN : 0;
+
+	return sizeWithoutHeader + sizeof(Header) + padding;
 }
 
-void WriteAllocHeader(void* headerPtr, uint64 sizeWithHeader, uint8_t align)
+Header* WriteAllocHeader(void* allocationPtr, uint64 size, uint32 align)
 {
-	Header* header = (Header*)headerPtr;
-	char* iterator = (char*)header + sizeof(Header);
+	char* dataPtr = (char*)NextAlign((char*)allocationPtr + sizeof(Header), align);
+	Header* header = (Header*)(dataPtr - sizeof(Header));
 
-	header->totalSize = sizeWithHeader;
+	header->size = size;
 	header->align = align;
+	header->offset = (uint32)(dataPtr - (char*)allocationPtr);
 
-	while ((uintptr_t)iterator % align)
-	{
-		*iterator = Header::PAD_VALUE;
-		++iterator;
-	}
+	return header;
 }
 
 Header* GetHeader(void* dataPtr)
 {
-	char* iterator = (char*)dataPtr;
-
-	while (*(iterator - 1) == Header::PAD_VALUE)
-		--iterator;
-
-	return (Header*)(iterator - sizeof(Header));
+	return (Header*)((char*)dataPtr - sizeof(Header));
 }
 
 uint64 GetAllocationSize(const Header* header)
 {
-	return header->totalSize - header->align - sizeof(Header);
+	return header->size;
 }
 
-void* GetDataPtr(Header* headerPtr)
+void* GetAllocationPtr(Header* header)
 {
-	void* ptrStart = (char*)headerPtr + sizeof(Header);
+	return (char*)GetDataPtr(header) - header->offset;
+}
 
-	return NextAlign(ptrStart, headerPtr->align);
+void* GetDataPtr(Header* headerPtr)
+{
+	return (char*)headerPtr + sizeof(Header);
 }
 
-void* NextAlign(void* ptr, uint8_t align)
+void* NextAlign(void* ptr, uint32 align)
 {
 	uintptr_t alignError = (uintptr_t)ptr % align;
 	uintptr_t offset = alignError ? align - alignError : 0;
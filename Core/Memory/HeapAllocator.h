@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include "IAllocator.h"
 
 namespace ducklib
@@ -8,26 +9,32 @@ class HeapAllocator final : public IAllocator
 public:
 	~HeapAllocator() override;
 
-	void* AllocateInternal(uint64 size, uint8_t align) override;
+	void* AllocateInternal(uint64 size, uint32 align) override;
 	void* ReallocateInternal(void* ptr, uint64 size) override;
 	void FreeInternal(void* ptr) override;
 };
 
 namespace Internal::Memory
 {
+// Written directly before the data so that it can be found with a single subtraction
 struct Header
 {
-	uint64 totalSize;
-	uint8_t align;
-
-	static constexpr char PAD_VALUE = -1;
+	uint64 size;
+	uint32 align;
+	uint32 offset; // From the start of the underlying allocation to the data
 };
 
-uint64 SizeWithHeaderAndAlignment(uint64 sizeWithoutHeader, uint8_t align);
-void WriteAllocHeader(void* headerPtr, uint64 sizeWithHeader, uint8_t align);
+// Alignment malloc guarantees without any padding
+constexpr uint32 MALLOC_ALIGN = alignof(std::max_align_t);
+
+static_assert(sizeof(Header) % MALLOC_ALIGN == 0, "Header has to keep malloc alignment");
+
+uint64 SizeWithHeaderAndAlignment(uint64 sizeWithoutHeader, uint32 align);
+Header* WriteAllocHeader(void* allocationPtr, uint64 size, uint32 align);
 Header* GetHeader(void* dataPtr);
 uint64 GetAllocationSize(const Header* header);
+void* GetAllocationPtr(Header* header);
 void* GetDataPtr(Header* headerPtr);
-void* NextAlign(void* ptr, uint8_t align);
+void* NextAlign(void* ptr, uint32 align);
 }
 }
@@ -0,0 +1,418 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include "HeapProfiler.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <DbgHelp.h>
+#pragma comment(lib, "Dbghelp.lib")
+#else
+#include <cstdlib>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#endif
+
+namespace ducklib
+{
+using namespace Internal::Memory;
+
+namespace
+{
+// Frames of the profiler and IAllocator itself
+constexpr uint32 SKIP_FRAME_COUNT = 3;
+constexpr uint32 SYMBOL_NAME_SIZE = 256;
+
+std::atomic<uint32> currentGeneration = 0;
+
+thread_local int64 bytesUntilSample = 0;
+thread_local uint32 sampleGeneration = 0;
+thread_local uint64 randomState = 0;
+
+uint64 NextRandom()
+{
+	if (randomState == 0)
+		randomState = (uint64)(uintptr_t)&randomState | 1;
+
+	// xorshift64*
+	randomState ^= randomState >> 12;
+	randomState ^= randomState << 25;
+	randomState ^= randomState >> 27;
+
+	return randomState * 0x2545F4914F6CDD1Dull;
+}
+
+int64 NextSampleDistance(uint64 sampleInterval)
+{
+	// Exponentially distributed distances make sampling a Poisson process over the allocated bytes
+	double uniform = (double)(NextRandom() >> 11) * (1.0 / (double)(1ull << 53));
+
+	return (int64)(-std::log(1.0 - uniform) * (double)sampleInterval) + 1;
+}
+
+uint64 HashStack(void* const* stack, uint32 stackDepth)
+{
+	uint64 hash = 0xCBF29CE484222325ull;
+
+	for (uint32 i = 0; i < stackDepth; ++i)
+		hash = (hash ^ (uint64)(uintptr_t)stack[i]) * 0x100000001B3ull;
+
+	return hash;
+}
+
+FILE* OpenFile(const char* path)
+{
+#ifdef _WIN32
+	FILE* file;
+
+	return fopen_s(&file, path, "w") == 0 ? file : nullptr;
+#else
+	return fopen(path, "w");
+#endif
+}
+}
+
+HeapProfiler& GetHeapProfiler()
+{
+	// Never destroyed since allocators keep reporting frees during static destruction
+	alignas(HeapProfiler) static char storage[sizeof(HeapProfiler)];
+	static HeapProfiler* heapProfiler = new (storage) HeapProfiler();
+
+	return *heapProfiler;
+}
+
+HeapProfiler::HeapProfiler()
+	: running(false)
+	, sampleInterval(DEFAULT_SAMPLE_INTERVAL)
+	, sampledFilter{} {}
+
+void HeapProfiler::Start(uint64 sampleInterval)
+{
+	this->sampleInterval = sampleInterval;
+	++currentGeneration;
+	running = true;
+}
+
+void HeapProfiler::Stop()
+{
+	// Frees of already sampled allocations are still recorded
+	running = false;
+}
+
+void HeapProfiler::Reset()
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	for (const auto& [ptr, sample] : liveSamples)
+		--sampledFilter[FilterIndex(ptr)];
+
+	sites.clear();
+	siteIndices.clear();
+	liveSamples.clear();
+}
+
+bool HeapProfiler::IsRunning() const
+{
+	return running.load(std::memory_order_relaxed);
+}
+
+uint64 HeapProfiler::SampleInterval() const
+{
+	return sampleInterval.load(std::memory_order_relaxed);
+}
+
+DL_NOINLINE void HeapProfiler::RecordAllocation(void* ptr, uint64 size)
+{
+	if (!running.load(std::memory_order_relaxed) || !ptr)
+		return;
+
+	uint64 interval = sampleInterval.load(std::memory_order_relaxed);
+	uint32 generation = currentGeneration.load(std::memory_order_relaxed);
+
+	if (sampleGeneration != generation)
+	{
+		sampleGeneration = generation;
+		bytesUntilSample = NextSampleDistance(interval);
+	}
+
+	bytesUntilSample -= (int64)size;
+
+	if (bytesUntilSample > 0)
+		return;
+
+	bytesUntilSample = NextSampleDistance(interval);
+
+	void* stack[HeapProfileSite::MAX_STACK_DEPTH];
+	uint32 stackDepth = CaptureStack(stack, HeapProfileSite::MAX_STACK_DEPTH, SKIP_FRAME_COUNT);
+	double estimatedSize = EstimateSize(size);
+
+	std::lock_guard<std::mutex> guard(lock);
+	uint32 siteIndex = FindOrAddSite(stack, stackDepth);
+	HeapProfileSite& site = sites[siteIndex];
+
+	++site.allocCount;
+	site.allocSize += size;
+	++site.inUseCount;
+	site.inUseSize += size;
+	site.estimatedAllocSize += estimatedSize;
+	site.estimatedInUseSize += estimatedSize;
+
+	auto [it, inserted] = liveSamples.insert({ ptr, { siteIndex, size } });
+
+	if (inserted)
+		++sampledFilter[FilterIndex(ptr)];
+	else
+		it->second = { siteIndex, size };
+}
+
+void HeapProfiler::RecordFree(void* ptr)
+{
+	if (sampledFilter[FilterIndex(ptr)].load(std::memory_order_relaxed) == 0)
+		return;
+
+	std::lock_guard<std::mutex> guard(lock);
+	auto it = liveSamples.find(ptr);
+
+	if (it == liveSamples.end())
+		return;
+
+	HeapProfileSite& site = sites[it->second.siteIndex];
+	uint64 size = it->second.size;
+
+	--site.inUseCount;
+	site.inUseSize -= size;
+	site.estimatedInUseSize -= EstimateSize(size);
+
+	if (site.inUseCount == 0)
+		site.estimatedInUseSize = 0.0;
+
+	--sampledFilter[FilterIndex(ptr)];
+	liveSamples.erase(it);
+}
+
+const HeapProfileSite* HeapProfiler::GetSites()
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	snapshot = sites;
+
+	return snapshot.data();
+}
+
+uint32 HeapProfiler::GetSiteCount()
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	return (uint32)sites.size();
+}
+
+bool HeapProfiler::WritePprof(const char* path)
+{
+	FILE* file = OpenFile(path);
+
+	if (!file)
+		return false;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		uint64 totals[4] = {};
+
+		for (const HeapProfileSite& site : sites)
+		{
+			totals[0] += site.inUseCount;
+			totals[1] += site.inUseSize;
+			totals[2] += site.allocCount;
+			totals[3] += site.allocSize;
+		}
+
+		// pprof scales the sampled values back up using the interval in the header
+		fprintf(
+			file,
+			"heap profile: %llu: %llu [%llu: %llu] @ heap_v2/%llu\n",
+			(unsigned long long)totals[0],
+			(unsigned long long)totals[1],
+			(unsigned long long)totals[2],
+			(unsigned long long)totals[3],
+			(unsigned long long)sampleInterval.load());
+
+		for (const HeapProfileSite& site : sites)
+		{
+			fprintf(
+				file,
+				"%llu: %llu [%llu: %llu] @",
+				(unsigned long long)site.inUseCount,
+				(unsigned long long)site.inUseSize,
+				(unsigned long long)site.allocCount,
+				(unsigned long long)site.allocSize);
+
+			for (uint32 i = 0; i < site.stackDepth; ++i)
+				fprintf(file, " 0x%llx", (unsigned long long)(uintptr_t)site.stack[i]);
+
+			fprintf(file, "\n");
+		}
+	}
+
+#ifndef _WIN32
+	if (FILE* maps = fopen("/proc/self/maps", "r"))
+	{
+		char buffer[4096];
+		size_t readSize;
+
+		fprintf(file, "\nMAPPED_LIBRARIES:\n");
+
+		while ((readSize = fread(buffer, 1, sizeof(buffer), maps)) > 0)
+			fwrite(buffer, 1, readSize, file);
+
+		fclose(maps);
+	}
+#endif
+
+	return fclose(file) == 0;
+}
+
+bool HeapProfiler::WriteCollapsedStacks(const char* path, HeapProfileView view)
+{
+	FILE* file = OpenFile(path);
+
+	if (!file)
+		return false;
+
+	std::lock_guard<std::mutex> guard(lock);
+	char name[SYMBOL_NAME_SIZE];
+
+	for (const HeapProfileSite& site : sites)
+	{
+		double size = view == HeapProfileView::IN_USE ? site.estimatedInUseSize : site.estimatedAllocSize;
+
+		if (size < 0.5)
+			continue;
+
+		for (uint32 i = site.stackDepth; i > 0; --i)
+		{
+			GetSymbolName(site.stack[i - 1], name, SYMBOL_NAME_SIZE);
+
+			// Semicolons separate frames
+			for (char* c = name; *c; ++c)
+			{
+				if (*c == ';')
+					*c = ':';
+			}
+
+			fprintf(file, i == site.stackDepth ? "%s" : ";%s", name);
+		}
+
+		fprintf(file, " %llu\n", (unsigned long long)std::llround(size));
+	}
+
+	return fclose(file) == 0;
+}
+
+uint32 HeapProfiler::FindOrAddSite(void* const* stack, uint32 stackDepth)
+{
+	uint64 hash = HashStack(stack, stackDepth);
+
+	// Colliding hashes probe to the next one
+	for (;; ++hash)
+	{
+		auto it = siteIndices.find(hash);
+
+		if (it == siteIndices.end())
+			break;
+
+		const HeapProfileSite& site = sites[it->second];
+
+		if (site.stackDepth == stackDepth && memcmp(site.stack, stack, stackDepth * sizeof(void*)) == 0)
+			return it->second;
+	}
+
+	HeapProfileSite site = {};
+	memcpy(site.stack, stack, stackDepth * sizeof(void*));
+	site.stackDepth = stackDepth;
+
+	uint32 siteIndex = (uint32)sites.size();
+	sites.push_back(site);
+	siteIndices[hash] = siteIndex;
+
+	return siteIndex;
+}
+
+double HeapProfiler::EstimateSize(uint64 size) const
+{
+	// An allocation of the given size is sampled with probability 1 - e^(-size / interval)
+	double probability = 1.0 - std::exp(-(double)size / (double)sampleInterval.load(std::memory_order_relaxed));
+
+	return probability > 0.0 ? (double)size / probability : 0.0;
+}
+
+uint32 HeapProfiler::FilterIndex(const void* ptr)
+{
+	return (uint32)(((uint64)(uintptr_t)ptr * 0x9E3779B97F4A7C15ull) >> 50) & (FILTER_SIZE - 1);
+}
+
+namespace Internal::Memory
+{
+DL_NOINLINE uint32 CaptureStack(void** frames, uint32 maxDepth, uint32 skipCount)
+{
+#ifdef _WIN32
+	return RtlCaptureStackBackTrace(skipCount, maxDepth, frames, nullptr);
+#else
+	void* allFrames[HeapProfileSite::MAX_STACK_DEPTH + SKIP_FRAME_COUNT + 1];
+	uint32 maxAllDepth = sizeof(allFrames) / sizeof(allFrames[0]);
+	int depth = backtrace(allFrames, (int)(maxDepth + skipCount < maxAllDepth ? maxDepth + skipCount : maxAllDepth));
+
+	if (depth <= (int)skipCount)
+		return 0;
+
+	uint32 frameCount = (uint32)depth - skipCount < maxDepth ? (uint32)depth - skipCount : maxDepth;
+	memcpy(frames, allFrames + skipCount, frameCount * sizeof(void*));
+
+	return frameCount;
+#endif
+}
+
+void GetSymbolName(void* address, char* name, uint32 nameSize)
+{
+#ifdef _WIN32
+	static std::once_flag symInitFlag;
+	static std::mutex symLock;
+	HANDLE process = GetCurrentProcess();
+
+	std::call_once(symInitFlag, [process]
+	{
+		SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS);
+		SymInitialize(process, nullptr, TRUE);
+	});
+
+	// DbgHelp is single threaded
+	std::lock_guard<std::mutex> guard(symLock);
+	char symbolBuffer[sizeof(SYMBOL_INFO) + SYMBOL_NAME_SIZE];
+	SYMBOL_INFO* symbol = (SYMBOL_INFO*)symbolBuffer;
+
+	symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+	symbol->MaxNameLen = SYMBOL_NAME_SIZE;
+
+	if (SymFromAddr(process, (DWORD64)address, nullptr, symbol))
+	{
+		snprintf(name, nameSize, "%s", symbol->Name);
+		return;
+	}
+#else
+	Dl_info info;
+
+	if (dladdr(address, &info) && info.dli_sname)
+	{
+		int status;
+		char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+
+		snprintf(name, nameSize, "%s", status == 0 ? demangled : info.dli_sname);
+		free(demangled);
+		return;
+	}
+#endif
+
+	snprintf(name, nameSize, "0x%llx", (unsigned long long)(uintptr_t)address);
+}
+}
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "../Types.h"
+
+// The profiler skips a fixed number of its own frames, so the functions it counts on mustn't get inlined
+#ifdef _MSC_VER
+#define DL_NOINLINE __declspec(noinline)
+#else
+#define DL_NOINLINE __attribute__((noinline))
+#endif
+
+namespace ducklib
+{
+class HeapProfiler;
+
+HeapProfiler& GetHeapProfiler();
+
+enum class HeapProfileView
+{
+	IN_USE,
+	ALLOCATED,
+};
+
+struct HeapProfileSite
+{
+	static constexpr uint32 MAX_STACK_DEPTH = 32;
+
+	// Innermost frame first
+	void* stack[MAX_STACK_DEPTH];
+	uint32 stackDepth;
+
+	// Counts and sizes of the sampled allocations only
+	uint64 allocCount;
+	uint64 allocSize;
+	uint64 inUseCount;
+	uint64 inUseSize;
+
+	// Sampled sizes scaled up by how likely each allocation was to be sampled
+	double estimatedAllocSize;
+	double estimatedInUseSize;
+};
+
+/**
+ * Sampling heap profiler that is cheap enough to leave running in release builds. Every allocator reports its
+ * allocations here, and when running, one allocation per SampleInterval() bytes on average has its call stack captured.
+ * Samples are aggregated by call stack and can be written as a pprof heap profile or as collapsed stacks for flame
+ * graphs.
+ *
+ * The distance between samples is randomized so that regular allocation patterns don't skew the results. Freeing
+ * memory that wasn't sampled only costs a lookup into a small counter table.
+ */
+class HeapProfiler
+{
+public:
+	HeapProfiler();
+
+	HeapProfiler(const HeapProfiler&) = delete;
+	HeapProfiler& operator=(const HeapProfiler&) = delete;
+
+	void Start(uint64 sampleInterval = DEFAULT_SAMPLE_INTERVAL);
+	void Stop();
+	void Reset();
+
+	bool IsRunning() const;
+	uint64 SampleInterval() const;
+
+	void RecordAllocation(void* ptr, uint64 size);
+	void RecordFree(void* ptr);
+
+	// Gathers a snapshot of all call sites, valid until the next call to GetSites()
+	const HeapProfileSite* GetSites();
+	uint32 GetSiteCount();
+
+	/**
+	 * Writes the samples in the legacy pprof heap profile format, readable with e.g. `pprof <binary> <file>`. On
+	 * platforms with /proc/self/maps the memory mappings are included for symbolization.
+	 */
+	bool WritePprof(const char* path);
+
+	/**
+	 * Writes one line per call site with the symbolized frames separated by semicolons, outermost first, followed by the
+	 * estimated size in bytes. This is the input format of flamegraph.pl and most other flame graph tools.
+	 */
+	bool WriteCollapsedStacks(const char* path, HeapProfileView view = HeapProfileView::IN_USE);
+
+	static constexpr uint64 DEFAULT_SAMPLE_INTERVAL = 512 * 1024;
+	static constexpr uint32 FILTER_SIZE = 1 << 14;
+
+protected:
+	struct LiveSample
+	{
+		uint32 siteIndex;
+		uint64 size;
+	};
+
+	uint32 FindOrAddSite(void* const* stack, uint32 stackDepth);
+	double EstimateSize(uint64 size) const;
+
+	static uint32 FilterIndex(const void* ptr);
+
+	std::atomic<bool> running;
+	std::atomic<uint64> sampleInterval;
+
+	// Counts of live samples per pointer hash so that frees can skip locking when the pointer can't have been sampled
+	std::atomic<uint16> sampledFilter[FILTER_SIZE];
+
+	std::mutex lock;
+	std::vector<HeapProfileSite> sites;
+	std::unordered_map<uint64, uint32> siteIndices;
+	std::unordered_map<void*, LiveSample> liveSamples;
+	std::vector<HeapProfileSite> snapshot;
+};
+
+namespace Internal::Memory
+{
+uint32 CaptureStack(void** frames, uint32 maxDepth, uint32 skipCount);
+void GetSymbolName(void* address, char* name, uint32 nameSize);
+}
+}
@@ -0,0 +1,372 @@
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include "HugePageAllocator.h"
+#include "HeapAllocator.h"
+#include "../Utility.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ducklib
+{
+using namespace Internal::Memory;
+
+namespace
+{
+HugePageHeader* GetHugePageHeader(void* ptr)
+{
+	return (HugePageHeader*)ptr - 1;
+}
+
+#ifndef _WIN32
+// Sums the AnonHugePages of the mappings that overlap the large allocations
+uint64 GetTransparentHugePageSize(const LargeAllocation* allocations)
+{
+	FILE* smaps = fopen("/proc/self/smaps", "r");
+
+	if (!smaps)
+		return 0;
+
+	char line[512];
+	bool overlaps = false;
+	uint64 size = 0;
+
+	while (fgets(line, sizeof(line), smaps))
+	{
+		unsigned long long start;
+		unsigned long long end;
+		unsigned long long hugePageKiB;
+
+		if (sscanf(line, "%llx-%llx ", &start, &end) == 2)
+		{
+			overlaps = false;
+
+			for (const LargeAllocation* allocation = allocations; allocation; allocation = allocation->next)
+			{
+				uintptr_t allocationStart = (uintptr_t)allocation;
+
+				if (allocationStart < end && allocationStart + allocation->mappedSize > start)
+				{
+					overlaps = true;
+					break;
+				}
+			}
+		}
+		else if (overlaps && sscanf(line, "AnonHugePages: %llu kB", &hugePageKiB) == 1)
+			size += hugePageKiB * 1024;
+	}
+
+	fclose(smaps);
+
+	return size;
+}
+#endif
+}
+
+HugePageAllocator::HugePageAllocator(uint64 largeThreshold, bool bindToLocalNode, IAllocator* backingAlloc)
+	: backingAlloc(backingAlloc)
+	, largeThreshold(largeThreshold)
+	, bindToLocalNode(bindToLocalNode)
+	, largeAllocations(nullptr)
+	, atomicTotalAllocatedSize(0)
+	, atomicAllocatedSize(0)
+	, atomicAllocationCount(0) {}
+
+HugePageAllocator::~HugePageAllocator()
+{
+	if (atomicTotalAllocatedSize > 0 || atomicAllocatedSize > 0)
+		Utility::DebugOutput("Not all allocations freed in huge page allocator");
+}
+
+HugePageStats HugePageAllocator::GetHugePageStats()
+{
+	std::lock_guard<std::mutex> guard(largeLock);
+	HugePageStats stats = {};
+
+	for (const LargeAllocation* allocation = largeAllocations; allocation; allocation = allocation->next)
+	{
+		++stats.largeAllocationCount;
+		stats.mappedSize += allocation->mappedSize;
+
+		if (allocation->explicitHugePages)
+			stats.explicitHugePageSize += allocation->mappedSize;
+
+		if (allocation->numaBound)
+			++stats.numaBoundCount;
+	}
+
+#ifndef _WIN32
+	stats.transparentHugePageSize = GetTransparentHugePageSize(largeAllocations);
+#endif
+
+	return stats;
+}
+
+AllocatorStats HugePageAllocator::GetStats() const
+{
+	return { atomicTotalAllocatedSize.load(), atomicAllocatedSize.load(), atomicAllocationCount.load() };
+}
+
+void* HugePageAllocator::AllocateInternal(uint64 size, uint32 align)
+{
+	if (size >= largeThreshold)
+		return AllocateLarge(size, align);
+
+	// Keeping the data at an offset of a multiple of the alignment keeps it aligned through reallocations, too
+	uint32 offset = (uint32)(uintptr_t)NextAlign((void*)sizeof(HugePageHeader), align);
+	uint32 allocationAlign = align > alignof(HugePageHeader) ? align : alignof(HugePageHeader);
+	char* dataPtr = (char*)backingAlloc->Allocate(size + offset, allocationAlign) + offset;
+	HugePageHeader* header = GetHugePageHeader(dataPtr);
+
+	header->size = size;
+	header->offset = offset;
+	header->align = align;
+	header->isLarge = false;
+
+	atomicTotalAllocatedSize += size + offset;
+	atomicAllocatedSize += size;
+	++atomicAllocationCount;
+
+	return dataPtr;
+}
+
+void* HugePageAllocator::ReallocateInternal(void* ptr, uint64 size)
+{
+	HugePageHeader* header = GetHugePageHeader(ptr);
+	uint64 oldSize = header->size;
+
+	if (header->isLarge)
+	{
+		LargeAllocation* allocation = (LargeAllocation*)((char*)ptr - header->offset);
+
+		// Shrinking large allocations keeps them large so they don't bounce between the two
+		if (header->offset + size <= allocation->mappedSize)
+		{
+			header->size = size;
+			atomicAllocatedSize += size - oldSize;
+
+			return ptr;
+		}
+	}
+	else if (size < largeThreshold)
+	{
+		uint32 offset = header->offset;
+		char* dataPtr = (char*)backingAlloc->Reallocate((char*)ptr - offset, size + offset) + offset;
+
+		GetHugePageHeader(dataPtr)->size = size;
+		atomicTotalAllocatedSize += size - oldSize;
+		atomicAllocatedSize += size - oldSize;
+
+		return dataPtr;
+	}
+
+	void* newPtr = AllocateInternal(size, header->align);
+
+	memcpy(newPtr, ptr, oldSize < size ? oldSize : size);
+	FreeInternal(ptr);
+
+	return newPtr;
+}
+
+void HugePageAllocator::FreeInternal(void* ptr)
+{
+	HugePageHeader* header = GetHugePageHeader(ptr);
+
+	if (header->isLarge)
+	{
+		atomicAllocatedSize -= header->size;
+		FreeLarge((LargeAllocation*)((char*)ptr - header->offset));
+
+		return;
+	}
+
+	atomicTotalAllocatedSize -= header->size + header->offset;
+	atomicAllocatedSize -= header->size;
+	--atomicAllocationCount;
+
+	backingAlloc->Free((char*)ptr - header->offset);
+}
+
+void* HugePageAllocator::AllocateLarge(uint64 size, uint32 align)
+{
+	uint64 maxOffset = sizeof(LargeAllocation) + sizeof(HugePageHeader) + align;
+	uint64 mappedSize = (maxOffset + size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+	int32 numaNode = bindToLocalNode ? GetCurrentNumaNode() : -1;
+	bool explicitHugePages;
+	bool numaBound;
+	char* base = (char*)MapHugePages(mappedSize, numaNode, explicitHugePages, numaBound);
+
+	if (!base)
+		throw std::runtime_error("Failed to map huge pages");
+
+	char* dataPtr = (char*)NextAlign(base + sizeof(LargeAllocation) + sizeof(HugePageHeader), align);
+	HugePageHeader* header = GetHugePageHeader(dataPtr);
+	LargeAllocation* allocation = (LargeAllocation*)base;
+
+	header->size = size;
+	header->offset = (uint32)(dataPtr - base);
+	header->align = align;
+	header->isLarge = true;
+
+	allocation->prev = nullptr;
+	allocation->mappedSize = mappedSize;
+	allocation->explicitHugePages = explicitHugePages;
+	allocation->numaBound = numaBound;
+
+	{
+		std::lock_guard<std::mutex> guard(largeLock);
+
+		allocation->next = largeAllocations;
+
+		if (largeAllocations)
+			largeAllocations->prev = allocation;
+
+		largeAllocations = allocation;
+	}
+
+	atomicTotalAllocatedSize += mappedSize;
+	atomicAllocatedSize += size;
+	++atomicAllocationCount;
+
+	return dataPtr;
+}
+
+void HugePageAllocator::FreeLarge(LargeAllocation* allocation)
+{
+	uint64 mappedSize = allocation->mappedSize;
+
+	{
+		std::lock_guard<std::mutex> guard(largeLock);
+
+		if (allocation->prev)
+			allocation->prev->next = allocation->next;
+		else
+			largeAllocations = allocation->next;
+
+		if (allocation->next)
+			allocation->next->prev = allocation->prev;
+	}
+
+	atomicTotalAllocatedSize -= mappedSize;
+	--atomicAllocationCount;
+
+	UnmapHugePages(allocation, mappedSize);
+}
+
+namespace Internal::Memory
+{
+void* MapHugePages(uint64 size, int32 numaNode, bool& explicitHugePages, bool& numaBound)
+{
+#ifdef _WIN32
+	DWORD node = numaNode >= 0 ? (DWORD)numaNode : NUMA_NO_PREFERRED_NODE;
+	SIZE_T largePageMinimum = GetLargePageMinimum();
+	void* ptr = nullptr;
+
+	// Large pages need the lock pages in memory privilege, without it this fails and normal pages are used
+	if (largePageMinimum && size % largePageMinimum == 0)
+		ptr = VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, node);
+
+	explicitHugePages = ptr != nullptr;
+
+	if (!ptr)
+		ptr = VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+
+	numaBound = ptr && numaNode >= 0;
+
+	return ptr;
+#else
+	char* ptr = nullptr;
+
+	explicitHugePages = false;
+	numaBound = false;
+
+#ifdef MAP_HUGETLB
+	void* hugePtr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+	if (hugePtr != MAP_FAILED)
+	{
+		ptr = (char*)hugePtr;
+		explicitHugePages = true;
+	}
+#endif
+
+	if (!ptr)
+	{
+		// Transparent huge pages need the range to be huge page aligned, so map extra and trim the ends
+		uint64 mapSize = size + HugePageAllocator::HUGE_PAGE_SIZE;
+		char* mapPtr = (char*)mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (mapPtr == MAP_FAILED)
+			return nullptr;
+
+		ptr = (char*)NextAlign(mapPtr, (uint32)HugePageAllocator::HUGE_PAGE_SIZE);
+
+		uint64 headSize = ptr - mapPtr;
+		uint64 tailSize = mapSize - headSize - size;
+
+		if (headSize)
+			munmap(mapPtr, headSize);
+
+		if (tailSize)
+			munmap(ptr + size, tailSize);
+
+#ifdef MADV_HUGEPAGE
+		madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+	}
+
+#ifdef SYS_mbind
+	// Bound before anything touches the pages since they are placed on the first touch. Preferred instead of strictly
+	// bound so that a full node falls back to other nodes instead of failing.
+	constexpr int MPOL_PREFERRED_MODE = 1;
+	constexpr uint32 MAX_NODE_COUNT = 1024;
+	constexpr uint32 MASK_BITS = sizeof(unsigned long) * 8;
+
+	if (numaNode >= 0 && (uint32)numaNode < MAX_NODE_COUNT)
+	{
+		unsigned long nodeMask[MAX_NODE_COUNT / MASK_BITS] = {};
+		nodeMask[numaNode / MASK_BITS] = 1ul << (numaNode % MASK_BITS);
+
+		numaBound = syscall(SYS_mbind, ptr, size, MPOL_PREFERRED_MODE, nodeMask, MAX_NODE_COUNT, 0) == 0;
+	}
+#endif
+
+	return ptr;
+#endif
+}
+
+void UnmapHugePages(void* ptr, uint64 size)
+{
+#ifdef _WIN32
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+	munmap(ptr, size);
+#endif
+}
+
+int32 GetCurrentNumaNode()
+{
+#ifdef _WIN32
+	PROCESSOR_NUMBER processor;
+	USHORT node;
+
+	GetCurrentProcessorNumberEx(&processor);
+
+	return GetNumaProcessorNodeEx(&processor, &node) ? (int32)node : -1;
+#elif defined(SYS_getcpu)
+	unsigned int cpu;
+	unsigned int node;
+
+	return syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 ? (int32)node : -1;
+#else
+	return -1;
+#endif
+}
+}
+}
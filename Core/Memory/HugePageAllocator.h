@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include "IAllocator.h"
+
+namespace ducklib
+{
+namespace Internal::Memory
+{
+struct LargeAllocation;
+}
+
+struct HugePageStats
+{
+	uint32 largeAllocationCount;
+	uint64 mappedSize;
+
+	// Explicitly reserved huge pages, i.e. MAP_HUGETLB or MEM_LARGE_PAGES
+	uint64 explicitHugePageSize;
+
+	// Transparent huge pages the kernel has actually backed the mappings with. Always 0 where not supported.
+	uint64 transparentHugePageSize;
+
+	// Allocations bound to the NUMA node of the thread that made them
+	uint32 numaBoundCount;
+};
+
+/**
+ * Serves allocations of at least largeThreshold bytes directly from the OS, backed by 2 MiB huge pages to cut down on
+ * TLB misses, and forwards smaller ones to the backing allocator. Explicit huge pages are tried first and if none are
+ * available the mapping is 2 MiB aligned and transparent huge pages are requested instead.
+ *
+ * With bindToLocalNode, large allocations are bound to the NUMA node of the calling thread, so a JobQueue worker gets
+ * memory local to the node it runs on. GetHugePageStats() reports how much of the memory the OS has actually backed
+ * with huge pages.
+ *
+ * Thread safe if the backing allocator is.
+ */
+class HugePageAllocator final : public IAllocator
+{
+public:
+	HugePageAllocator(
+		uint64 largeThreshold = DEFAULT_LARGE_THRESHOLD,
+		bool bindToLocalNode = true,
+		IAllocator* backingAlloc = DefAlloc());
+	~HugePageAllocator() override;
+
+	HugePageAllocator(const HugePageAllocator&) = delete;
+	HugePageAllocator& operator=(const HugePageAllocator&) = delete;
+
+	HugePageStats GetHugePageStats();
+	AllocatorStats GetStats() const override;
+
+	static constexpr uint64 HUGE_PAGE_SIZE = 2ull << 20;
+	static constexpr uint64 DEFAULT_LARGE_THRESHOLD = 1ull << 20;
+
+protected:
+	using LargeAllocation = Internal::Memory::LargeAllocation;
+
+	void* AllocateInternal(uint64 size, uint32 align) override;
+	void* ReallocateInternal(void* ptr, uint64 size) override;
+	void FreeInternal(void* ptr) override;
+
+	void* AllocateLarge(uint64 size, uint32 align);
+	void FreeLarge(LargeAllocation* allocation);
+
+	IAllocator* backingAlloc;
+	const uint64 largeThreshold;
+	const bool bindToLocalNode;
+
+	std::mutex largeLock;
+	LargeAllocation* largeAllocations;
+
+	std::atomic<uint64> atomicTotalAllocatedSize;
+	std::atomic<uint64> atomicAllocatedSize;
+	std::atomic<uint32> atomicAllocationCount;
+};
+
+namespace Internal::Memory
+{
+// Directly before the data of every allocation
+struct HugePageHeader
+{
+	uint64 size;
+	uint32 offset;
+	uint32 align;
+	bool isLarge;
+};
+
+// At the start of the mapping of large allocations
+struct LargeAllocation
+{
+	LargeAllocation* prev;
+	LargeAllocation* next;
+	uint64 mappedSize;
+	bool explicitHugePages;
+	bool numaBound;
+};
+
+/**
+ * Maps size bytes, a multiple of HUGE_PAGE_SIZE, aligned to HUGE_PAGE_SIZE and backed by huge pages if possible. The
+ * memory is bound to numaNode unless it is negative. Returns null on failure.
+ */
+void* MapHugePages(uint64 size, int32 numaNode, bool& explicitHugePages, bool& numaBound);
+void UnmapHugePages(void* ptr, uint64 size);
+
+// -1 if unknown
+int32 GetCurrentNumaNode();
+}
+}
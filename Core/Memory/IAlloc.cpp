@@ -1,12 +1,38 @@
 #include "HeapAllocator.h"
+#include "HeapProfiler.h"
+#include "ThreadCacheAllocator.h"
 
 namespace ducklib
 {
+namespace
+{
+// Allocators built on other allocators go through their public interface, too
+thread_local uint32 allocatorCallDepth = 0;
+
+/**
+ * Only the outermost allocator call is reported to the profiler, otherwise an allocation would be sampled again by
+ * every allocator underneath it.
+ */
+struct OutermostAllocatorCall
+{
+	OutermostAllocatorCall()
+		: isOutermost(allocatorCallDepth++ == 0) {}
+
+	~OutermostAllocatorCall()
+	{
+		--allocatorCallDepth;
+	}
+
+	bool isOutermost;
+};
+}
+
 IAllocator* DefAlloc()
 {
 	static HeapAllocator defaultHeapAllocator;
+	static ThreadCacheAllocator defaultAllocator(&defaultHeapAllocator);
 
-	return &defaultHeapAllocator;
+	return &defaultAllocator;
 }
 
 IAllocator::IAllocator()
@@ -14,17 +40,82 @@ IAllocator::IAllocator()
 	, allocatedSize(0)
 	, allocationCount(0) {}
 
-void* IAllocator::Allocate(uint64 size, uint8_t align)
+DL_NOINLINE void* IAllocator::Allocate(uint64 size, uint32 align)
 {
-	return AllocateInternal(size, align);
+	OutermostAllocatorCall call;
+	void* ptr = AllocateInternal(size, align);
+
+	if (call.isOutermost)
+		GetHeapProfiler().RecordAllocation(ptr, size);
+
+	return ptr;
 }
 
-void* IAllocator::Reallocate(void* ptr, uint64 size)
+// Frees are recorded before the memory is released so that another thread can't get the same address sampled first
+
+DL_NOINLINE void* IAllocator::Reallocate(void* ptr, uint64 size)
 {
-	return ReallocateInternal(ptr, size);
+	OutermostAllocatorCall call;
+	HeapProfiler& heapProfiler = GetHeapProfiler();
+
+	if (call.isOutermost)
+		heapProfiler.RecordFree(ptr);
+
+	void* newPtr = ReallocateInternal(ptr, size);
+
+	if (call.isOutermost)
+		heapProfiler.RecordAllocation(newPtr, size);
+
+	return newPtr;
 }
 
 void IAllocator::Free(void* ptr)
+{
+	OutermostAllocatorCall call;
+
+	if (call.isOutermost)
+		GetHeapProfiler().RecordFree(ptr);
+
+	FreeInternal(ptr);
+}
+
+DL_NOINLINE void* IAllocator::Reallocate(void* ptr, uint64 oldSize, uint64 newSize, uint32 align)
+{
+	OutermostAllocatorCall call;
+	HeapProfiler& heapProfiler = GetHeapProfiler();
+
+	if (call.isOutermost)
+		heapProfiler.RecordFree(ptr);
+
+	void* newPtr = ReallocateSizedInternal(ptr, oldSize, newSize, align);
+
+	if (call.isOutermost)
+		heapProfiler.RecordAllocation(newPtr, newSize);
+
+	return newPtr;
+}
+
+void IAllocator::Free(void* ptr, uint64 size)
+{
+	OutermostAllocatorCall call;
+
+	if (call.isOutermost)
+		GetHeapProfiler().RecordFree(ptr);
+
+	FreeSizedInternal(ptr, size);
+}
+
+AllocatorStats IAllocator::GetStats() const
+{
+	return { totalAllocatedSize, allocatedSize, allocationCount };
+}
+
+void* IAllocator::ReallocateSizedInternal(void* ptr, uint64 oldSize, uint64 newSize, uint32 align)
+{
+	return ReallocateInternal(ptr, newSize);
+}
+
+void IAllocator::FreeSizedInternal(void* ptr, uint64 size)
 {
 	FreeInternal(ptr);
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <type_traits>
 #include "AllocTracker.h"
 
 namespace ducklib
@@ -7,16 +8,29 @@ class IAllocator;
 
 IAllocator* DefAlloc();
 
+struct AllocatorStats
+{
+	// totalSize includes possible headers, alignment and similar extra data
+	uint64 totalAllocatedSize;
+	uint64 allocatedSize;
+	uint32 allocationCount;
+};
+
 class IAllocator
 {
 public:
 	IAllocator();
 	virtual ~IAllocator() { }
 
-	void* Allocate(uint64 size, uint8_t align = DEFAULT_ALIGN);
+	void* Allocate(uint64 size, uint32 align = DEFAULT_ALIGN);
 	void* Reallocate(void* ptr, uint64 size);
 	void Free(void* ptr);
 
+	// Sized versions let allocators skip looking up or even storing the size. The size and alignment have to be the
+	// ones the allocation was made with.
+	void* Reallocate(void* ptr, uint64 oldSize, uint64 newSize, uint32 align = DEFAULT_ALIGN);
+	void Free(void* ptr, uint64 size);
+
 	template <typename T>
 	T* Allocate(uint32 count = 1);
 
@@ -25,19 +39,24 @@ public:
 	template <typename T>
 	void Delete(T* ptr);
 
-	// TODO: Come up with a good way to support this. Do all implementations then require a header to keep track of count or total size?
-	// template <typename T>
-	// T* NewArray(uint64 count);
-	// template <typename T>
-	// void DeleteArray(T* ptr);
+	template <typename T>
+	T* NewArray(uint64 count);
+	template <typename T>
+	void DeleteArray(T* ptr, uint64 count);
+
+	virtual AllocatorStats GetStats() const;
 
-	static constexpr uint8_t DEFAULT_ALIGN = 4;
+	static constexpr uint32 DEFAULT_ALIGN = 4;
 
 protected:
-	virtual void* AllocateInternal(uint64 size, uint8_t align = DEFAULT_ALIGN) = 0;
+	virtual void* AllocateInternal(uint64 size, uint32 align = DEFAULT_ALIGN) = 0;
 	virtual void* ReallocateInternal(void* ptr, uint64 newSize) = 0;
 	virtual void FreeInternal(void* ptr) = 0;
 
+	// Default to the unsized versions for allocators that keep track of sizes themselves
+	virtual void* ReallocateSizedInternal(void* ptr, uint64 oldSize, uint64 newSize, uint32 align);
+	virtual void FreeSizedInternal(void* ptr, uint64 size);
+
 	// totalSize includes possible headers, alignment and similar extra data
 	uint64 totalAllocatedSize;
 	uint64 allocatedSize;
@@ -60,24 +79,31 @@ template <typename T>
 void IAllocator::Delete(T* ptr)
 {
 	ptr->~T();
-	Free(ptr);
+
+	// A pointer to a polymorphic base doesn't tell the size of the actual object
+	if constexpr (std::is_polymorphic_v<T>)
+		Free(ptr);
+	else
+		Free(ptr, sizeof(T));
 }
 
-// template <typename T>
-// T* IAlloc::NewArray(uint64 count)
-// {
-// 	T* array = Allocate(sizeof(T) * count, alignof(T));
-//
-// 	for (uint64 i = 0; i < count; ++i)
-// 		new (&array[i]) T();
-//
-// 	return array;
-// }
-//
-// template <typename T>
-// void IAlloc::DeleteArray(T* ptr)
-// {
-// 	for
-// }
+template <typename T>
+T* IAllocator::NewArray(uint64 count)
+{
+	T* array = (T*)Allocate(sizeof(T) * count, alignof(T));
+
+	for (uint64 i = 0; i < count; ++i)
+		new (&array[i]) T();
 
+	return array;
+}
+
+template <typename T>
+void IAllocator::DeleteArray(T* ptr, uint64 count)
+{
+	for (uint64 i = 0; i < count; ++i)
+		ptr[i].~T();
+
+	Free(ptr, sizeof(T) * count);
+}
 }
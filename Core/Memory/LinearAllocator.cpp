@@ -0,0 +1,170 @@
+#include <cstring>
+#include <stdexcept>
+#include "LinearAllocator.h"
+#include "HeapAllocator.h"
+
+namespace ducklib
+{
+using namespace Internal::Memory;
+
+LinearAllocator::LinearAllocator(uint64 capacity, IAllocator* backingAlloc)
+	: backingAlloc(backingAlloc)
+	, buffer((char*)backingAlloc->Allocate(capacity, BUFFER_ALIGN))
+	, capacity(capacity)
+	, offset(0)
+	, lastAllocationOffset(NO_ALLOCATION) {}
+
+LinearAllocator::~LinearAllocator()
+{
+	backingAlloc->Free(buffer);
+}
+
+LinearAllocator::Marker LinearAllocator::GetMarker() const
+{
+	return { offset, allocatedSize, allocationCount };
+}
+
+void LinearAllocator::RewindToMarker(const Marker& marker)
+{
+	if (marker.offset > offset)
+		throw std::runtime_error("Tried to rewind linear allocator forward");
+
+	offset = marker.offset;
+	lastAllocationOffset = NO_ALLOCATION;
+
+	totalAllocatedSize = offset;
+	allocatedSize = marker.allocatedSize;
+	allocationCount = marker.allocationCount;
+}
+
+void LinearAllocator::Reset()
+{
+	RewindToMarker({});
+}
+
+uint64 LinearAllocator::Capacity() const
+{
+	return capacity;
+}
+
+uint64 LinearAllocator::UsedSize() const
+{
+	return offset;
+}
+
+void* LinearAllocator::AllocateInternal(uint64 size, uint32 align)
+{
+	char* alignedPtr = (char*)NextAlign(buffer + offset, align);
+	uint64 alignedOffset = alignedPtr - buffer;
+
+	if (alignedOffset + size > capacity)
+		throw std::runtime_error("Linear allocator out of memory");
+
+	lastAllocationOffset = alignedOffset;
+	offset = alignedOffset + size;
+
+	totalAllocatedSize = offset;
+	allocatedSize += size;
+	++allocationCount;
+
+	return alignedPtr;
+}
+
+void* LinearAllocator::ReallocateInternal(void* ptr, uint64 size)
+{
+	uint64 ptrOffset = (char*)ptr - buffer;
+
+	// The latest allocation can be resized in place
+	if (ptrOffset == lastAllocationOffset)
+	{
+		if (ptrOffset + size > capacity)
+			throw std::runtime_error("Linear allocator out of memory");
+
+		allocatedSize += size - (offset - ptrOffset);
+		offset = ptrOffset + size;
+		totalAllocatedSize = offset;
+
+		return ptr;
+	}
+
+	// Keep the original alignment since it's not known anymore. The old allocation stays until reset.
+	uintptr_t ptrAlign = (uintptr_t)ptr & (~(uintptr_t)ptr + 1);
+	uint32 align = ptrAlign < CACHE_LINE_SIZE ? (uint32)ptrAlign : CACHE_LINE_SIZE;
+	uint64 maxOldSize = offset - ptrOffset;
+	void* newPtr = AllocateInternal(size, align);
+
+	memcpy(newPtr, ptr, size < maxOldSize ? size : maxOldSize);
+	--allocationCount;
+
+	return newPtr;
+}
+
+void LinearAllocator::FreeInternal(void* ptr)
+{
+	uint64 ptrOffset = (char*)ptr - buffer;
+
+	// The allocation is gone even when its memory can't be reclaimed, but only the latest one's size is known
+	--allocationCount;
+
+	if (ptrOffset != lastAllocationOffset)
+		return;
+
+	allocatedSize -= offset - ptrOffset;
+
+	offset = ptrOffset;
+	lastAllocationOffset = NO_ALLOCATION;
+	totalAllocatedSize = offset;
+}
+
+void* LinearAllocator::ReallocateSizedInternal(void* ptr, uint64 oldSize, uint64 newSize, uint32 align)
+{
+	uint64 ptrOffset = (char*)ptr - buffer;
+
+	if (ptrOffset + oldSize == offset)
+	{
+		if (ptrOffset + newSize > capacity)
+			throw std::runtime_error("Linear allocator out of memory");
+
+		allocatedSize += newSize - oldSize;
+		offset = ptrOffset + newSize;
+		lastAllocationOffset = ptrOffset;
+		totalAllocatedSize = offset;
+
+		return ptr;
+	}
+
+	void* newPtr = AllocateInternal(newSize, align);
+
+	memcpy(newPtr, ptr, newSize < oldSize ? newSize : oldSize);
+
+	// The old allocation stays until reset but is not counted anymore
+	allocatedSize -= oldSize;
+	--allocationCount;
+
+	return newPtr;
+}
+
+void LinearAllocator::FreeSizedInternal(void* ptr, uint64 size)
+{
+	uint64 ptrOffset = (char*)ptr - buffer;
+
+	allocatedSize -= size;
+	--allocationCount;
+
+	if (ptrOffset + size != offset)
+		return;
+
+	offset = ptrOffset;
+	lastAllocationOffset = NO_ALLOCATION;
+	totalAllocatedSize = offset;
+}
+
+LinearAllocatorScope::LinearAllocatorScope(LinearAllocator& alloc)
+	: alloc(alloc)
+	, marker(alloc.GetMarker()) {}
+
+LinearAllocatorScope::~LinearAllocatorScope()
+{
+	alloc.RewindToMarker(marker);
+}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "IAllocator.h"
+
+namespace ducklib
+{
+/**
+ * Bump pointer allocator over a single fixed size buffer. Allocating only moves an offset forward and nothing is
+ * released individually, except for the most recent allocation. Everything is released at once with Reset() or
+ * partially with RewindToMarker().
+ *
+ * With the sized Free() and Reallocate() any allocation ending at the top can be released or resized in place, so
+ * allocations freed in reverse order are all reclaimed.
+ */
+class LinearAllocator final : public IAllocator
+{
+public:
+	struct Marker
+	{
+		uint64 offset;
+		uint64 allocatedSize;
+		uint32 allocationCount;
+	};
+
+	LinearAllocator(uint64 capacity, IAllocator* backingAlloc = DefAlloc());
+	~LinearAllocator() override;
+
+	LinearAllocator(const LinearAllocator&) = delete;
+	LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+	Marker GetMarker() const;
+	void RewindToMarker(const Marker& marker);
+	void Reset();
+
+	uint64 Capacity() const;
+	uint64 UsedSize() const;
+
+protected:
+	void* AllocateInternal(uint64 size, uint32 align) override;
+	void* ReallocateInternal(void* ptr, uint64 size) override;
+	void FreeInternal(void* ptr) override;
+	void* ReallocateSizedInternal(void* ptr, uint64 oldSize, uint64 newSize, uint32 align) override;
+	void FreeSizedInternal(void* ptr, uint64 size) override;
+
+	static constexpr uint64 NO_ALLOCATION = ~0ull;
+	static constexpr uint32 BUFFER_ALIGN = 16;
+
+	IAllocator* backingAlloc;
+	char* buffer;
+	uint64 capacity;
+	uint64 offset;
+	uint64 lastAllocationOffset;
+};
+
+/**
+ * Rewinds the allocator back to where it was at construction when the scope ends. Declare it before the containers
+ * using the allocator so that they are destroyed first.
+ */
+class LinearAllocatorScope
+{
+public:
+	LinearAllocatorScope(LinearAllocator& alloc);
+	~LinearAllocatorScope();
+
+	LinearAllocatorScope(const LinearAllocatorScope&) = delete;
+	LinearAllocatorScope& operator=(const LinearAllocatorScope&) = delete;
+
+private:
+	LinearAllocator& alloc;
+	LinearAllocator::Marker marker;
+};
+}
@@ -0,0 +1,203 @@
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include "MemoryTags.h"
+
+namespace ducklib
+{
+using namespace Internal::Memory;
+
+namespace
+{
+constexpr uint32 TAG_COUNT = (uint32)MemoryTag::COUNT;
+
+const char* TAG_NAMES[TAG_COUNT] = {
+	"Untagged",
+	"Core",
+	"Threading",
+	"Render",
+	"Net",
+};
+
+struct alignas(CACHE_LINE_SIZE) TagCounters
+{
+	std::atomic<uint64> allocatedSize;
+	std::atomic<uint64> peakAllocatedSize;
+	std::atomic<uint64> allocationCount;
+	std::atomic<uint64> budget;
+};
+
+TagCounters tagCounters[TAG_COUNT];
+
+TagCounters& GetCounters(MemoryTag tag)
+{
+	return tagCounters[(uint32)tag];
+}
+
+void AddSize(MemoryTag tag, uint64 size)
+{
+	TagCounters& counters = GetCounters(tag);
+	uint64 newSize = counters.allocatedSize.fetch_add(size, std::memory_order_relaxed) + size;
+	uint64 budget = counters.budget.load(std::memory_order_relaxed);
+
+	if (budget && newSize > budget)
+	{
+		counters.allocatedSize.fetch_sub(size, std::memory_order_relaxed);
+
+		char message[128];
+		snprintf(message, sizeof(message), "Memory budget exceeded for tag %s", GetMemoryTagName(tag));
+
+		throw std::runtime_error(message);
+	}
+
+	uint64 peak = counters.peakAllocatedSize.load(std::memory_order_relaxed);
+
+	while (newSize > peak && !counters.peakAllocatedSize.compare_exchange_weak(peak, newSize, std::memory_order_relaxed)) {}
+}
+}
+
+const char* GetMemoryTagName(MemoryTag tag)
+{
+	return tag < MemoryTag::COUNT ? TAG_NAMES[(uint32)tag] : "Invalid";
+}
+
+MemoryTagStats GetMemoryTagStats(MemoryTag tag)
+{
+	const TagCounters& counters = GetCounters(tag);
+
+	return {
+		counters.allocatedSize.load(std::memory_order_relaxed),
+		counters.peakAllocatedSize.load(std::memory_order_relaxed),
+		counters.allocationCount.load(std::memory_order_relaxed),
+		counters.budget.load(std::memory_order_relaxed)
+	};
+}
+
+void SetMemoryTagBudget(MemoryTag tag, uint64 budget)
+{
+	GetCounters(tag).budget = budget;
+}
+
+void ResetMemoryTagPeak(MemoryTag tag)
+{
+	TagCounters& counters = GetCounters(tag);
+
+	counters.peakAllocatedSize = counters.allocatedSize.load();
+}
+
+IAllocator* TagAlloc(MemoryTag tag)
+{
+	static TaggedAllocator tagAllocators[TAG_COUNT] = {
+		MemoryTag::UNTAGGED,
+		MemoryTag::CORE,
+		MemoryTag::THREADING,
+		MemoryTag::RENDER,
+		MemoryTag::NET,
+	};
+
+	return &tagAllocators[(uint32)tag];
+}
+
+TaggedAllocator::TaggedAllocator(MemoryTag tag, IAllocator* backingAlloc)
+	: backingAlloc(backingAlloc)
+	, tag(tag) {}
+
+MemoryTag TaggedAllocator::Tag() const
+{
+	return tag;
+}
+
+AllocatorStats TaggedAllocator::GetStats() const
+{
+	MemoryTagStats stats = GetMemoryTagStats(tag);
+
+	return { stats.allocatedSize, stats.allocatedSize, (uint32)stats.allocationCount };
+}
+
+void* TaggedAllocator::AllocateInternal(uint64 size, uint32 align)
+{
+	// Keeping the data at an offset of a multiple of the alignment keeps it aligned through reallocations, too
+	uint64 offset = align > sizeof(TaggedHeader) ? align : sizeof(TaggedHeader);
+	uint32 allocationAlign = align > alignof(TaggedHeader) ? align : alignof(TaggedHeader);
+
+	// The header is memory the tag uses as well
+	AddTaggedAllocation(tag, size + offset);
+
+	char* allocationPtr;
+
+	try
+	{
+		allocationPtr = (char*)backingAlloc->Allocate(size + offset, allocationAlign);
+	}
+	catch (...)
+	{
+		RemoveTaggedAllocation(tag, size + offset);
+		throw;
+	}
+
+	TaggedHeader* header = (TaggedHeader*)(allocationPtr + offset - sizeof(TaggedHeader));
+	header->size = size;
+	header->offset = offset;
+
+	return allocationPtr + offset;
+}
+
+void* TaggedAllocator::ReallocateInternal(void* ptr, uint64 size)
+{
+	TaggedHeader* header = (TaggedHeader*)((char*)ptr - sizeof(TaggedHeader));
+	uint64 oldSize = header->size;
+	uint64 offset = header->offset;
+
+	ResizeTaggedAllocation(tag, oldSize + offset, size + offset);
+
+	char* allocationPtr;
+
+	try
+	{
+		allocationPtr = (char*)backingAlloc->Reallocate((char*)ptr - offset, size + offset);
+	}
+	catch (...)
+	{
+		ResizeTaggedAllocation(tag, size + offset, oldSize + offset);
+		throw;
+	}
+
+	header = (TaggedHeader*)(allocationPtr + offset - sizeof(TaggedHeader));
+	header->size = size;
+
+	return allocationPtr + offset;
+}
+
+void TaggedAllocator::FreeInternal(void* ptr)
+{
+	TaggedHeader* header = (TaggedHeader*)((char*)ptr - sizeof(TaggedHeader));
+
+	RemoveTaggedAllocation(tag, header->size + header->offset);
+	backingAlloc->Free((char*)ptr - header->offset);
+}
+
+namespace Internal::Memory
+{
+void AddTaggedAllocation(MemoryTag tag, uint64 size)
+{
+	AddSize(tag, size);
+	GetCounters(tag).allocationCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RemoveTaggedAllocation(MemoryTag tag, uint64 size)
+{
+	TagCounters& counters = GetCounters(tag);
+
+	counters.allocatedSize.fetch_sub(size, std::memory_order_relaxed);
+	counters.allocationCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ResizeTaggedAllocation(MemoryTag tag, uint64 oldSize, uint64 newSize)
+{
+	if (newSize > oldSize)
+		AddSize(tag, newSize - oldSize);
+	else
+		GetCounters(tag).allocatedSize.fetch_sub(oldSize - newSize, std::memory_order_relaxed);
+}
+}
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "IAllocator.h"
+
+namespace ducklib
+{
+enum class MemoryTag : uint8
+{
+	UNTAGGED,
+	CORE,
+	THREADING,
+	RENDER,
+	NET,
+	COUNT,
+};
+
+struct MemoryTagStats
+{
+	uint64 allocatedSize;
+	uint64 peakAllocatedSize;
+	uint64 allocationCount;
+
+	// 0 when unlimited
+	uint64 budget;
+};
+
+const char* GetMemoryTagName(MemoryTag tag);
+MemoryTagStats GetMemoryTagStats(MemoryTag tag);
+
+/**
+ * Allocations and reallocations that would take the tag over its budget throw instead of allocating. A budget of 0
+ * removes the limit.
+ */
+void SetMemoryTagBudget(MemoryTag tag, uint64 budget);
+void ResetMemoryTagPeak(MemoryTag tag);
+
+/**
+ * Default allocator for the tag, e.g. TagAlloc(MemoryTag::RENDER)->New<Foo>(). Memory has to be freed through the
+ * same allocator.
+ */
+IAllocator* TagAlloc(MemoryTag tag);
+
+/**
+ * Counts everything allocated through it towards a memory tag and enforces the tag's budget. Works over any backing
+ * allocator by keeping the size in a small header before each allocation, the header and alignment padding are
+ * counted towards the tag too. Thread safe if the backing allocator is.
+ *
+ * GetStats() returns the totals of the whole tag, including other allocators with the same tag.
+ */
+class TaggedAllocator final : public IAllocator
+{
+public:
+	TaggedAllocator(MemoryTag tag, IAllocator* backingAlloc = DefAlloc());
+
+	TaggedAllocator(const TaggedAllocator&) = delete;
+	TaggedAllocator& operator=(const TaggedAllocator&) = delete;
+
+	MemoryTag Tag() const;
+
+	AllocatorStats GetStats() const override;
+
+protected:
+	void* AllocateInternal(uint64 size, uint32 align) override;
+	void* ReallocateInternal(void* ptr, uint64 size) override;
+	void FreeInternal(void* ptr) override;
+
+	IAllocator* backingAlloc;
+	MemoryTag tag;
+};
+
+namespace Internal::Memory
+{
+struct TaggedHeader
+{
+	uint64 size;
+	uint64 offset;
+};
+
+void AddTaggedAllocation(MemoryTag tag, uint64 size);
+void RemoveTaggedAllocation(MemoryTag tag, uint64 size);
+void ResizeTaggedAllocation(MemoryTag tag, uint64 oldSize, uint64 newSize);
+}
+}
@@ -0,0 +1,115 @@
+#include <stdexcept>
+#include "PoolAllocator.h"
+#include "HeapAllocator.h"
+#include "../Utility.h"
+
+namespace ducklib
+{
+using namespace Internal::Memory;
+
+PoolAllocator::PoolAllocator(uint64 blockSize, uint32 blocksPerChunk, uint32 blockAlign, IAllocator* backingAlloc)
+	: backingAlloc(backingAlloc)
+	, chunks(nullptr)
+	, freeList(nullptr)
+	, blocksPerChunk(blocksPerChunk)
+	, freeBlockCount(0)
+	, blockAlign(blockAlign)
+{
+	if (blocksPerChunk == 0)
+		throw std::runtime_error("Pool allocator needs at least one block per chunk");
+
+	if (blockAlign == 0 || (blockAlign & (blockAlign - 1)) != 0)
+		throw std::runtime_error("Pool allocator block alignment has to be a power of two");
+
+	// Free blocks hold the free list link and every block has to start aligned
+	uint64 minBlockSize = blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize;
+	this->blockSize = (minBlockSize + blockAlign - 1) / blockAlign * blockAlign;
+}
+
+PoolAllocator::~PoolAllocator()
+{
+	if (allocationCount > 0)
+		Utility::DebugOutput("Not all allocations freed in pool allocator");
+
+	while (chunks)
+	{
+		Chunk* next = chunks->next;
+		backingAlloc->Free(chunks);
+		chunks = next;
+	}
+}
+
+uint64 PoolAllocator::BlockSize() const
+{
+	return blockSize;
+}
+
+uint32 PoolAllocator::FreeBlockCount() const
+{
+	return freeBlockCount;
+}
+
+void* PoolAllocator::AllocateInternal(uint64 size, uint32 align)
+{
+	// No alignment asks for nothing beyond the default, which every block satisfies
+	if (align == 0)
+		align = DEFAULT_ALIGN;
+
+	if (size > blockSize || blockAlign % align != 0)
+		throw std::runtime_error("Allocation doesn't fit in pool allocator block");
+
+	if (!freeList)
+		AddChunk();
+
+	FreeBlock* block = freeList;
+
+	freeList = block->next;
+	--freeBlockCount;
+
+	allocatedSize += blockSize;
+	++allocationCount;
+
+	return block;
+}
+
+void* PoolAllocator::ReallocateInternal(void* ptr, uint64 size)
+{
+	if (size > blockSize)
+		throw std::runtime_error("Reallocation doesn't fit in pool allocator block");
+
+	return ptr;
+}
+
+void PoolAllocator::FreeInternal(void* ptr)
+{
+	FreeBlock* block = (FreeBlock*)ptr;
+
+	block->next = freeList;
+	freeList = block;
+	++freeBlockCount;
+
+	allocatedSize -= blockSize;
+	--allocationCount;
+}
+
+void PoolAllocator::AddChunk()
+{
+	uint64 chunkSize = sizeof(Chunk) + blockAlign + blockSize * blocksPerChunk;
+	Chunk* chunk = (Chunk*)backingAlloc->Allocate(chunkSize, alignof(Chunk));
+	char* blocks = (char*)NextAlign((char*)chunk + sizeof(Chunk), blockAlign);
+
+	chunk->next = chunks;
+	chunks = chunk;
+
+	// Link in reverse so that blocks are handed out in address order
+	for (uint32 i = blocksPerChunk; i > 0; --i)
+	{
+		FreeBlock* block = (FreeBlock*)(blocks + (i - 1) * blockSize);
+		block->next = freeList;
+		freeList = block;
+	}
+
+	freeBlockCount += blocksPerChunk;
+	totalAllocatedSize += chunkSize;
+}
+}
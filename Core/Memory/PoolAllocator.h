@@ -0,0 +1,90 @@
+#pragma once
+#include "IAllocator.h"
+
+namespace ducklib
+{
+/**
+ * Allocator for blocks of one fixed size. Free blocks are kept in an intrusive free list so allocating and freeing
+ * are both O(1) without any per-allocation header. Blocks are carved out of chunks of blocksPerChunk blocks which are
+ * only returned to the backing allocator when the pool is destroyed. Not thread safe.
+ */
+class PoolAllocator : public IAllocator
+{
+public:
+	PoolAllocator(
+		uint64 blockSize,
+		uint32 blocksPerChunk,
+		uint32 blockAlign = DEFAULT_BLOCK_ALIGN,
+		IAllocator* backingAlloc = DefAlloc());
+	~PoolAllocator() override;
+
+	PoolAllocator(const PoolAllocator&) = delete;
+	PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+	uint64 BlockSize() const;
+	uint32 FreeBlockCount() const;
+
+	static constexpr uint32 DEFAULT_BLOCK_ALIGN = CACHE_LINE_SIZE;
+
+protected:
+	void* AllocateInternal(uint64 size, uint32 align) override;
+	void* ReallocateInternal(void* ptr, uint64 size) override;
+	void FreeInternal(void* ptr) override;
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	struct Chunk
+	{
+		Chunk* next;
+	};
+
+	void AddChunk();
+
+	IAllocator* backingAlloc;
+	Chunk* chunks;
+	FreeBlock* freeList;
+	uint64 blockSize;
+	uint32 blocksPerChunk;
+	uint32 freeBlockCount;
+	uint32 blockAlign;
+};
+
+/**
+ * Pool sized and aligned for objects of type T. Blocks are at least cache line aligned to avoid false sharing between
+ * neighbouring objects.
+ */
+template <typename T>
+class TPoolAllocator final : public PoolAllocator
+{
+public:
+	TPoolAllocator(uint32 blocksPerChunk, IAllocator* backingAlloc = DefAlloc());
+
+	template <typename... TArgs>
+	T* New(TArgs&&... args);
+	void Delete(T* ptr);
+};
+
+template <typename T>
+TPoolAllocator<T>::TPoolAllocator(uint32 blocksPerChunk, IAllocator* backingAlloc)
+	: PoolAllocator(
+		sizeof(T),
+		blocksPerChunk,
+		alignof(T) > DEFAULT_BLOCK_ALIGN ? (uint32)alignof(T) : DEFAULT_BLOCK_ALIGN,
+		backingAlloc) {}
+
+template <typename T>
+template <typename... TArgs>
+T* TPoolAllocator<T>::New(TArgs&&... args)
+{
+	return IAllocator::New<T>(std::forward<TArgs>(args)...);
+}
+
+template <typename T>
+void TPoolAllocator<T>::Delete(T* ptr)
+{
+	IAllocator::Delete(ptr);
+}
+}
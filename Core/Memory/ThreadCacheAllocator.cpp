@@ -0,0 +1,556 @@
+#include <cstring>
+#include "ThreadCacheAllocator.h"
+#include "HeapAllocator.h"
+#include "../Utility.h"
+
+namespace ducklib
+{
+using namespace Internal::Memory;
+
+struct ThreadCacheAllocator::ThreadCache
+{
+	FreeBlock* heads[NUM_SIZE_CLASSES] = {};
+	uint32 counts[NUM_SIZE_CLASSES] = {};
+
+	// Only written by the owning thread, read by anyone collecting stats
+	std::atomic<int64> allocatedSize{ 0 };
+	std::atomic<int64> allocationCount{ 0 };
+
+	ThreadCache* next = nullptr;
+};
+
+namespace
+{
+std::mutex liveAllocatorsLock;
+ThreadCacheAllocator* liveAllocators = nullptr;
+std::atomic<uint64> nextAllocatorId{ 1 };
+
+thread_local bool threadCacheSlotsDestroyed = false;
+
+void AddStats(ThreadCacheAllocator::ThreadCache* cache, int64 size, int64 count)
+{
+	cache->allocatedSize.store(cache->allocatedSize.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+	cache->allocationCount.store(cache->allocationCount.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+}
+}
+
+/**
+ * The thread's caches for the allocators it has used. Keyed by allocator id so that stale entries of destroyed
+ * allocators can be told apart from live ones without touching the destroyed allocator. An allocator's cache starts
+ * looking at slot id % NUM_SLOTS and takes the next free slot when that's in use, so allocators with colliding ids
+ * don't keep evicting each other.
+ */
+struct ThreadCacheSlots
+{
+	struct Slot
+	{
+		uint64 allocatorId;
+		ThreadCacheAllocator::ThreadCache* cache;
+	};
+
+	~ThreadCacheSlots()
+	{
+		for (Slot& slot : slots)
+			ReleaseSlot(slot);
+
+		threadCacheSlotsDestroyed = true;
+	}
+
+	static void ReleaseSlot(Slot& slot)
+	{
+		if (slot.allocatorId == 0)
+			return;
+
+		std::lock_guard<std::mutex> guard(liveAllocatorsLock);
+
+		for (ThreadCacheAllocator* it = liveAllocators; it; it = it->nextLive)
+		{
+			if (it->id == slot.allocatorId)
+			{
+				it->RetireThreadCache(slot.cache);
+				break;
+			}
+		}
+
+		slot = {};
+	}
+
+	Slot* FindSlot(uint64 allocatorId)
+	{
+		for (uint32 i = 0; i < NUM_SLOTS; ++i)
+		{
+			Slot& slot = slots[(allocatorId + i) % NUM_SLOTS];
+
+			if (slot.allocatorId == allocatorId)
+				return &slot;
+		}
+
+		return nullptr;
+	}
+
+	// Prefers a free slot, evicts the first one looked at if all are taken by live allocators
+	Slot& SlotToFill(uint64 allocatorId)
+	{
+		if (Slot* slot = FindFreeSlot(allocatorId))
+			return *slot;
+
+		ClearDeadSlots();
+
+		if (Slot* slot = FindFreeSlot(allocatorId))
+			return *slot;
+
+		return slots[allocatorId % NUM_SLOTS];
+	}
+
+	Slot* FindFreeSlot(uint64 allocatorId)
+	{
+		for (uint32 i = 0; i < NUM_SLOTS; ++i)
+		{
+			Slot& slot = slots[(allocatorId + i) % NUM_SLOTS];
+
+			if (slot.allocatorId == 0)
+				return &slot;
+		}
+
+		return nullptr;
+	}
+
+	// Slots of destroyed allocators are only noticed here, their caches went with the allocator
+	void ClearDeadSlots()
+	{
+		std::lock_guard<std::mutex> guard(liveAllocatorsLock);
+
+		for (Slot& slot : slots)
+		{
+			ThreadCacheAllocator* it = liveAllocators;
+
+			while (it && it->id != slot.allocatorId)
+				it = it->nextLive;
+
+			if (!it)
+				slot = {};
+		}
+	}
+
+	static constexpr uint32 NUM_SLOTS = 8;
+
+	Slot slots[NUM_SLOTS] = {};
+};
+
+namespace
+{
+thread_local ThreadCacheSlots threadCacheSlots;
+}
+
+ThreadCacheAllocator::ThreadCacheAllocator(IAllocator* backingAlloc)
+	: id(nextAllocatorId.fetch_add(1))
+	, backingAlloc(backingAlloc)
+	, nextLive(nullptr)
+	, slabs(nullptr)
+	, backingAllocatedSize(0)
+	, activeCaches(nullptr)
+	, retiredCaches(nullptr)
+	, retiredAllocatedSize(0)
+	, retiredAllocationCount(0)
+{
+	for (CentralList& list : centralLists)
+	{
+		list.head = nullptr;
+		list.count = 0;
+	}
+
+	std::lock_guard<std::mutex> guard(liveAllocatorsLock);
+	nextLive = liveAllocators;
+	liveAllocators = this;
+}
+
+ThreadCacheAllocator::~ThreadCacheAllocator()
+{
+	{
+		std::lock_guard<std::mutex> guard(liveAllocatorsLock);
+		ThreadCacheAllocator** it = &liveAllocators;
+
+		while (*it != this)
+			it = &(*it)->nextLive;
+
+		*it = nextLive;
+	}
+
+	if (GetStats().allocationCount > 0)
+		Utility::DebugOutput("Not all allocations freed in thread cache allocator");
+
+	for (ThreadCache* caches : { activeCaches, retiredCaches })
+	{
+		while (caches)
+		{
+			ThreadCache* next = caches->next;
+			backingAlloc->Delete(caches);
+			caches = next;
+		}
+	}
+
+	while (slabs)
+	{
+		Slab* next = slabs->next;
+		backingAlloc->Free(slabs);
+		slabs = next;
+	}
+}
+
+AllocatorStats ThreadCacheAllocator::GetStats() const
+{
+	std::lock_guard<std::mutex> guard(cachesLock);
+	int64 sumAllocatedSize = retiredAllocatedSize;
+	int64 sumAllocationCount = retiredAllocationCount;
+
+	for (ThreadCache* cache = activeCaches; cache; cache = cache->next)
+	{
+		sumAllocatedSize += cache->allocatedSize.load(std::memory_order_relaxed);
+		sumAllocationCount += cache->allocationCount.load(std::memory_order_relaxed);
+	}
+
+	return { backingAllocatedSize.load(std::memory_order_relaxed), (uint64)sumAllocatedSize, (uint32)sumAllocationCount };
+}
+
+void ThreadCacheAllocator::ReleaseThreadCache()
+{
+	if (threadCacheSlotsDestroyed)
+		return;
+
+	if (ThreadCacheSlots::Slot* slot = threadCacheSlots.FindSlot(id))
+		ThreadCacheSlots::ReleaseSlot(*slot);
+}
+
+void* ThreadCacheAllocator::AllocateInternal(uint64 size, uint32 align)
+{
+	ThreadCache* cache = GetThreadCache();
+
+	if (!cache || size > MAX_SMALL_SIZE || align > SMALL_ALIGN)
+		return AllocateLarge(size, align);
+
+	return AllocateSmall(cache, size, SizeClass(size));
+}
+
+void* ThreadCacheAllocator::ReallocateInternal(void* ptr, uint64 size)
+{
+	BlockHeader* header = GetBlockHeader(ptr);
+	uint64 oldSize = header->size;
+	uint32 align = SMALL_ALIGN;
+
+	if (header->sizeClass != LARGE_SIZE_CLASS && size <= ClassSize(header->sizeClass))
+	{
+		ThreadCache* cache = GetThreadCache();
+
+		if (cache)
+		{
+			AddStats(cache, (int64)size - (int64)oldSize, 0);
+			header->size = size;
+
+			return ptr;
+		}
+	}
+
+	if (header->sizeClass == LARGE_SIZE_CLASS && header->offset > SMALL_ALIGN)
+		align = header->offset;
+
+	void* newPtr = AllocateInternal(size, align);
+
+	memcpy(newPtr, ptr, size < oldSize ? size : oldSize);
+	FreeInternal(ptr);
+
+	return newPtr;
+}
+
+void ThreadCacheAllocator::FreeInternal(void* ptr)
+{
+	BlockHeader* header = GetBlockHeader(ptr);
+
+	if (header->sizeClass == LARGE_SIZE_CLASS)
+		FreeLarge(ptr);
+	else
+		FreeSmall(GetThreadCache(), ptr, header->sizeClass);
+}
+
+uint32 ThreadCacheAllocator::SizeClass(uint64 size)
+{
+	uint32 sizeClass = 0;
+
+	while (ClassSize(sizeClass) < size)
+		++sizeClass;
+
+	return sizeClass;
+}
+
+uint64 ThreadCacheAllocator::ClassSize(uint32 sizeClass)
+{
+	return 1ull << (MIN_SIZE_CLASS_SHIFT + sizeClass);
+}
+
+uint64 ThreadCacheAllocator::BlockStride(uint32 sizeClass)
+{
+	return sizeof(BlockHeader) + ClassSize(sizeClass);
+}
+
+uint32 ThreadCacheAllocator::BatchCount(uint32 sizeClass)
+{
+	// Move about 16 KiB at a time, but always enough blocks to make taking the lock worth it
+	uint64 count = 16 * 1024 / BlockStride(sizeClass);
+
+	return count < 2 ? 2 : count > 64 ? 64 : (uint32)count;
+}
+
+ThreadCacheAllocator::BlockHeader* ThreadCacheAllocator::GetBlockHeader(void* ptr)
+{
+	return (BlockHeader*)((char*)ptr - sizeof(BlockHeader));
+}
+
+ThreadCacheAllocator::ThreadCache* ThreadCacheAllocator::GetThreadCache()
+{
+	// Thread is exiting and its caches are already released. Fall back to the shared lists.
+	if (threadCacheSlotsDestroyed)
+		return nullptr;
+
+	if (ThreadCacheSlots::Slot* slot = threadCacheSlots.FindSlot(id))
+		return slot->cache;
+
+	ThreadCacheSlots::Slot& slot = threadCacheSlots.SlotToFill(id);
+
+	ThreadCacheSlots::ReleaseSlot(slot);
+
+	slot.cache = CreateThreadCache();
+	slot.allocatorId = id;
+
+	return slot.cache;
+}
+
+ThreadCacheAllocator::ThreadCache* ThreadCacheAllocator::CreateThreadCache()
+{
+	ThreadCache* cache;
+	std::lock_guard<std::mutex> guard(cachesLock);
+
+	if (retiredCaches)
+	{
+		cache = retiredCaches;
+		retiredCaches = cache->next;
+	}
+	else
+	{
+		std::lock_guard<std::mutex> backingGuard(backingLock);
+		cache = backingAlloc->New<ThreadCache>();
+	}
+
+	cache->next = activeCaches;
+	activeCaches = cache;
+
+	return cache;
+}
+
+void ThreadCacheAllocator::RetireThreadCache(ThreadCache* cache)
+{
+	for (uint32 i = 0; i < NUM_SIZE_CLASSES; ++i)
+		Drain(cache, i, cache->counts[i]);
+
+	std::lock_guard<std::mutex> guard(cachesLock);
+	ThreadCache** it = &activeCaches;
+
+	while (*it != cache)
+		it = &(*it)->next;
+
+	*it = cache->next;
+
+	retiredAllocatedSize += cache->allocatedSize.exchange(0);
+	retiredAllocationCount += cache->allocationCount.exchange(0);
+
+	cache->next = retiredCaches;
+	retiredCaches = cache;
+}
+
+void* ThreadCacheAllocator::AllocateSmall(ThreadCache* cache, uint64 size, uint32 sizeClass)
+{
+	if (!cache->heads[sizeClass])
+		Refill(cache, sizeClass);
+
+	FreeBlock* block = cache->heads[sizeClass];
+
+	cache->heads[sizeClass] = block->next;
+	--cache->counts[sizeClass];
+
+	GetBlockHeader(block)->size = size;
+	AddStats(cache, (int64)size, 1);
+
+	return block;
+}
+
+void* ThreadCacheAllocator::AllocateLarge(uint64 size, uint32 align)
+{
+	uint32 offset = align > sizeof(BlockHeader) ? align : (uint32)sizeof(BlockHeader);
+	uint64 totalSize = size + offset;
+	char* base;
+
+	{
+		std::lock_guard<std::mutex> guard(backingLock);
+		base = (char*)backingAlloc->Allocate(totalSize, align > SMALL_ALIGN ? align : SMALL_ALIGN);
+	}
+
+	void* ptr = base + offset;
+	BlockHeader* header = GetBlockHeader(ptr);
+
+	header->size = size;
+	header->sizeClass = LARGE_SIZE_CLASS;
+	header->offset = offset;
+
+	backingAllocatedSize.fetch_add(totalSize, std::memory_order_relaxed);
+
+	if (ThreadCache* cache = GetThreadCache())
+		AddStats(cache, (int64)size, 1);
+	else
+	{
+		std::lock_guard<std::mutex> guard(cachesLock);
+		retiredAllocatedSize += (int64)size;
+		++retiredAllocationCount;
+	}
+
+	return ptr;
+}
+
+void ThreadCacheAllocator::FreeSmall(ThreadCache* cache, void* ptr, uint32 sizeClass)
+{
+	FreeBlock* block = (FreeBlock*)ptr;
+	int64 size = (int64)GetBlockHeader(ptr)->size;
+
+	if (!cache)
+	{
+		{
+			CentralList& list = centralLists[sizeClass];
+			std::lock_guard<std::mutex> guard(list.lock);
+
+			block->next = list.head;
+			list.head = block;
+			++list.count;
+		}
+
+		std::lock_guard<std::mutex> guard(cachesLock);
+		retiredAllocatedSize -= size;
+		--retiredAllocationCount;
+
+		return;
+	}
+
+	block->next = cache->heads[sizeClass];
+	cache->heads[sizeClass] = block;
+	++cache->counts[sizeClass];
+
+	AddStats(cache, -size, -1);
+
+	uint32 batchCount = BatchCount(sizeClass);
+
+	if (cache->counts[sizeClass] > 2 * batchCount)
+		Drain(cache, sizeClass, batchCount);
+}
+
+void ThreadCacheAllocator::FreeLarge(void* ptr)
+{
+	BlockHeader* header = GetBlockHeader(ptr);
+	int64 size = (int64)header->size;
+	char* base = (char*)ptr - header->offset;
+
+	backingAllocatedSize.fetch_sub(size + header->offset, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> guard(backingLock);
+		backingAlloc->Free(base);
+	}
+
+	if (ThreadCache* cache = GetThreadCache())
+		AddStats(cache, -size, -1);
+	else
+	{
+		std::lock_guard<std::mutex> guard(cachesLock);
+		retiredAllocatedSize -= size;
+		--retiredAllocationCount;
+	}
+}
+
+void ThreadCacheAllocator::Refill(ThreadCache* cache, uint32 sizeClass)
+{
+	CentralList& list = centralLists[sizeClass];
+	std::lock_guard<std::mutex> guard(list.lock);
+	uint32 batchCount = BatchCount(sizeClass);
+
+	if (list.count < batchCount)
+		CarveSlab(sizeClass);
+
+	for (uint32 i = 0; i < batchCount; ++i)
+	{
+		FreeBlock* block = list.head;
+
+		list.head = block->next;
+		block->next = cache->heads[sizeClass];
+		cache->heads[sizeClass] = block;
+	}
+
+	list.count -= batchCount;
+	cache->counts[sizeClass] += batchCount;
+}
+
+void ThreadCacheAllocator::Drain(ThreadCache* cache, uint32 sizeClass, uint32 count)
+{
+	if (count == 0)
+		return;
+
+	FreeBlock* first = cache->heads[sizeClass];
+	FreeBlock* last = first;
+
+	for (uint32 i = 1; i < count; ++i)
+		last = last->next;
+
+	cache->heads[sizeClass] = last->next;
+	cache->counts[sizeClass] -= count;
+
+	CentralList& list = centralLists[sizeClass];
+	std::lock_guard<std::mutex> guard(list.lock);
+
+	last->next = list.head;
+	list.head = first;
+	list.count += count;
+}
+
+void ThreadCacheAllocator::CarveSlab(uint32 sizeClass)
+{
+	CentralList& list = centralLists[sizeClass];
+	uint64 stride = BlockStride(sizeClass);
+	uint64 blockCount = SLAB_SIZE / stride;
+
+	if (blockCount < BatchCount(sizeClass))
+		blockCount = BatchCount(sizeClass);
+
+	uint64 slabSize = SMALL_ALIGN + blockCount * stride;
+	Slab* slab;
+
+	{
+		std::lock_guard<std::mutex> guard(backingLock);
+		slab = (Slab*)backingAlloc->Allocate(slabSize, SMALL_ALIGN);
+		slab->next = slabs;
+		slabs = slab;
+	}
+
+	backingAllocatedSize.fetch_add(slabSize, std::memory_order_relaxed);
+
+	char* blocks = (char*)slab + SMALL_ALIGN;
+
+	for (uint64 i = blockCount; i > 0; --i)
+	{
+		BlockHeader* header = (BlockHeader*)(blocks + (i - 1) * stride);
+		FreeBlock* block = (FreeBlock*)((char*)header + sizeof(BlockHeader));
+
+		header->size = 0;
+		header->sizeClass = sizeClass;
+		header->offset = sizeof(BlockHeader);
+
+		block->next = list.head;
+		list.head = block;
+	}
+
+	list.count += (uint32)blockCount;
+}
+}
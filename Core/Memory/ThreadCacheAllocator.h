@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include "IAllocator.h"
+
+namespace ducklib
+{
+/**
+ * Thread caching front-end for another allocator. Small allocations are rounded up to power of two size classes and
+ * served from per-thread free lists without any locking. The per-thread lists are refilled from and drained to shared
+ * per-class lists in batches, and only those touch a lock. Large or over-aligned allocations go directly to the backing
+ * allocator.
+ *
+ * Statistics are kept per thread and summed up in GetStats(), so they stay correct with any number of threads.
+ */
+class ThreadCacheAllocator final : public IAllocator
+{
+public:
+	ThreadCacheAllocator(IAllocator* backingAlloc);
+	~ThreadCacheAllocator() override;
+
+	ThreadCacheAllocator(const ThreadCacheAllocator&) = delete;
+	ThreadCacheAllocator& operator=(const ThreadCacheAllocator&) = delete;
+
+	AllocatorStats GetStats() const override;
+
+	/**
+	 * Returns the calling thread's cached blocks to the shared lists. Done automatically when a thread exits.
+	 */
+	void ReleaseThreadCache();
+
+	static constexpr uint32 MIN_SIZE_CLASS_SHIFT = 4;
+	static constexpr uint32 NUM_SIZE_CLASSES = 12;
+	static constexpr uint64 MAX_SMALL_SIZE = 1ull << (MIN_SIZE_CLASS_SHIFT + NUM_SIZE_CLASSES - 1);
+	static constexpr uint32 SMALL_ALIGN = 16;
+
+	struct ThreadCache;
+
+protected:
+	void* AllocateInternal(uint64 size, uint32 align) override;
+	void* ReallocateInternal(void* ptr, uint64 size) override;
+	void FreeInternal(void* ptr) override;
+
+	struct BlockHeader
+	{
+		uint64 size;
+		uint32 sizeClass;
+		uint32 offset;
+	};
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	struct alignas(CACHE_LINE_SIZE) CentralList
+	{
+		std::mutex lock;
+		FreeBlock* head;
+		uint32 count;
+	};
+
+	struct Slab
+	{
+		Slab* next;
+	};
+
+	static constexpr uint32 LARGE_SIZE_CLASS = ~0u;
+	static constexpr uint64 SLAB_SIZE = 64 * 1024;
+
+	static uint32 SizeClass(uint64 size);
+	static uint64 ClassSize(uint32 sizeClass);
+	static uint64 BlockStride(uint32 sizeClass);
+	static uint32 BatchCount(uint32 sizeClass);
+	static BlockHeader* GetBlockHeader(void* ptr);
+
+	ThreadCache* GetThreadCache();
+	ThreadCache* CreateThreadCache();
+	void RetireThreadCache(ThreadCache* cache);
+
+	void* AllocateSmall(ThreadCache* cache, uint64 size, uint32 sizeClass);
+	void* AllocateLarge(uint64 size, uint32 align);
+	void FreeSmall(ThreadCache* cache, void* ptr, uint32 sizeClass);
+	void FreeLarge(void* ptr);
+
+	void Refill(ThreadCache* cache, uint32 sizeClass);
+	void Drain(ThreadCache* cache, uint32 sizeClass, uint32 count);
+	void CarveSlab(uint32 sizeClass);
+
+	friend struct ThreadCacheSlots;
+
+	const uint64 id;
+	IAllocator* backingAlloc;
+	ThreadCacheAllocator* nextLive;
+
+	CentralList centralLists[NUM_SIZE_CLASSES];
+
+	std::mutex backingLock;
+	Slab* slabs;
+	std::atomic<uint64> backingAllocatedSize;
+
+	mutable std::mutex cachesLock;
+	ThreadCache* activeCaches;
+	ThreadCache* retiredCaches;
+	int64 retiredAllocatedSize;
+	int64 retiredAllocationCount;
+};
+}
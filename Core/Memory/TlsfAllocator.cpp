@@ -0,0 +1,501 @@
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include "TlsfAllocator.h"
+#include "HeapAllocator.h"
+#include "../Utility.h"
+
+namespace ducklib
+{
+namespace Internal::Memory
+{
+/**
+ * Only size is always valid. prevPhysBlock lies at the end of the previous block and is only written when that block
+ * is free. The free list links overlap the user data and are only valid while the block is free.
+ */
+struct TlsfBlock
+{
+	TlsfBlock* prevPhysBlock;
+	uint64 size; // Lowest two bits are flags, sizes are always multiples of ALIGN_SIZE
+	TlsfBlock* nextFree;
+	TlsfBlock* prevFree;
+};
+}
+
+namespace
+{
+using Block = Internal::Memory::TlsfBlock;
+
+constexpr uint64 BLOCK_FREE_BIT = 1 << 0;
+constexpr uint64 BLOCK_PREV_FREE_BIT = 1 << 1;
+constexpr uint64 BLOCK_START_OFFSET = offsetof(Block, size) + sizeof(uint64);
+constexpr uint64 BLOCK_SIZE_MIN = sizeof(Block) - sizeof(Block*);
+
+uint64 BlockSize(const Block* block)
+{
+	return block->size & ~(BLOCK_FREE_BIT | BLOCK_PREV_FREE_BIT);
+}
+
+void SetBlockSize(Block* block, uint64 size)
+{
+	block->size = size | (block->size & (BLOCK_FREE_BIT | BLOCK_PREV_FREE_BIT));
+}
+
+bool IsFree(const Block* block)
+{
+	return block->size & BLOCK_FREE_BIT;
+}
+
+bool IsPrevFree(const Block* block)
+{
+	return block->size & BLOCK_PREV_FREE_BIT;
+}
+
+void SetFree(Block* block, bool isFree)
+{
+	block->size = isFree ? block->size | BLOCK_FREE_BIT : block->size & ~BLOCK_FREE_BIT;
+}
+
+void SetPrevFree(Block* block, bool isPrevFree)
+{
+	block->size = isPrevFree ? block->size | BLOCK_PREV_FREE_BIT : block->size & ~BLOCK_PREV_FREE_BIT;
+}
+
+Block* OffsetToBlock(const void* ptr, int64 offset)
+{
+	return (Block*)((char*)ptr + offset);
+}
+
+void* BlockToPtr(const Block* block)
+{
+	return (char*)block + BLOCK_START_OFFSET;
+}
+
+Block* BlockFromPtr(const void* ptr)
+{
+	return (Block*)((char*)ptr - BLOCK_START_OFFSET);
+}
+
+Block* NextBlock(const Block* block)
+{
+	return OffsetToBlock(BlockToPtr(block), (int64)(BlockSize(block) - TlsfAllocator::ALLOC_OVERHEAD));
+}
+
+Block* LinkNext(Block* block)
+{
+	Block* next = NextBlock(block);
+	next->prevPhysBlock = block;
+	return next;
+}
+
+void MarkAsFree(Block* block)
+{
+	SetPrevFree(LinkNext(block), true);
+	SetFree(block, true);
+}
+
+void MarkAsUsed(Block* block)
+{
+	SetPrevFree(NextBlock(block), false);
+	SetFree(block, false);
+}
+
+bool CanSplit(const Block* block, uint64 size)
+{
+	return BlockSize(block) >= sizeof(Block) + size;
+}
+
+Block* Split(Block* block, uint64 size)
+{
+	Block* remaining = OffsetToBlock(BlockToPtr(block), (int64)(size - TlsfAllocator::ALLOC_OVERHEAD));
+	uint64 remainingSize = BlockSize(block) - (size + TlsfAllocator::ALLOC_OVERHEAD);
+
+	remaining->size = 0;
+	SetBlockSize(remaining, remainingSize);
+	SetBlockSize(block, size);
+	MarkAsFree(remaining);
+
+	return remaining;
+}
+
+Block* Absorb(Block* prev, Block* block)
+{
+	prev->size += BlockSize(block) + TlsfAllocator::ALLOC_OVERHEAD;
+	LinkNext(prev);
+	return prev;
+}
+
+uint64 AlignUp(uint64 value, uint64 align)
+{
+	return (value + align - 1) & ~(align - 1);
+}
+
+uint64 AdjustRequestSize(uint64 size, uint64 align)
+{
+	uint64 aligned = AlignUp(size, align);
+
+	if (aligned >= TlsfAllocator::MAX_POOL_SIZE)
+		return 0;
+
+	return aligned > BLOCK_SIZE_MIN ? aligned : BLOCK_SIZE_MIN;
+}
+
+uint32 HighestBit(uint64 value)
+{
+	return (uint32)std::bit_width(value) - 1;
+}
+
+void MappingInsert(uint64 size, uint32& fl, uint32& sl)
+{
+	if (size < TlsfAllocator::SMALL_BLOCK_SIZE)
+	{
+		fl = 0;
+		sl = (uint32)(size / (TlsfAllocator::SMALL_BLOCK_SIZE / TlsfAllocator::SL_INDEX_COUNT));
+	}
+	else
+	{
+		fl = HighestBit(size);
+		sl = (uint32)(size >> (fl - TlsfAllocator::SL_INDEX_COUNT_LOG2)) ^ TlsfAllocator::SL_INDEX_COUNT;
+		fl -= TlsfAllocator::FL_INDEX_SHIFT - 1;
+	}
+}
+
+// Rounds the size up to the next list so that any block found there is guaranteed to fit
+void MappingSearch(uint64 size, uint32& fl, uint32& sl)
+{
+	if (size >= TlsfAllocator::SMALL_BLOCK_SIZE)
+		size += (1ull << (HighestBit(size) - TlsfAllocator::SL_INDEX_COUNT_LOG2)) - 1;
+
+	MappingInsert(size, fl, sl);
+}
+}
+
+TlsfAllocator::TlsfAllocator(void* memory, uint64 size)
+	: flBitmap(0)
+	, slBitmap{}
+	, freeBlocks{}
+	, freeSize(0)
+	, freeBlockCount(0)
+{
+	if (size < ALIGN_SIZE + 2 * ALLOC_OVERHEAD + BLOCK_SIZE_MIN)
+		throw std::runtime_error("Memory block too small for TLSF allocator");
+
+	char* alignedMemory = (char*)Internal::Memory::NextAlign(memory, ALIGN_SIZE);
+	uint64 alignedSize = size - (alignedMemory - (char*)memory);
+
+	// The pool also needs room for the zero sized sentinel block at the end
+	poolSize = (alignedSize - 2 * ALLOC_OVERHEAD) & ~(uint64)(ALIGN_SIZE - 1);
+
+	if (poolSize >= MAX_POOL_SIZE)
+		throw std::runtime_error("Memory block too large for TLSF allocator");
+
+	// The first block's prevPhysBlock would lie outside the memory, but it is never accessed since nothing precedes it
+	Block* block = OffsetToBlock(alignedMemory, -(int64)ALLOC_OVERHEAD);
+
+	block->size = 0;
+	SetBlockSize(block, poolSize);
+	SetFree(block, true);
+	SetPrevFree(block, false);
+	InsertFreeBlock(block);
+
+	Block* sentinel = LinkNext(block);
+
+	sentinel->size = 0;
+	SetFree(sentinel, false);
+	SetPrevFree(sentinel, true);
+
+	totalAllocatedSize = 0;
+}
+
+TlsfAllocator::~TlsfAllocator()
+{
+	if (allocationCount > 0)
+		Utility::DebugOutput("Not all allocations freed in TLSF allocator");
+}
+
+TlsfStats TlsfAllocator::GetTlsfStats() const
+{
+	uint64 largestFreeBlockSize = 0;
+
+	if (flBitmap)
+	{
+		uint32 fl = HighestBit(flBitmap);
+		uint32 sl = HighestBit(slBitmap[fl]);
+
+		for (Block* block = freeBlocks[fl][sl]; block; block = block->nextFree)
+			if (BlockSize(block) > largestFreeBlockSize)
+				largestFreeBlockSize = BlockSize(block);
+	}
+
+	float fragmentation = freeSize > 0 ? 1.0f - (float)largestFreeBlockSize / (float)freeSize : 0.0f;
+
+	return { poolSize, freeSize, largestFreeBlockSize, freeBlockCount, allocationCount, fragmentation };
+}
+
+void* TlsfAllocator::AllocateInternal(uint64 size, uint32 align)
+{
+	uint64 adjustedSize = AdjustRequestSize(size, ALIGN_SIZE);
+
+	if (align <= ALIGN_SIZE)
+		return PrepareUsed(LocateFreeBlock(adjustedSize), adjustedSize);
+
+	// Search for a block large enough to move the start forward to the alignment. Any gap left in front has to be
+	// able to hold a free block.
+	constexpr uint64 gapMinimum = sizeof(Block);
+	uint64 sizeWithGap = AdjustRequestSize(adjustedSize + align + gapMinimum, align);
+	Block* block = LocateFreeBlock(sizeWithGap);
+	char* ptr = (char*)BlockToPtr(block);
+	char* aligned = (char*)Internal::Memory::NextAlign(ptr, align);
+	uint64 gap = aligned - ptr;
+
+	if (gap && gap < gapMinimum)
+	{
+		uint64 gapRemaining = gapMinimum - gap;
+		uint64 offset = gapRemaining > align ? gapRemaining : align;
+
+		aligned = (char*)Internal::Memory::NextAlign(aligned + offset, align);
+		gap = aligned - ptr;
+	}
+
+	if (gap)
+		block = TrimFreeLeading(block, gap);
+
+	return PrepareUsed(block, adjustedSize);
+}
+
+void* TlsfAllocator::ReallocateInternal(void* ptr, uint64 size)
+{
+	// The original alignment isn't stored, keep whatever the pointer has up to a cache line
+	uintptr_t ptrAlign = (uintptr_t)ptr & (~(uintptr_t)ptr + 1);
+	uint32 align = ptrAlign < CACHE_LINE_SIZE ? (uint32)ptrAlign : CACHE_LINE_SIZE;
+
+	return ReallocateAligned(ptr, size, align);
+}
+
+void* TlsfAllocator::ReallocateSizedInternal(void* ptr, uint64 oldSize, uint64 newSize, uint32 align)
+{
+	return ReallocateAligned(ptr, newSize, align);
+}
+
+void* TlsfAllocator::ReallocateAligned(void* ptr, uint64 size, uint32 align)
+{
+	Block* block = BlockFromPtr(ptr);
+	Block* next = NextBlock(block);
+	uint64 currentSize = BlockSize(block);
+	uint64 combinedSize = currentSize + BlockSize(next) + ALLOC_OVERHEAD;
+	uint64 adjustedSize = AdjustRequestSize(size, ALIGN_SIZE);
+
+	if (adjustedSize > currentSize && (!IsFree(next) || adjustedSize > combinedSize))
+	{
+		void* newPtr = AllocateInternal(size, align);
+
+		memcpy(newPtr, ptr, currentSize < size ? currentSize : size);
+		FreeInternal(ptr);
+
+		return newPtr;
+	}
+
+	// Grow into the next free block or shrink in place
+	if (adjustedSize > currentSize)
+	{
+		MergeNext(block);
+		MarkAsUsed(block);
+	}
+
+	TrimUsed(block, adjustedSize);
+
+	allocatedSize += BlockSize(block) - currentSize;
+	totalAllocatedSize += BlockSize(block) - currentSize;
+
+	return ptr;
+}
+
+void TlsfAllocator::FreeInternal(void* ptr)
+{
+	Block* block = BlockFromPtr(ptr);
+	uint64 blockSize = BlockSize(block);
+
+	allocatedSize -= blockSize;
+	totalAllocatedSize -= blockSize + ALLOC_OVERHEAD;
+	--allocationCount;
+
+	MarkAsFree(block);
+	block = MergePrev(block);
+	block = MergeNext(block);
+	InsertFreeBlock(block);
+}
+
+void TlsfAllocator::InsertFreeBlock(Block* block)
+{
+	uint32 fl, sl;
+	MappingInsert(BlockSize(block), fl, sl);
+
+	Block* head = freeBlocks[fl][sl];
+
+	block->nextFree = head;
+	block->prevFree = nullptr;
+
+	if (head)
+		head->prevFree = block;
+
+	freeBlocks[fl][sl] = block;
+	flBitmap |= 1u << fl;
+	slBitmap[fl] |= 1u << sl;
+
+	freeSize += BlockSize(block);
+	++freeBlockCount;
+}
+
+void TlsfAllocator::RemoveFreeBlock(Block* block)
+{
+	uint32 fl, sl;
+	MappingInsert(BlockSize(block), fl, sl);
+	RemoveFreeBlock(block, fl, sl);
+}
+
+void TlsfAllocator::RemoveFreeBlock(Block* block, uint32 fl, uint32 sl)
+{
+	Block* prev = block->prevFree;
+	Block* next = block->nextFree;
+
+	if (next)
+		next->prevFree = prev;
+
+	if (prev)
+		prev->nextFree = next;
+	else
+	{
+		freeBlocks[fl][sl] = next;
+
+		if (!next)
+		{
+			slBitmap[fl] &= ~(1u << sl);
+
+			if (!slBitmap[fl])
+				flBitmap &= ~(1u << fl);
+		}
+	}
+
+	freeSize -= BlockSize(block);
+	--freeBlockCount;
+}
+
+TlsfAllocator::Block* TlsfAllocator::FindSuitableBlock(uint32& fl, uint32& sl) const
+{
+	uint32 slMap = slBitmap[fl] & (~0u << sl);
+
+	if (!slMap)
+	{
+		uint32 flMap = fl + 1 < 32 ? flBitmap & (~0u << (fl + 1)) : 0;
+
+		if (!flMap)
+			return nullptr;
+
+		fl = (uint32)std::countr_zero(flMap);
+		slMap = slBitmap[fl];
+	}
+
+	sl = (uint32)std::countr_zero(slMap);
+
+	return freeBlocks[fl][sl];
+}
+
+TlsfAllocator::Block* TlsfAllocator::LocateFreeBlock(uint64 size)
+{
+	uint32 fl = 0;
+	uint32 sl = 0;
+	Block* block = nullptr;
+
+	if (size)
+	{
+		MappingSearch(size, fl, sl);
+
+		if (fl < FL_INDEX_COUNT)
+			block = FindSuitableBlock(fl, sl);
+	}
+
+	if (!block)
+		throw std::runtime_error("TLSF allocator out of memory");
+
+	RemoveFreeBlock(block, fl, sl);
+
+	return block;
+}
+
+TlsfAllocator::Block* TlsfAllocator::MergePrev(Block* block)
+{
+	if (!IsPrevFree(block))
+		return block;
+
+	Block* prev = block->prevPhysBlock;
+
+	RemoveFreeBlock(prev);
+
+	return Absorb(prev, block);
+}
+
+TlsfAllocator::Block* TlsfAllocator::MergeNext(Block* block)
+{
+	Block* next = NextBlock(block);
+
+	if (!IsFree(next))
+		return block;
+
+	RemoveFreeBlock(next);
+
+	return Absorb(block, next);
+}
+
+void TlsfAllocator::TrimFree(Block* block, uint64 size)
+{
+	if (!CanSplit(block, size))
+		return;
+
+	Block* remaining = Split(block, size);
+
+	LinkNext(block);
+	SetPrevFree(remaining, true);
+	InsertFreeBlock(remaining);
+}
+
+void TlsfAllocator::TrimUsed(Block* block, uint64 size)
+{
+	if (!CanSplit(block, size))
+		return;
+
+	Block* remaining = Split(block, size);
+
+	SetPrevFree(remaining, false);
+	remaining = MergeNext(remaining);
+	InsertFreeBlock(remaining);
+}
+
+TlsfAllocator::Block* TlsfAllocator::TrimFreeLeading(Block* block, uint64 size)
+{
+	if (!CanSplit(block, size))
+		return block;
+
+	Block* remaining = Split(block, size - ALLOC_OVERHEAD);
+
+	SetPrevFree(remaining, true);
+	LinkNext(block);
+	InsertFreeBlock(block);
+
+	return remaining;
+}
+
+void* TlsfAllocator::PrepareUsed(Block* block, uint64 size)
+{
+	TrimFree(block, size);
+	MarkAsUsed(block);
+
+	uint64 blockSize = BlockSize(block);
+
+	allocatedSize += blockSize;
+	totalAllocatedSize += blockSize + ALLOC_OVERHEAD;
+	++allocationCount;
+
+	return BlockToPtr(block);
+}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "IAllocator.h"
+
+namespace ducklib
+{
+namespace Internal::Memory
+{
+struct TlsfBlock;
+}
+
+struct TlsfStats
+{
+	uint64 poolSize;
+	uint64 freeSize;
+	uint64 largestFreeBlockSize;
+	uint32 freeBlockCount;
+	uint32 usedBlockCount;
+
+	// 0 when all free memory is in one block, approaching 1 when it is scattered into small blocks
+	float fragmentation;
+};
+
+/**
+ * Two-Level Segregated Fit allocator over a memory block supplied by the caller. Free blocks are kept in lists
+ * segregated by size with a two-level bitmap over them, so finding a fitting block, splitting it and merging freed
+ * blocks with their neighbours are all O(1) in the worst case. Suitable for code that needs bounded allocation
+ * latency. Not thread safe.
+ *
+ * Each allocation has a header of ALLOC_OVERHEAD bytes. The memory block has to stay valid until the allocator is
+ * destroyed and can be at most MAX_POOL_SIZE bytes.
+ */
+class TlsfAllocator final : public IAllocator
+{
+public:
+	TlsfAllocator(void* memory, uint64 size);
+	~TlsfAllocator() override;
+
+	TlsfAllocator(const TlsfAllocator&) = delete;
+	TlsfAllocator& operator=(const TlsfAllocator&) = delete;
+
+	TlsfStats GetTlsfStats() const;
+
+	static constexpr uint32 ALIGN_SIZE_LOG2 = 3;
+	static constexpr uint32 ALIGN_SIZE = 1 << ALIGN_SIZE_LOG2;
+	static constexpr uint32 SL_INDEX_COUNT_LOG2 = 5;
+	static constexpr uint32 SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;
+	static constexpr uint32 FL_INDEX_MAX = 32;
+	static constexpr uint32 FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2;
+	static constexpr uint32 FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+	static constexpr uint64 SMALL_BLOCK_SIZE = 1ull << FL_INDEX_SHIFT;
+	static constexpr uint64 MAX_POOL_SIZE = 1ull << FL_INDEX_MAX;
+	static constexpr uint64 ALLOC_OVERHEAD = sizeof(uint64);
+
+protected:
+	using Block = Internal::Memory::TlsfBlock;
+
+	void* AllocateInternal(uint64 size, uint32 align) override;
+	void* ReallocateInternal(void* ptr, uint64 size) override;
+	void FreeInternal(void* ptr) override;
+	void* ReallocateSizedInternal(void* ptr, uint64 oldSize, uint64 newSize, uint32 align) override;
+
+	void* ReallocateAligned(void* ptr, uint64 size, uint32 align);
+
+	void InsertFreeBlock(Block* block);
+	void RemoveFreeBlock(Block* block);
+	void RemoveFreeBlock(Block* block, uint32 fl, uint32 sl);
+	Block* FindSuitableBlock(uint32& fl, uint32& sl) const;
+	Block* LocateFreeBlock(uint64 size);
+
+	Block* MergePrev(Block* block);
+	Block* MergeNext(Block* block);
+	void TrimFree(Block* block, uint64 size);
+	void TrimUsed(Block* block, uint64 size);
+	Block* TrimFreeLeading(Block* block, uint64 size);
+	void* PrepareUsed(Block* block, uint64 size);
+
+	uint32 flBitmap;
+	uint32 slBitmap[FL_INDEX_COUNT];
+	Block* freeBlocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+	uint64 poolSize;
+	uint64 freeSize;
+	uint32 freeBlockCount;
+};
+}
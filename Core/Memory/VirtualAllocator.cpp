@@ -0,0 +1,166 @@
+#include <stdexcept>
+#include "VirtualAllocator.h"
+#include "HeapAllocator.h"
+#include "../Utility.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace ducklib
+{
+using namespace Internal::Memory;
+
+VirtualAllocator::VirtualAllocator(uint64 reserveSize)
+	: reserveSize(RoundUpToPageSize(reserveSize)) {}
+
+VirtualAllocator::~VirtualAllocator()
+{
+	if (totalAllocatedSize > 0 || allocatedSize > 0)
+		Utility::DebugOutput("Not all allocations freed in virtual allocator");
+}
+
+uint64 VirtualAllocator::ReserveSize() const
+{
+	return reserveSize;
+}
+
+void* VirtualAllocator::AllocateInternal(uint64 size, uint32 align)
+{
+	if (size > reserveSize)
+		throw std::runtime_error("Allocation is larger than virtual allocator reserve size");
+
+	// Reserve extra for the header and alignment so that the full reserve size is always usable
+	uint64 reservedSize = RoundUpToPageSize(reserveSize + sizeof(VirtualHeader) + align);
+	char* base = (char*)ReserveAddressSpace(reservedSize);
+	char* dataPtr = (char*)NextAlign(base + sizeof(VirtualHeader), align);
+	uint64 committedSize = RoundUpToPageSize(dataPtr - base + size);
+
+	CommitPages(base, committedSize);
+
+	VirtualHeader* header = (VirtualHeader*)(dataPtr - sizeof(VirtualHeader));
+
+	header->base = base;
+	header->reservedSize = reservedSize;
+	header->committedSize = committedSize;
+	header->size = size;
+
+	totalAllocatedSize += committedSize;
+	allocatedSize += size;
+	++allocationCount;
+
+	return dataPtr;
+}
+
+void* VirtualAllocator::ReallocateInternal(void* ptr, uint64 size)
+{
+	VirtualHeader* header = (VirtualHeader*)((char*)ptr - sizeof(VirtualHeader));
+	char* base = header->base;
+	uint64 dataOffset = (char*)ptr - base;
+	uint64 newCommittedSize = RoundUpToPageSize(dataOffset + size);
+	uint64 oldCommittedSize = header->committedSize;
+
+	if (newCommittedSize > header->reservedSize)
+		throw std::runtime_error("Reallocation doesn't fit in virtual allocator reservation");
+
+	if (newCommittedSize > oldCommittedSize)
+		CommitPages(base + oldCommittedSize, newCommittedSize - oldCommittedSize);
+	else if (newCommittedSize < oldCommittedSize)
+		DecommitPages(base + newCommittedSize, oldCommittedSize - newCommittedSize);
+
+	totalAllocatedSize += newCommittedSize - oldCommittedSize;
+	allocatedSize += size - header->size;
+
+	header->committedSize = newCommittedSize;
+	header->size = size;
+
+	return ptr;
+}
+
+void VirtualAllocator::FreeInternal(void* ptr)
+{
+	VirtualHeader* header = (VirtualHeader*)((char*)ptr - sizeof(VirtualHeader));
+
+	totalAllocatedSize -= header->committedSize;
+	allocatedSize -= header->size;
+	--allocationCount;
+
+	ReleaseAddressSpace(header->base, header->reservedSize);
+}
+
+namespace Internal::Memory
+{
+uint64 GetPageSize()
+{
+	static const uint64 pageSize = []
+	{
+#ifdef _WIN32
+		SYSTEM_INFO sysInfo;
+		GetSystemInfo(&sysInfo);
+		return (uint64)sysInfo.dwPageSize;
+#else
+		return (uint64)sysconf(_SC_PAGESIZE);
+#endif
+	}();
+
+	return pageSize;
+}
+
+uint64 RoundUpToPageSize(uint64 size)
+{
+	uint64 pageSize = GetPageSize();
+
+	return (size + pageSize - 1) / pageSize * pageSize;
+}
+
+void* ReserveAddressSpace(uint64 size)
+{
+#ifdef _WIN32
+	void* ptr = VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+
+	if (!ptr)
+		throw std::runtime_error("Failed to reserve address space");
+#else
+	void* ptr = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+	if (ptr == MAP_FAILED)
+		throw std::runtime_error("Failed to reserve address space");
+#endif
+
+	return ptr;
+}
+
+void ReleaseAddressSpace(void* ptr, uint64 size)
+{
+#ifdef _WIN32
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+	munmap(ptr, size);
+#endif
+}
+
+void CommitPages(void* ptr, uint64 size)
+{
+#ifdef _WIN32
+	if (!VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE))
+		throw std::runtime_error("Failed to commit pages");
+#else
+	if (mprotect(ptr, size, PROT_READ | PROT_WRITE) != 0)
+		throw std::runtime_error("Failed to commit pages");
+#endif
+}
+
+void DecommitPages(void* ptr, uint64 size)
+{
+#ifdef _WIN32
+	VirtualFree(ptr, size, MEM_DECOMMIT);
+#else
+	madvise(ptr, size, MADV_DONTNEED);
+	mprotect(ptr, size, PROT_NONE);
+#endif
+}
+}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "IAllocator.h"
+
+namespace ducklib
+{
+/**
+ * Gives every allocation its own reserved range of address space and commits pages only as the allocation grows.
+ * Reallocating within the reservation never moves or copies the data, which makes it a good backing allocator for
+ * large arrays that keep growing, e.g. TArray<T> array(&virtualAlloc).
+ *
+ * Reserving is cheap but not free, and every allocation takes at least one page, so this is meant for a small number
+ * of large allocations.
+ */
+class VirtualAllocator final : public IAllocator
+{
+public:
+	VirtualAllocator(uint64 reserveSize = DEFAULT_RESERVE_SIZE);
+	~VirtualAllocator() override;
+
+	uint64 ReserveSize() const;
+
+	static constexpr uint64 DEFAULT_RESERVE_SIZE = 1ull << 30;
+
+protected:
+	void* AllocateInternal(uint64 size, uint32 align) override;
+	void* ReallocateInternal(void* ptr, uint64 size) override;
+	void FreeInternal(void* ptr) override;
+
+	const uint64 reserveSize;
+};
+
+namespace Internal::Memory
+{
+struct VirtualHeader
+{
+	char* base;
+	uint64 reservedSize;
+	uint64 committedSize;
+	uint64 size;
+};
+
+uint64 GetPageSize();
+uint64 RoundUpToPageSize(uint64 size);
+
+void* ReserveAddressSpace(uint64 size);
+void ReleaseAddressSpace(void* ptr, uint64 size);
+void CommitPages(void* ptr, uint64 size);
+void DecommitPages(void* ptr, uint64 size);
+}
+}
@@ -0,0 +1,542 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "../../Memory/HeapAllocator.h"
+#include "../../Memory/HugePageAllocator.h"
+#include "../../Memory/LinearAllocator.h"
+#include "../../Memory/PoolAllocator.h"
+#include "../../Memory/ThreadCacheAllocator.h"
+#include "../../Memory/TlsfAllocator.h"
+#include "../../Memory/VirtualAllocator.h"
+
+using namespace ducklib;
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32 DEFAULT_OPS_PER_THREAD = 200000;
+constexpr uint32 LATENCY_OPS_PER_THREAD = 20000;
+constexpr uint32 WORKING_SET_SIZE = 512;
+constexpr uint64 TLSF_POOL_SIZE = 256ull << 20;
+
+/**
+ * Plain malloc as an IAllocator so that it goes through the same interface as the others. Only supports malloc's own
+ * alignment.
+ */
+class MallocAllocator final : public IAllocator
+{
+protected:
+	void* AllocateInternal(uint64 size, uint32 align) override { return malloc(size); }
+	void* ReallocateInternal(void* ptr, uint64 size) override { return realloc(ptr, size); }
+	void FreeInternal(void* ptr) override { free(ptr); }
+};
+
+enum AllocatorFlags : uint32
+{
+	THREAD_SAFE = 1 << 0,
+	FREE_IN_ANY_ORDER = 1 << 1,
+	REALLOCATE = 1 << 2,
+};
+
+struct AllocatorEntry
+{
+	const char* name;
+	IAllocator* (*create)();
+	void (*destroy)(IAllocator*);
+	uint64 minSize;
+	uint64 maxSize;
+	uint32 maxAlign;
+	uint32 flags;
+};
+
+MallocAllocator mallocBacking;
+
+void Delete(IAllocator* alloc)
+{
+	delete alloc;
+}
+
+// The TLSF allocator lives at the start of its own pool memory
+IAllocator* CreateTlsf()
+{
+	constexpr uint64 headerSize = (sizeof(TlsfAllocator) + 63) / 64 * 64;
+	char* memory = (char*)malloc(headerSize + TLSF_POOL_SIZE);
+
+	return new (memory) TlsfAllocator(memory + headerSize, TLSF_POOL_SIZE);
+}
+
+void DestroyTlsf(IAllocator* alloc)
+{
+	alloc->~IAllocator();
+	free(alloc);
+}
+
+// New allocators only need an entry here
+const AllocatorEntry ALLOCATORS[] = {
+	{
+		"malloc",
+		[]() -> IAllocator* { return new MallocAllocator(); },
+		Delete,
+		0, ~0ull, Internal::Memory::MALLOC_ALIGN, THREAD_SAFE | FREE_IN_ANY_ORDER | REALLOCATE
+	},
+	{
+		"heap",
+		[]() -> IAllocator* { return new HeapAllocator(); },
+		Delete,
+		0, ~0ull, ~0u, FREE_IN_ANY_ORDER | REALLOCATE
+	},
+	{
+		"thread_cache",
+		[]() -> IAllocator* { return new ThreadCacheAllocator(&mallocBacking); },
+		Delete,
+		0, ~0ull, Internal::Memory::MALLOC_ALIGN, THREAD_SAFE | FREE_IN_ANY_ORDER | REALLOCATE
+	},
+	{
+		"tlsf",
+		CreateTlsf,
+		DestroyTlsf,
+		0, 1 << 20, 4096, FREE_IN_ANY_ORDER | REALLOCATE
+	},
+	{
+		"pool64",
+		[]() -> IAllocator* { return new PoolAllocator(64, 1024, 64); },
+		Delete,
+		0, 64, 64, FREE_IN_ANY_ORDER
+	},
+	{
+		"linear",
+		[]() -> IAllocator* { return new LinearAllocator(64ull << 20); },
+		Delete,
+		0, ~0ull, 4096, 0
+	},
+	{
+		"virtual",
+		[]() -> IAllocator* { return new VirtualAllocator(1 << 20); },
+		Delete,
+		4096, 1 << 20, 4096, FREE_IN_ANY_ORDER | REALLOCATE
+	},
+	{
+		"huge_page",
+		[]() -> IAllocator* { return new HugePageAllocator(64 * 1024, true, &mallocBacking); },
+		Delete,
+		0, ~0ull, Internal::Memory::MALLOC_ALIGN, THREAD_SAFE | FREE_IN_ANY_ORDER | REALLOCATE
+	},
+};
+
+struct SizeDistribution
+{
+	const char* name;
+	uint64 minSize;
+	uint64 maxSize;
+};
+
+// Sizes are log-uniform between the bounds
+const SizeDistribution SIZE_DISTRIBUTIONS[] = {
+	{ "fixed64", 64, 64 },
+	{ "small", 8, 256 },
+	{ "mixed", 8, 16384 },
+	{ "large", 4096, 1 << 20 },
+};
+
+const uint32 ALIGNMENTS[] = { 8, 64, 4096 };
+
+class Random
+{
+public:
+	Random(uint64 seed)
+		: state(seed * 0x9E3779B97F4A7C15ull | 1) {}
+
+	uint64 Next()
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+
+		return state * 0x2545F4914F6CDD1Dull;
+	}
+
+	double NextDouble()
+	{
+		return (double)(Next() >> 11) * (1.0 / (double)(1ull << 53));
+	}
+
+	uint64 NextSize(const SizeDistribution& sizes)
+	{
+		if (sizes.minSize == sizes.maxSize)
+			return sizes.minSize;
+
+		double logMin = std::log((double)sizes.minSize);
+		double logMax = std::log((double)sizes.maxSize);
+
+		return (uint64)std::exp(logMin + (logMax - logMin) * NextDouble());
+	}
+
+private:
+	uint64 state;
+};
+
+enum Operation
+{
+	OP_ALLOCATE,
+	OP_FREE,
+	OP_REALLOCATE,
+	OP_COUNT,
+};
+
+const char* OPERATION_NAMES[OP_COUNT] = { "allocate", "free", "reallocate" };
+
+// Per-thread latency samples in nanoseconds, null when only measuring throughput
+struct LatencySamples
+{
+	std::vector<uint32> samples[OP_COUNT];
+};
+
+struct Workload
+{
+	const SizeDistribution* sizes;
+	uint32 align;
+	uint32 opCount;
+};
+
+class OpTimer
+{
+public:
+	OpTimer(LatencySamples* latencies, Operation op)
+		: latencies(latencies)
+		, op(op)
+	{
+		if (latencies)
+			start = Clock::now();
+	}
+
+	~OpTimer()
+	{
+		if (latencies)
+		{
+			auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+			latencies->samples[op].push_back((uint32)std::min<int64_t>(duration, UINT32_MAX));
+		}
+	}
+
+private:
+	LatencySamples* latencies;
+	Operation op;
+	Clock::time_point start;
+};
+
+void Touch(void* ptr)
+{
+	// Keeps the allocations from being optimized out and includes the first write in the cost
+	*(volatile char*)ptr = 1;
+}
+
+uint32 RunAllocFree(IAllocator* alloc, const Workload& workload, Random& random, LatencySamples* latencies)
+{
+	for (uint32 i = 0; i < workload.opCount; ++i)
+	{
+		uint64 size = random.NextSize(*workload.sizes);
+		void* ptr;
+
+		{
+			OpTimer timer(latencies, OP_ALLOCATE);
+			ptr = alloc->Allocate(size, workload.align);
+		}
+
+		Touch(ptr);
+
+		{
+			OpTimer timer(latencies, OP_FREE);
+			alloc->Free(ptr);
+		}
+	}
+
+	return workload.opCount * 2;
+}
+
+uint32 RunChurn(IAllocator* alloc, const Workload& workload, Random& random, LatencySamples* latencies)
+{
+	void* live[WORKING_SET_SIZE];
+
+	for (void*& ptr : live)
+		ptr = alloc->Allocate(random.NextSize(*workload.sizes), workload.align);
+
+	for (uint32 i = 0; i < workload.opCount; ++i)
+	{
+		void*& ptr = live[random.Next() % WORKING_SET_SIZE];
+		uint64 size = random.NextSize(*workload.sizes);
+
+		{
+			OpTimer timer(latencies, OP_FREE);
+			alloc->Free(ptr);
+		}
+
+		{
+			OpTimer timer(latencies, OP_ALLOCATE);
+			ptr = alloc->Allocate(size, workload.align);
+		}
+
+		Touch(ptr);
+	}
+
+	for (void* ptr : live)
+		alloc->Free(ptr);
+
+	return workload.opCount * 2;
+}
+
+uint32 RunReallocate(IAllocator* alloc, const Workload& workload, Random& random, LatencySamples* latencies)
+{
+	void* live[WORKING_SET_SIZE];
+
+	for (void*& ptr : live)
+		ptr = alloc->Allocate(random.NextSize(*workload.sizes), workload.align);
+
+	for (uint32 i = 0; i < workload.opCount; ++i)
+	{
+		void*& ptr = live[random.Next() % WORKING_SET_SIZE];
+		uint64 size = random.NextSize(*workload.sizes);
+
+		{
+			OpTimer timer(latencies, OP_REALLOCATE);
+			ptr = alloc->Reallocate(ptr, size);
+		}
+
+		Touch(ptr);
+	}
+
+	for (void* ptr : live)
+		alloc->Free(ptr);
+
+	return workload.opCount;
+}
+
+struct Benchmark
+{
+	const char* name;
+	uint32 requiredFlags;
+	uint32 (*run)(IAllocator*, const Workload&, Random&, LatencySamples*);
+};
+
+const Benchmark BENCHMARKS[] = {
+	{ "alloc_free", 0, RunAllocFree },
+	{ "churn", FREE_IN_ANY_ORDER, RunChurn },
+	{ "reallocate", FREE_IN_ANY_ORDER | REALLOCATE, RunReallocate },
+};
+
+struct Options
+{
+	uint32 maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	uint32 opsPerThread = DEFAULT_OPS_PER_THREAD;
+	uint32 latencyOpsPerThread = LATENCY_OPS_PER_THREAD;
+	const char* filter = nullptr;
+	FILE* output = stdout;
+};
+
+/**
+ * Runs the benchmark on threadCount threads, each with its own allocator unless it is thread safe, and returns the
+ * throughput in operations per second. Latencies are gathered in a separate run since timing each operation slows the
+ * throughput run down.
+ */
+double RunThreads(
+	const AllocatorEntry& allocator,
+	const Benchmark& benchmark,
+	const Workload& workload,
+	uint32 threadCount,
+	std::vector<LatencySamples>* latencies)
+{
+	bool shared = allocator.flags & THREAD_SAFE;
+	IAllocator* sharedAlloc = shared ? allocator.create() : nullptr;
+	std::vector<std::thread> threads;
+	std::atomic<uint32> readyCount = 0;
+	std::atomic<bool> go = false;
+	std::atomic<uint64> totalOps = 0;
+
+	if (latencies)
+		latencies->resize(threadCount);
+
+	for (uint32 t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&, t]
+		{
+			IAllocator* alloc = shared ? sharedAlloc : allocator.create();
+			Random random(t + 1);
+
+			if (latencies)
+			{
+				for (std::vector<uint32>& samples : (*latencies)[t].samples)
+					samples.reserve(workload.opCount);
+			}
+
+			++readyCount;
+
+			while (!go)
+				std::this_thread::yield();
+
+			totalOps += benchmark.run(alloc, workload, random, latencies ? &(*latencies)[t] : nullptr);
+
+			if (!shared)
+				allocator.destroy(alloc);
+		});
+	}
+
+	while (readyCount < threadCount)
+		std::this_thread::yield();
+
+	Clock::time_point start = Clock::now();
+	go = true;
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	if (shared)
+		allocator.destroy(sharedAlloc);
+
+	return (double)totalOps / seconds;
+}
+
+uint32 Percentile(const std::vector<uint32>& sortedSamples, double percentile)
+{
+	if (sortedSamples.empty())
+		return 0;
+
+	size_t index = (size_t)(percentile * (double)(sortedSamples.size() - 1) + 0.5);
+
+	return sortedSamples[index];
+}
+
+bool Supports(const AllocatorEntry& allocator, const Benchmark& benchmark, const SizeDistribution& sizes, uint32 align)
+{
+	return (allocator.flags & benchmark.requiredFlags) == benchmark.requiredFlags
+		&& sizes.minSize >= allocator.minSize
+		&& sizes.maxSize <= allocator.maxSize
+		&& align <= allocator.maxAlign;
+}
+
+bool MatchesFilter(const Options& options, const char* allocator, const char* benchmark, const char* sizes)
+{
+	if (!options.filter)
+		return true;
+
+	char name[256];
+	snprintf(name, sizeof(name), "%s/%s/%s", allocator, benchmark, sizes);
+
+	return strstr(name, options.filter) != nullptr;
+}
+
+void RunAll(const Options& options)
+{
+	fprintf(options.output, "allocator,benchmark,sizes,align,threads,operation,ops_per_sec,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n");
+
+	for (const AllocatorEntry& allocator : ALLOCATORS)
+	{
+		for (const Benchmark& benchmark : BENCHMARKS)
+		{
+			for (const SizeDistribution& sizes : SIZE_DISTRIBUTIONS)
+			{
+				if (!MatchesFilter(options, allocator.name, benchmark.name, sizes.name))
+					continue;
+
+				for (uint32 align : ALIGNMENTS)
+				{
+					if (!Supports(allocator, benchmark, sizes, align))
+						continue;
+
+					for (uint32 threadCount = 1; threadCount <= options.maxThreads; threadCount *= 2)
+					{
+						Workload workload = { &sizes, align, options.opsPerThread };
+						double opsPerSecond = RunThreads(allocator, benchmark, workload, threadCount, nullptr);
+						std::vector<LatencySamples> latencies;
+
+						workload.opCount = options.latencyOpsPerThread;
+						RunThreads(allocator, benchmark, workload, threadCount, &latencies);
+
+						for (uint32 op = 0; op < OP_COUNT; ++op)
+						{
+							std::vector<uint32> samples;
+
+							for (const LatencySamples& threadLatencies : latencies)
+								samples.insert(samples.end(), threadLatencies.samples[op].begin(), threadLatencies.samples[op].end());
+
+							if (samples.empty())
+								continue;
+
+							std::sort(samples.begin(), samples.end());
+
+							fprintf(
+								options.output,
+								"%s,%s,%s,%u,%u,%s,%.0f,%u,%u,%u,%u,%u\n",
+								allocator.name,
+								benchmark.name,
+								sizes.name,
+								align,
+								threadCount,
+								OPERATION_NAMES[op],
+								opsPerSecond,
+								Percentile(samples, 0.5),
+								Percentile(samples, 0.9),
+								Percentile(samples, 0.99),
+								Percentile(samples, 0.999),
+								samples.back());
+						}
+
+						fflush(options.output);
+					}
+				}
+			}
+		}
+	}
+}
+
+void PrintUsage()
+{
+	fprintf(
+		stderr,
+		"Usage: Core.AllocBenchmark [--threads N] [--ops N] [--latency-ops N] [--filter allocator/benchmark/sizes] [--out file.csv]\n");
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		bool hasValue = i + 1 < argc;
+
+		if (hasValue && strcmp(argv[i], "--threads") == 0)
+			options.maxThreads = std::max(1, atoi(argv[++i]));
+		else if (hasValue && strcmp(argv[i], "--ops") == 0)
+			options.opsPerThread = std::max(1, atoi(argv[++i]));
+		else if (hasValue && strcmp(argv[i], "--latency-ops") == 0)
+			options.latencyOpsPerThread = std::max(1, atoi(argv[++i]));
+		else if (hasValue && strcmp(argv[i], "--filter") == 0)
+			options.filter = argv[++i];
+		else if (hasValue && strcmp(argv[i], "--out") == 0)
+		{
+			options.output = fopen(argv[++i], "w");
+
+			if (!options.output)
+			{
+				fprintf(stderr, "Failed to open %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	RunAll(options);
+
+	if (options.output != stdout)
+		fclose(options.output);
+
+	return 0;
+}
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "../../Memory/Containers/TArray.h"
+
+using namespace ducklib;
+using Clock = std::chrono::steady_clock;
+
+constexpr uint64 DEFAULT_BYTES_PER_RUN = 512ull << 20;
+// From L1 sized up to arrays well beyond the last level cache
+constexpr uint32 ELEMENT_COUNTS[] = { 256, 4096, 65536, 1u << 20, 1u << 24 };
+
+const char* const LEVEL_NAMES[] = { "scalar", "sse4.2", "avx2" };
+
+struct Options
+{
+	uint64 bytesPerRun = DEFAULT_BYTES_PER_RUN;
+	const char* filter = nullptr;
+	FILE* output = stdout;
+};
+
+// Keeps results alive so the calls aren't optimized out
+volatile uint64 sink;
+
+template <typename T>
+T MakeValue(uint32 i)
+{
+	if constexpr (std::is_pointer_v<T>)
+		return (T)(uintptr_t)(0x10000 + (uint64)i * 16);
+	else
+		return (T)(i % 100);
+}
+
+template <typename T>
+T MakeMissingValue()
+{
+	if constexpr (std::is_pointer_v<T>)
+		return (T)(uintptr_t)8;
+	else
+		return (T)101;
+}
+
+template <typename T>
+struct Operation
+{
+	const char* name;
+	void (*run)(TArray<T>& a);
+};
+
+template <typename T>
+const Operation<T> OPERATIONS[] = {
+	// Searching for a missing value scans the whole array
+	{ "find", [](TArray<T>& a) { sink = sink + a.Find(MakeMissingValue<T>()); } },
+	{ "count", [](TArray<T>& a) { sink = sink + a.Count(a[0]); } },
+	{ "fill", [](TArray<T>& a) { a.Fill(a[1]); } },
+	{
+		"minmax",
+		[](TArray<T>& a)
+		{
+			if constexpr (std::is_arithmetic_v<T>)
+			{
+				T min;
+				T max;
+
+				a.MinMax(min, max);
+				sink = sink + (uint64)(max - min);
+			}
+		}
+	},
+};
+
+bool MatchesFilter(const Options& options, const char* type, const char* operation)
+{
+	if (!options.filter)
+		return true;
+
+	char name[256];
+	snprintf(name, sizeof(name), "%s/%s", type, operation);
+
+	return strstr(name, options.filter) != nullptr;
+}
+
+// Returns nanoseconds per call
+template <typename T>
+double Measure(const Operation<T>& operation, TArray<T>& a, uint64 bytesPerRun)
+{
+	uint64 calls = std::max<uint64>(bytesPerRun / ((uint64)a.Length() * sizeof(T)), 4);
+
+	// Warm up caches and page in the array
+	operation.run(a);
+
+	Clock::time_point start = Clock::now();
+
+	for (uint64 i = 0; i < calls; ++i)
+		operation.run(a);
+
+	return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (double)calls;
+}
+
+template <typename T>
+void RunType(const Options& options, const char* typeName)
+{
+	ArraySimdLevel supportedLevel = GetSupportedArraySimdLevel();
+
+	for (const Operation<T>& operation : OPERATIONS<T>)
+	{
+		if (!MatchesFilter(options, typeName, operation.name))
+			continue;
+
+		if (strcmp(operation.name, "minmax") == 0 && !std::is_arithmetic_v<T>)
+			continue;
+
+		for (uint32 elementCount : ELEMENT_COUNTS)
+		{
+			TArray<T> a(elementCount);
+			double scalarNs = 0.0;
+
+			for (uint32 i = 0; i < elementCount; ++i)
+				a.Append(MakeValue<T>(i));
+
+			for (uint8 level = 0; level <= (uint8)supportedLevel; ++level)
+			{
+				SetArraySimdLevel((ArraySimdLevel)level);
+
+				double ns = Measure(operation, a, options.bytesPerRun);
+				double bytes = (double)elementCount * sizeof(T);
+
+				if (level == 0)
+					scalarNs = ns;
+
+				fprintf(
+					options.output,
+					"%s,%s,%u,%s,%.1f,%.2f,%.2f\n",
+					typeName,
+					operation.name,
+					elementCount,
+					LEVEL_NAMES[level],
+					ns,
+					bytes / ns,
+					scalarNs / ns);
+				fflush(options.output);
+			}
+		}
+	}
+
+	SetArraySimdLevel(supportedLevel);
+}
+
+void RunAll(const Options& options)
+{
+	fprintf(options.output, "type,operation,elements,level,ns_per_call,gb_per_sec,speedup_vs_scalar\n");
+
+	RunType<uint8>(options, "uint8");
+	RunType<uint32>(options, "uint32");
+	RunType<uint64>(options, "uint64");
+	RunType<float>(options, "float");
+	RunType<void*>(options, "pointer");
+}
+
+void PrintUsage()
+{
+	fprintf(stderr, "Usage: Core.ArrayBenchmark [--mb-per-run N] [--filter type/operation] [--out file.csv]\n");
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		bool hasValue = i + 1 < argc;
+
+		if (hasValue && strcmp(argv[i], "--mb-per-run") == 0)
+			options.bytesPerRun = (uint64)std::max(1, atoi(argv[++i])) << 20;
+		else if (hasValue && strcmp(argv[i], "--filter") == 0)
+			options.filter = argv[++i];
+		else if (hasValue && strcmp(argv[i], "--out") == 0)
+		{
+			options.output = fopen(argv[++i], "w");
+
+			if (!options.output)
+			{
+				fprintf(stderr, "Failed to open %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	RunAll(options);
+
+	if (options.output != stdout)
+		fclose(options.output);
+
+	return 0;
+}
@@ -64,3 +64,23 @@ TEST(AllocTest, NewDeleteArray)
 
 	EXPECT_EQ(32, v);
 }
+
+TEST(AllocTest, NewArrayDeleteArray)
+{
+	HeapAllocator alloc;
+	uint32 v = 2;
+	constexpr uint32 arraySize = 32;
+	Foo* foo = alloc.NewArray<Foo>(arraySize);
+
+	for (uint32 i = 0; i < arraySize; ++i)
+	{
+		EXPECT_EQ(16, foo[i].v1);
+		EXPECT_EQ(69, foo[i].v2);
+		foo[i].p = &v;
+	}
+
+	alloc.DeleteArray(foo, arraySize);
+
+	EXPECT_EQ(32, v);
+	EXPECT_EQ(0u, alloc.GetStats().allocationCount);
+}
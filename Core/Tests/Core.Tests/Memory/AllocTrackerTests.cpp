@@ -1,3 +1,5 @@
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include "Core/Memory/AllocTracker.h"
 
@@ -49,4 +51,91 @@ TEST( TestAllocTest, TrackDelete )
 	uint32 entryCount = allocTracker.GetEntryCount();
 
 	EXPECT_EQ( 0, entryCount );
-}
\ No newline at end of file
+}
+
+TEST( TestAllocTest, TrackManyRemoveHalf )
+{
+	AllocTracker allocTracker;
+	constexpr uint32 count = 10000;
+
+	for ( uint32 i = 1; i <= count; ++i )
+		allocTracker.Track( (void*)(uintptr_t)( i * 16 ), i, "dummy.cpp", "DoDummy", i );
+
+	for ( uint32 i = 1; i <= count; i += 2 )
+		allocTracker.Remove( (void*)(uintptr_t)( i * 16 ) );
+
+	EXPECT_EQ( count / 2, allocTracker.GetEntryCount() );
+
+	const AllocTracker::Entry* entries = allocTracker.GetEntries();
+	uint64 sizeSum = 0;
+
+	for ( uint32 i = 0; i < count / 2; ++i )
+	{
+		EXPECT_EQ( (uintptr_t)entries[i].ptr, entries[i].size * 16 );
+		EXPECT_EQ( 0u, entries[i].size % 2 );
+		sizeSum += entries[i].size;
+	}
+
+	EXPECT_EQ( (uint64)( count / 2 ) * ( count / 2 + 1 ), sizeSum );
+
+	for ( uint32 i = 2; i <= count; i += 2 )
+		allocTracker.Remove( (void*)(uintptr_t)( i * 16 ) );
+
+	EXPECT_EQ( 0, allocTracker.GetEntryCount() );
+}
+
+TEST( TestAllocTest, RemoveUntracked )
+{
+	AllocTracker allocTracker;
+
+	allocTracker.Track( (void*)0x1337, 420, "dummy.cpp", "DoDummy", 200 );
+
+	EXPECT_THROW( allocTracker.Remove( (void*)0x16 ), std::runtime_error );
+}
+
+TEST( TestAllocTest, NullptrIsIgnored )
+{
+	AllocTracker allocTracker;
+
+	allocTracker.Track( (void*)0x1337, 420, "dummy.cpp", "DoDummy", 200 );
+	allocTracker.Track( nullptr, 16, "dummy.cpp", "DoDummy", 201 );
+	allocTracker.Remove( nullptr );
+
+	EXPECT_EQ( 1, allocTracker.GetEntryCount() );
+
+	allocTracker.Modify( nullptr, (void*)0x2000, 32, "dummy.cpp", "DoDummy", 202 );
+	EXPECT_EQ( 2, allocTracker.GetEntryCount() );
+
+	allocTracker.Modify( (void*)0x2000, nullptr, 0, "dummy.cpp", "DoDummy", 203 );
+	EXPECT_EQ( 1, allocTracker.GetEntryCount() );
+	EXPECT_EQ( (void*)0x1337, allocTracker.GetEntries()[0].ptr );
+}
+
+TEST( TestAllocTest, TrackFromMultipleThreads )
+{
+	AllocTracker allocTracker;
+	constexpr uint32 threadCount = 4;
+	constexpr uint32 countPerThread = 5000;
+	std::vector<std::thread> threads;
+
+	for ( uint32 t = 0; t < threadCount; ++t )
+	{
+		threads.emplace_back( [&allocTracker, t]
+		{
+			for ( uint32 i = 1; i <= countPerThread; ++i )
+			{
+				void* ptr = (void*)(uintptr_t)( ( t * countPerThread + i ) * 64 );
+				allocTracker.Track( ptr, 64, "dummy.cpp", "DoDummy", i );
+				allocTracker.Modify( ptr, (char*)ptr + 8, 128, "dummy.cpp", "DoDummy", i );
+
+				if ( i % 2 )
+					allocTracker.Remove( (char*)ptr + 8 );
+			}
+		} );
+	}
+
+	for ( std::thread& thread : threads )
+		thread.join();
+
+	EXPECT_EQ( threadCount * countPerThread / 2, allocTracker.GetEntryCount() );
+}
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <limits>
+#include <string>
+#include "Core/Memory/Containers/TArray.h"
+
+using namespace ducklib;
+
+namespace
+{
+// Runs the check at every level the CPU supports and restores the level afterwards
+template <typename Check>
+void ForEachSimdLevel(Check check)
+{
+	ArraySimdLevel originalLevel = GetArraySimdLevel();
+
+	for (uint8 level = 0; level <= (uint8)GetSupportedArraySimdLevel(); ++level)
+	{
+		SetArraySimdLevel((ArraySimdLevel)level);
+		SCOPED_TRACE("Simd level " + std::to_string(level));
+		check();
+	}
+
+	SetArraySimdLevel(originalLevel);
+}
+
+template <typename T>
+T TestValue(uint32 i)
+{
+	// Alternate the sign and cover the whole range so both signed and unsigned ordering is exercised
+	if constexpr (std::is_floating_point_v<T>)
+		return (T)(i % 2 ? -(double)i : (double)i) * (T)1.5;
+	else
+		return (T)(i * 37u + 11u) * (T)(i % 3 ? 1 : -1);
+}
+
+template <typename T>
+void CheckKernels()
+{
+	// Lengths around every vector width and unaligned starts, so both the vector loops and the tails are used
+	T items[300];
+
+	for (uint32 i = 0; i < 300; ++i)
+		items[i] = TestValue<T>(i);
+
+	ForEachSimdLevel([&]
+	{
+		for (uint32 start = 0; start < 4; ++start)
+		{
+			for (uint32 length = 0; length < 140; length += length < 70 ? 1 : 13)
+			{
+				TArray<T> a(items + start, length);
+
+				for (uint32 i = 0; i < length; ++i)
+				{
+					uint32 expectedIndex = 0;
+
+					while (!(a[expectedIndex] == a[i]))
+						++expectedIndex;
+
+					ASSERT_EQ(expectedIndex, a.Find(a[i]));
+				}
+
+				T missing = std::numeric_limits<T>::max();
+				uint32 missingIndex = 0;
+
+				while (missingIndex < length && !(a[missingIndex] == missing))
+					++missingIndex;
+
+				ASSERT_EQ(missingIndex < length ? missingIndex : TArray<T>::NOT_FOUND, a.Find(missing));
+
+				if (length > 0)
+				{
+					T expectedMin = a[0];
+					T expectedMax = a[0];
+					T min;
+					T max;
+
+					for (uint32 i = 1; i < length; ++i)
+					{
+						expectedMin = a[i] < expectedMin ? a[i] : expectedMin;
+						expectedMax = expectedMax < a[i] ? a[i] : expectedMax;
+					}
+
+					ASSERT_TRUE(a.MinMax(min, max));
+					ASSERT_EQ(expectedMin, min);
+					ASSERT_EQ(expectedMax, max);
+				}
+
+				a.Fill((T)7);
+				ASSERT_EQ(length, a.Count((T)7));
+
+				if (length > 2)
+				{
+					a[length - 1] = (T)3;
+					a[length / 2] = (T)3;
+					ASSERT_EQ(2u, a.Count((T)3));
+					ASSERT_EQ(length / 2, a.Find((T)3));
+				}
+			}
+		}
+	});
+}
+}
+
+TEST(ArraySearchTests, SetLevelClampsToSupported)
+{
+	ArraySimdLevel originalLevel = GetArraySimdLevel();
+
+	SetArraySimdLevel(ArraySimdLevel::AVX2);
+	EXPECT_EQ(GetSupportedArraySimdLevel(), GetArraySimdLevel());
+
+	SetArraySimdLevel(ArraySimdLevel::SCALAR);
+	EXPECT_EQ(ArraySimdLevel::SCALAR, GetArraySimdLevel());
+
+	SetArraySimdLevel(originalLevel);
+}
+
+TEST(ArraySearchTests, IntegerKernels)
+{
+	CheckKernels<int8>();
+	CheckKernels<uint8>();
+	CheckKernels<int16>();
+	CheckKernels<uint16>();
+	CheckKernels<int32>();
+	CheckKernels<uint32>();
+	CheckKernels<int64>();
+	CheckKernels<uint64>();
+}
+
+TEST(ArraySearchTests, FloatingPointKernels)
+{
+	CheckKernels<float>();
+	CheckKernels<double>();
+}
+
+TEST(ArraySearchTests, UnsignedMinMaxUsesUnsignedOrder)
+{
+	ForEachSimdLevel([]
+	{
+		TArray<uint64> a;
+		uint64 min;
+		uint64 max;
+
+		for (uint32 i = 0; i < 20; ++i)
+			a.Append(i == 13 ? ~0ull : 1000 + i);
+
+		a.Append(5);
+		ASSERT_TRUE(a.MinMax(min, max));
+		EXPECT_EQ(5u, min);
+		EXPECT_EQ(~0ull, max);
+	});
+}
+
+TEST(ArraySearchTests, Pointers)
+{
+	int values[100];
+	TArray<int*> a;
+
+	for (uint32 i = 0; i < 100; ++i)
+		a.Append(&values[i % 50]);
+
+	ForEachSimdLevel([&]
+	{
+		EXPECT_EQ(42u, a.Find(&values[42]));
+		EXPECT_EQ(2u, a.Count(&values[42]));
+		EXPECT_TRUE(a.Contains(&values[49]));
+		EXPECT_FALSE(a.Contains(&values[50]));
+		EXPECT_FALSE(a.Contains(nullptr));
+	});
+
+	a.Fill(nullptr);
+	EXPECT_EQ(100u, a.Count(nullptr));
+}
+
+TEST(ArraySearchTests, NonArithmeticElements)
+{
+	TArray<std::string> a;
+
+	a.Append("a");
+	a.Append("b");
+	a.Append("b");
+
+	EXPECT_EQ(1u, a.Find("b"));
+	EXPECT_EQ(2u, a.Count("b"));
+	EXPECT_EQ(TArray<std::string>::NOT_FOUND, a.Find("c"));
+
+	a.Fill("c");
+	EXPECT_EQ(3u, a.Count("c"));
+}
+
+TEST(ArraySearchTests, EmptyArray)
+{
+	TArray<uint32> a;
+	uint32 min;
+	uint32 max;
+
+	EXPECT_EQ(TArray<uint32>::NOT_FOUND, a.Find(0));
+	EXPECT_EQ(0u, a.Count(0));
+	EXPECT_FALSE(a.MinMax(min, max));
+	a.Fill(1);
+}
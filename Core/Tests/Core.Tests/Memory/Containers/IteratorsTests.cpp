@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <execution>
+#include <iterator>
+#include <numeric>
 #include "Core/Memory/Containers/Iterators.h"
+#include "Core/Memory/Containers/TArray.h"
 
 using namespace ducklib;
 
@@ -33,3 +38,54 @@ TEST(IteratorsTest, TArrayRangedLoopEmpty)
 	for (uint32 _ : a)
 		EXPECT_TRUE(false);
 }
+
+TEST(IteratorsTest, TArrayRangedLoopVisitsAll)
+{
+	TArray<uint32> a;
+
+	for (uint32 i = 0; i < 10; ++i)
+		a.Append(i);
+
+	uint32 count = 0;
+
+	for (uint32 i : a)
+		count += i == count;
+
+	EXPECT_EQ(10u, count);
+	EXPECT_EQ(10, a.end() - a.begin());
+}
+
+TEST(IteratorsTest, TArrayIteratorConcepts)
+{
+	static_assert(std::contiguous_iterator<TArray<uint32>::Iterator>);
+	static_assert(std::contiguous_iterator<TArray<uint32>::ConstIterator>);
+
+	TArray<uint32> a;
+	const TArray<uint32>& constA = a;
+
+	a.Append(1);
+
+	TArray<uint32>::ConstIterator it = a.begin();
+
+	EXPECT_TRUE(it == constA.begin());
+	EXPECT_TRUE(a.begin() < constA.end());
+	EXPECT_EQ(a.Data(), std::to_address(a.begin()));
+}
+
+TEST(IteratorsTest, TArraySortAndSearch)
+{
+	TArray<uint32> a;
+
+	for (uint32 i = 0; i < 1000; ++i)
+		a.Append((i * 7919) % 1000);
+
+	std::sort(a.begin(), a.end());
+
+	EXPECT_TRUE(std::is_sorted(a.begin(), a.end()));
+	EXPECT_EQ(a.begin() + 500, std::lower_bound(a.begin(), a.end(), 500u));
+
+	std::sort(std::execution::par_unseq, a.begin(), a.end(), std::greater<uint32>());
+
+	EXPECT_EQ(999u, a[0]);
+	EXPECT_EQ(499500u, std::reduce(std::execution::par, a.begin(), a.end(), 0u));
+}
@@ -1,8 +1,43 @@
 #include <gtest/gtest.h>
+#include <string>
 #include "Core/Memory/Containers/TArray.h"
 
 using namespace ducklib;
 
+namespace
+{
+struct Counted
+{
+	static inline int32 liveCount = 0;
+
+	Counted(uint32 value = 0)
+		: value(value)
+		, self(this)
+	{
+		++liveCount;
+	}
+
+	Counted(const Counted& other)
+		: Counted(other.value) {}
+
+	Counted(Counted&& other) noexcept
+		: Counted(other.value)
+	{
+		other.value = 0;
+	}
+
+	~Counted()
+	{
+		--liveCount;
+	}
+
+	uint32 value;
+
+	// Only valid if the object was never moved with memcpy
+	Counted* self;
+};
+}
+
 TEST(TArrayTests, Simple)
 {
 	TArray<uint32> a;
@@ -244,3 +279,125 @@ TEST(TArrayTests, Reserve)
 	EXPECT_EQ(0, a.Length());
 	EXPECT_LE((uint32)4, a.Capacity());
 }
+
+TEST(TArrayTests, NonTrivialElementsGrow)
+{
+	{
+		TArray<Counted> a;
+
+		for (uint32 i = 0; i < 100; ++i)
+			a.EmplaceBack(i);
+
+		EXPECT_EQ(100, Counted::liveCount);
+
+		for (uint32 i = 0; i < 100; ++i)
+		{
+			EXPECT_EQ(i, a[i].value);
+			EXPECT_EQ(&a[i], a[i].self);
+		}
+	}
+
+	EXPECT_EQ(0, Counted::liveCount);
+}
+
+TEST(TArrayTests, ResizeConstructsAndDestroys)
+{
+	TArray<Counted> a;
+
+	a.Resize(10);
+
+	EXPECT_EQ(10, Counted::liveCount);
+
+	a.Resize(3);
+
+	EXPECT_EQ(3, Counted::liveCount);
+	EXPECT_EQ(3u, a.Length());
+
+	a.Resize(0);
+
+	EXPECT_EQ(0, Counted::liveCount);
+}
+
+TEST(TArrayTests, RemoveLastDestroys)
+{
+	TArray<Counted> a;
+
+	a.Append(Counted(1));
+	a.Append(Counted(2));
+	a.RemoveLast();
+
+	EXPECT_EQ(1, Counted::liveCount);
+	ASSERT_EQ(1u, a.Length());
+	EXPECT_EQ(1u, a[0].value);
+
+	a.RemoveLast();
+
+	EXPECT_EQ(0, Counted::liveCount);
+	EXPECT_TRUE(a.IsEmpty());
+}
+
+TEST(TArrayTests, CopyNonTrivial)
+{
+	TArray<std::string> a;
+
+	a.Append("a string long enough to not fit in the small string buffer");
+	a.Append(std::string("another"));
+
+	TArray<std::string> b(a);
+
+	EXPECT_EQ(2u, b.Length());
+	EXPECT_EQ(a[0], b[0]);
+	EXPECT_NE(a[0].data(), b[0].data());
+	EXPECT_EQ("another", b[1]);
+}
+
+TEST(TArrayTests, EmplaceBackReturnsElement)
+{
+	TArray<std::string> a;
+	std::string& s = a.EmplaceBack(3, 'x');
+
+	EXPECT_EQ("xxx", s);
+	EXPECT_EQ(&a[0], &s);
+}
+
+TEST(TArrayTests, AppendOwnElementWhileGrowing)
+{
+	TArray<std::string> a;
+
+	a.Append("first element that lives on the heap");
+
+	for (uint32 i = 0; i < 20; ++i)
+		a.Append(a[0]);
+
+	EXPECT_EQ(21u, a.Length());
+	EXPECT_EQ(a[0], a[20]);
+}
+
+TEST(TArrayTests, AppendRange)
+{
+	uint32 n[] = { 1, 2, 3, 4, 5 };
+	TArray<uint32> a;
+
+	a.Append(0);
+	a.AppendRange(n, 5);
+	a.AppendRange(nullptr, 0);
+
+	EXPECT_EQ(6u, a.Length());
+
+	for (uint32 i = 0; i < 6; ++i)
+		EXPECT_EQ(i, a[i]);
+}
+
+TEST(TArrayTests, ArrayOfArrays)
+{
+	TArray<TArray<uint32>> a;
+
+	for (uint32 i = 0; i < 50; ++i)
+	{
+		TArray<uint32>& inner = a.EmplaceBack();
+		inner.Append(i);
+	}
+
+	for (uint32 i = 0; i < 50; ++i)
+		EXPECT_EQ(i, a[i][0]);
+}
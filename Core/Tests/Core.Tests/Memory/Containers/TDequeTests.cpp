@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "Core/Memory/Containers/TDeque.h"
+#include "Core/Memory/HeapAllocator.h"
+
+using namespace ducklib;
+
+TEST(TDequeTests, GrowsAtBothEnds)
+{
+	TDeque<uint32> a;
+
+	for (uint32 i = 0; i < 100; ++i)
+	{
+		a.PushBack(100 + i);
+		a.PushFront(99 - i);
+	}
+
+	EXPECT_EQ(200u, a.Length());
+	EXPECT_EQ(256u, a.Capacity());
+
+	for (uint32 i = 0; i < 200; ++i)
+		EXPECT_EQ(i, a[i]);
+}
+
+TEST(TDequeTests, GrowWhileWrapped)
+{
+	TDeque<std::string> a(4);
+	std::string item;
+
+	a.PushBack("1");
+	a.PushBack("2");
+	a.TryPopFront(&item);
+	a.PushBack("3");
+	a.PushBack("4");
+	a.PushBack("5");
+	a.PushBack("6");
+
+	EXPECT_EQ(5u, a.Length());
+
+	for (uint32 i = 0; i < 5; ++i)
+		EXPECT_EQ(std::to_string(i + 2), a[i]);
+}
+
+TEST(TDequeTests, EmplaceOwnElementWhileGrowing)
+{
+	TDeque<std::string> a;
+
+	a.PushBack("first element that lives on the heap");
+
+	for (uint32 i = 0; i < 20; ++i)
+		a.EmplaceFront(a.Back());
+
+	EXPECT_EQ(21u, a.Length());
+	EXPECT_EQ(a.Back(), a.Front());
+}
+
+TEST(TDequeTests, AppendRangeReservesOnce)
+{
+	HeapAllocator heap;
+	uint32 items[100];
+
+	for (uint32 i = 0; i < 100; ++i)
+		items[i] = i;
+
+	{
+		TDeque<uint32> a(&heap);
+
+		a.AppendRange(items, 100);
+
+		EXPECT_EQ(1u, heap.GetStats().allocationCount);
+		EXPECT_EQ(100u, a.Length());
+		EXPECT_EQ(99u, a.Back());
+	}
+
+	EXPECT_EQ(0u, heap.GetStats().allocationCount);
+}
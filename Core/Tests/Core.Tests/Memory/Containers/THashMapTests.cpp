@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "Core/Memory/Containers/THashMap.h"
+#include "Core/Memory/HeapAllocator.h"
+
+using namespace ducklib;
+
+namespace
+{
+struct StringHash
+{
+	using is_transparent = void;
+
+	size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+};
+}
+
+TEST(THashMapTests, InsertAndFind)
+{
+	THashMap<uint32, uint32> map;
+
+	EXPECT_TRUE(map.Insert(1, 10));
+	EXPECT_TRUE(map.Insert(2, 20));
+	EXPECT_FALSE(map.Insert(1, 11));
+
+	EXPECT_EQ(2u, map.Length());
+	ASSERT_NE(nullptr, map.Find(1));
+	EXPECT_EQ(11u, *map.Find(1));
+	EXPECT_EQ(20u, *map.Find(2));
+	EXPECT_EQ(nullptr, map.Find(3));
+	EXPECT_FALSE(map.Contains(3));
+}
+
+TEST(THashMapTests, EmptyMap)
+{
+	THashMap<uint32, uint32> map;
+
+	EXPECT_TRUE(map.IsEmpty());
+	EXPECT_EQ(0u, map.Capacity());
+	EXPECT_EQ(nullptr, map.Find(0));
+	EXPECT_FALSE(map.Remove(0));
+	EXPECT_TRUE(map.begin() == map.end());
+}
+
+TEST(THashMapTests, ManyInsertsAndRemoves)
+{
+	THashMap<uint64, uint64> map;
+	constexpr uint64 count = 100000;
+
+	for (uint64 i = 0; i < count; ++i)
+		map[i * 4096] = i;
+
+	EXPECT_EQ(count, map.Length());
+
+	for (uint64 i = 0; i < count; i += 2)
+		EXPECT_TRUE(map.Remove(i * 4096));
+
+	EXPECT_EQ(count / 2, map.Length());
+
+	for (uint64 i = 0; i < count; ++i)
+	{
+		const uint64* value = map.Find(i * 4096);
+
+		if (i % 2 == 0)
+			EXPECT_EQ(nullptr, value);
+		else
+		{
+			ASSERT_NE(nullptr, value);
+			EXPECT_EQ(i, *value);
+		}
+	}
+}
+
+TEST(THashMapTests, ChurnMatchesUnorderedMap)
+{
+	THashMap<uint32, uint32> map;
+	std::unordered_map<uint32, uint32> reference;
+	uint32 random = 1;
+
+	// Keeping the size small while churning leaves lots of tombstones to clean up
+	for (uint32 i = 0; i < 200000; ++i)
+	{
+		random = random * 1664525u + 1013904223u;
+		uint32 key = (random >> 8) % 500;
+
+		if (random & 1)
+		{
+			map.Insert(key, i);
+			reference[key] = i;
+		}
+		else
+			EXPECT_EQ(reference.erase(key) == 1, map.Remove(key));
+	}
+
+	EXPECT_EQ(reference.size(), map.Length());
+	EXPECT_GE(1024u, map.Capacity());
+
+	for (const auto& [key, value] : reference)
+	{
+		ASSERT_NE(nullptr, map.Find(key));
+		EXPECT_EQ(value, *map.Find(key));
+	}
+}
+
+TEST(THashMapTests, Iterate)
+{
+	THashMap<uint32, uint32> map;
+	uint32 keySum = 0;
+	uint32 count = 0;
+
+	for (uint32 i = 1; i <= 100; ++i)
+		map.Insert(i, i * 2);
+
+	for (auto& [key, value] : map)
+	{
+		EXPECT_EQ(key * 2, value);
+		keySum += key;
+		++count;
+	}
+
+	EXPECT_EQ(100u, count);
+	EXPECT_EQ(5050u, keySum);
+}
+
+TEST(THashMapTests, NonTrivialEntries)
+{
+	THashMap<std::string, std::string> map;
+
+	for (uint32 i = 0; i < 1000; ++i)
+		map.Insert("a key long enough to be allocated " + std::to_string(i), std::to_string(i));
+
+	EXPECT_EQ("500", *map.Find("a key long enough to be allocated 500"));
+	EXPECT_TRUE(map.Remove("a key long enough to be allocated 500"));
+	EXPECT_FALSE(map.Contains("a key long enough to be allocated 500"));
+
+	THashMap<std::string, std::string> copy(map);
+
+	EXPECT_EQ(999u, copy.Length());
+	EXPECT_EQ("999", *copy.Find("a key long enough to be allocated 999"));
+
+	map.Clear();
+
+	EXPECT_TRUE(map.IsEmpty());
+	EXPECT_EQ(999u, copy.Length());
+}
+
+TEST(THashMapTests, HeterogeneousLookup)
+{
+	THashMap<std::string, uint32, StringHash, std::equal_to<>> map;
+	std::string_view key = "key";
+
+	map.Insert("key", 1);
+
+	ASSERT_NE(nullptr, map.Find(key));
+	EXPECT_EQ(1u, *map.Find(key));
+	EXPECT_TRUE(map.Contains("key"));
+	EXPECT_TRUE(map.Remove(key));
+}
+
+TEST(THashMapTests, ReserveAndRehash)
+{
+	HeapAllocator heap;
+
+	{
+		THashMap<uint32, uint32> map(&heap);
+
+		map.Reserve(1000);
+
+		uint32 capacity = map.Capacity();
+
+		EXPECT_LE(1000u, capacity);
+
+		for (uint32 i = 0; i < 1000; ++i)
+			map.Insert(i, i);
+
+		EXPECT_EQ(capacity, map.Capacity());
+		EXPECT_EQ(1u, heap.GetStats().allocationCount);
+
+		for (uint32 i = 0; i < 990; ++i)
+			map.Remove(i);
+
+		map.Rehash(0);
+
+		EXPECT_GT(capacity, map.Capacity());
+		EXPECT_LE(10u, map.Capacity());
+		EXPECT_EQ(995u, *map.Find(995));
+	}
+
+	EXPECT_EQ(0u, heap.GetStats().allocationCount);
+}
+
+TEST(THashMapTests, MoveAndAssign)
+{
+	THashMap<uint32, uint32> a;
+
+	a.Insert(1, 2);
+
+	THashMap<uint32, uint32> b(std::move(a));
+
+	EXPECT_EQ(0u, a.Length());
+	EXPECT_EQ(2u, *b.Find(1));
+
+	a = b;
+	b.Insert(3, 4);
+
+	EXPECT_EQ(1u, a.Length());
+	EXPECT_EQ(2u, *a.Find(1));
+	EXPECT_FALSE(a.Contains(3));
+}
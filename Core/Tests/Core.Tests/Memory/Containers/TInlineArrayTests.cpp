@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "Core/Memory/Containers/TInlineArray.h"
+#include "Core/Memory/HeapAllocator.h"
+
+using namespace ducklib;
+
+TEST(TInlineArrayTests, StaysInlineUpToCapacity)
+{
+	HeapAllocator heap;
+	TInlineArray<uint32, 8> a(&heap);
+
+	for (uint32 i = 0; i < 8; ++i)
+		a.Append(i);
+
+	EXPECT_TRUE(a.IsInline());
+	EXPECT_EQ(8u, a.Length());
+	EXPECT_EQ(8u, a.Capacity());
+	EXPECT_EQ(0u, heap.GetStats().allocationCount);
+
+	for (uint32 i = 0; i < 8; ++i)
+		EXPECT_EQ(i, a[i]);
+}
+
+TEST(TInlineArrayTests, SpillsToAllocator)
+{
+	HeapAllocator heap;
+
+	{
+		TInlineArray<uint32, 4> a(&heap);
+
+		for (uint32 i = 0; i < 100; ++i)
+			a.Append(i);
+
+		EXPECT_FALSE(a.IsInline());
+		EXPECT_EQ(1u, heap.GetStats().allocationCount);
+
+		for (uint32 i = 0; i < 100; ++i)
+			EXPECT_EQ(i, a[i]);
+	}
+
+	EXPECT_EQ(0u, heap.GetStats().allocationCount);
+}
+
+TEST(TInlineArrayTests, ConstructFromPointer)
+{
+	uint32 values[] = { 1, 2, 3 };
+	TInlineArray<uint32, 4> a(values, 3);
+	TInlineArray<uint32, 2> b(values, 3);
+
+	EXPECT_TRUE(a.IsInline());
+	EXPECT_FALSE(b.IsInline());
+	EXPECT_EQ(3u, a[2]);
+	EXPECT_EQ(3u, b[2]);
+}
+
+TEST(TInlineArrayTests, MoveInline)
+{
+	TInlineArray<uint32, 4> a;
+
+	a.Append(5);
+	a.Append(6);
+
+	TInlineArray<uint32, 4> b(std::move(a));
+
+	EXPECT_TRUE(b.IsInline());
+	EXPECT_EQ(2u, b.Length());
+	EXPECT_EQ(6u, b[1]);
+	EXPECT_EQ(0u, a.Length());
+	EXPECT_NE(a.Data(), b.Data());
+}
+
+TEST(TInlineArrayTests, MoveSpilled)
+{
+	TInlineArray<uint32, 2> a;
+
+	for (uint32 i = 0; i < 10; ++i)
+		a.Append(i);
+
+	uint32* data = a.Data();
+	TInlineArray<uint32, 2> b(std::move(a));
+
+	EXPECT_EQ(data, b.Data());
+	EXPECT_EQ(10u, b.Length());
+	EXPECT_TRUE(a.IsInline());
+	EXPECT_EQ(0u, a.Length());
+
+	a.Append(1);
+
+	EXPECT_EQ(1u, a[0]);
+}
+
+TEST(TInlineArrayTests, MoveIntoTArray)
+{
+	TInlineArray<uint32, 4> a;
+
+	a.Append(3);
+
+	TArray<uint32> b(std::move(a));
+
+	EXPECT_EQ(1u, b.Length());
+	EXPECT_EQ(3u, b[0]);
+	EXPECT_NE(a.Data(), b.Data());
+}
+
+TEST(TInlineArrayTests, MoveIntoTArrayWithoutAllocator)
+{
+	TInlineArray<uint32, 4> a(nullptr);
+
+	a.Append(3);
+
+	EXPECT_THROW(TArray<uint32>(std::move(a)), std::runtime_error);
+	// Nothing was moved out
+	ASSERT_EQ(1u, a.Length());
+	EXPECT_EQ(3u, a[0]);
+}
+
+TEST(TInlineArrayTests, Copy)
+{
+	TInlineArray<uint32, 2> a;
+
+	for (uint32 i = 0; i < 5; ++i)
+		a.Append(i);
+
+	TInlineArray<uint32, 2> b(a);
+
+	EXPECT_EQ(5u, b.Length());
+	EXPECT_NE(a.Data(), b.Data());
+	EXPECT_EQ(4u, b[4]);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <span>
+#include <string>
+#include "Core/Memory/Containers/TRingBuffer.h"
+
+using namespace ducklib;
+
+TEST(TRingBufferTests, CapacityRoundedToPowerOfTwo)
+{
+	TRingBuffer<uint32> a(5);
+
+	EXPECT_EQ(8u, a.Capacity());
+	EXPECT_TRUE(a.IsEmpty());
+}
+
+TEST(TRingBufferTests, PushAndPopBothEnds)
+{
+	TRingBuffer<uint32> a(4);
+	uint32 item;
+
+	EXPECT_TRUE(a.TryPushBack(2));
+	EXPECT_TRUE(a.TryPushBack(3));
+	EXPECT_TRUE(a.TryPushFront(1));
+	EXPECT_TRUE(a.TryPushFront(0));
+	EXPECT_TRUE(a.IsFull());
+	EXPECT_FALSE(a.TryPushBack(4));
+	EXPECT_FALSE(a.TryPushFront(4));
+
+	for (uint32 i = 0; i < 4; ++i)
+		EXPECT_EQ(i, a[i]);
+
+	EXPECT_TRUE(a.TryPopBack(&item));
+	EXPECT_EQ(3u, item);
+	EXPECT_TRUE(a.TryPopFront(&item));
+	EXPECT_EQ(0u, item);
+	EXPECT_EQ(1u, a.Front());
+	EXPECT_EQ(2u, a.Back());
+	EXPECT_EQ(2u, a.Length());
+}
+
+TEST(TRingBufferTests, WrapsAround)
+{
+	TRingBuffer<uint32> a(4);
+	uint32 item;
+
+	for (uint32 i = 0; i < 100; ++i)
+	{
+		EXPECT_TRUE(a.TryPushBack(i));
+
+		if (a.Length() == 3)
+		{
+			EXPECT_TRUE(a.TryPopFront(&item));
+			EXPECT_EQ(i - 2, item);
+		}
+	}
+
+	EXPECT_EQ(2u, a.Length());
+	EXPECT_EQ(98u, a.Front());
+}
+
+TEST(TRingBufferTests, SpansOfWrappedRange)
+{
+	TRingBuffer<uint32> a(8);
+	uint32 items[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+	uint32 popped[8];
+	std::span<uint32> first;
+	std::span<uint32> second;
+
+	EXPECT_EQ(6u, a.PushBackRange(items, 6));
+	EXPECT_EQ(5u, a.PopFrontRange(popped, 5));
+	EXPECT_EQ(4u, popped[4]);
+
+	// 5 at the end of the buffer, then 0-6 from the start
+	EXPECT_EQ(7u, a.PushBackRange(items, 8));
+
+	a.GetSpans(first, second);
+
+	ASSERT_EQ(3u, first.size());
+	ASSERT_EQ(5u, second.size());
+	EXPECT_EQ(5u, first[0]);
+	EXPECT_EQ(0u, first[1]);
+	EXPECT_EQ(1u, first[2]);
+	EXPECT_EQ(6u, second[4]);
+
+	EXPECT_EQ(8u, a.PopFrontRange(popped, 8));
+	EXPECT_EQ(5u, popped[0]);
+	EXPECT_EQ(6u, popped[7]);
+	EXPECT_TRUE(a.IsEmpty());
+}
+
+TEST(TRingBufferTests, NonTrivialItems)
+{
+	TRingBuffer<std::string> a(4);
+	std::string item;
+
+	a.TryPushBack("a string long enough to be allocated");
+	a.TryPushFront("front");
+
+	TRingBuffer<std::string> b(a);
+
+	EXPECT_TRUE(b.TryPopFront(&item));
+	EXPECT_EQ("front", item);
+	EXPECT_EQ("a string long enough to be allocated", b.Front());
+	EXPECT_EQ(2u, a.Length());
+
+	TRingBuffer<std::string> c(std::move(a));
+
+	EXPECT_EQ(2u, c.Length());
+	EXPECT_EQ(0u, a.Length());
+}
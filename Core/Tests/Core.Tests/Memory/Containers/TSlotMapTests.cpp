@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "Core/Memory/Containers/TSlotMap.h"
+
+using namespace ducklib;
+
+namespace
+{
+struct NoDefault
+{
+	explicit NoDefault(uint32 value)
+		: value(value) {}
+
+	uint32 value;
+};
+}
+
+TEST(TSlotMapTests, InsertAndGet)
+{
+	TSlotMap<uint32> map;
+	SlotHandle a = map.Insert(10);
+	SlotHandle b = map.Insert(20);
+
+	EXPECT_EQ(2u, map.Length());
+	ASSERT_NE(nullptr, map.Get(a));
+	EXPECT_EQ(10u, *map.Get(a));
+	EXPECT_EQ(20u, *map.Get(b));
+	EXPECT_FALSE(map.Contains(SlotHandle{}));
+}
+
+TEST(TSlotMapTests, StaleHandleAfterRemove)
+{
+	TSlotMap<uint32> map;
+	SlotHandle a = map.Insert(10);
+
+	EXPECT_TRUE(map.Remove(a));
+	EXPECT_FALSE(map.Remove(a));
+	EXPECT_EQ(nullptr, map.Get(a));
+
+	// Reuses the slot with a new generation
+	SlotHandle b = map.Insert(20);
+
+	EXPECT_EQ(a.index, b.index);
+	EXPECT_NE(a.generation, b.generation);
+	EXPECT_EQ(nullptr, map.Get(a));
+	EXPECT_EQ(20u, *map.Get(b));
+}
+
+TEST(TSlotMapTests, RemoveKeepsStorageDense)
+{
+	TSlotMap<uint32> map;
+	SlotHandle handles[100];
+
+	for (uint32 i = 0; i < 100; ++i)
+		handles[i] = map.Insert(i);
+
+	for (uint32 i = 0; i < 100; i += 2)
+		EXPECT_TRUE(map.Remove(handles[i]));
+
+	EXPECT_EQ(50u, map.Length());
+
+	uint32 sum = 0;
+
+	for (uint32 value : map)
+		sum += value;
+
+	EXPECT_EQ(2500u, sum);
+
+	for (uint32 i = 0; i < 100; ++i)
+	{
+		if (i % 2 == 0)
+			EXPECT_FALSE(map.Contains(handles[i]));
+		else
+			EXPECT_EQ(i, *map.Get(handles[i]));
+	}
+
+	for (uint32 i = 0; i < map.Length(); ++i)
+		EXPECT_EQ(map.Data()[i], *map.Get(map.HandleAt(i)));
+}
+
+TEST(TSlotMapTests, TypeIsChecked)
+{
+	TSlotMap<uint32> textures(1);
+	TSlotMap<uint32> buffers(2);
+	SlotHandle texture = textures.Insert(1);
+	SlotHandle buffer = buffers.Insert(2);
+
+	EXPECT_EQ(1u, texture.type);
+	EXPECT_EQ(texture.index, buffer.index);
+	EXPECT_EQ(nullptr, textures.Get(buffer));
+	EXPECT_EQ(nullptr, buffers.Get(texture));
+	EXPECT_ANY_THROW(TSlotMap<uint32>(TSlotMap<uint32>::MAX_TYPE + 1));
+}
+
+TEST(TSlotMapTests, NonTrivialValues)
+{
+	TSlotMap<std::string> map;
+	SlotHandle a = map.Emplace(40, 'a');
+	SlotHandle b = map.Insert("b");
+
+	map.Remove(a);
+
+	EXPECT_EQ("b", *map.Get(b));
+
+	map.Clear();
+
+	EXPECT_TRUE(map.IsEmpty());
+	EXPECT_FALSE(map.Contains(b));
+}
+
+TEST(TSlotMapTests, NonDefaultConstructibleValues)
+{
+	TSlotMap<NoDefault> map;
+	SlotHandle a = map.Emplace(1u);
+	SlotHandle b = map.Insert(NoDefault(2));
+
+	EXPECT_TRUE(map.Remove(a));
+	ASSERT_NE(nullptr, map.Get(b));
+	EXPECT_EQ(2u, map.Get(b)->value);
+
+	map.Clear();
+
+	EXPECT_TRUE(map.IsEmpty());
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "Core/Memory/Containers/TSoAArray.h"
+#include "Core/Memory/HeapAllocator.h"
+
+using namespace ducklib;
+
+TEST(TSoAArrayTests, AppendAndGet)
+{
+	TSoAArray<uint64, uint32, uint8> a;
+
+	for (uint32 i = 0; i < 100; ++i)
+		a.Append((uint64)i * 1000, i, (uint8)i);
+
+	EXPECT_EQ(100u, a.Length());
+	EXPECT_LE(100u, a.Capacity());
+
+	for (uint32 i = 0; i < 100; ++i)
+	{
+		EXPECT_EQ((uint64)i * 1000, a.Get<0>(i));
+		EXPECT_EQ(i, a.Get<1>(i));
+		EXPECT_EQ((uint8)i, a.Get<2>(i));
+	}
+}
+
+TEST(TSoAArrayTests, ColumnsAreAlignedInOneAllocation)
+{
+	HeapAllocator heap;
+
+	{
+		TSoAArray<uint8, uint64, uint16> a(&heap);
+
+		for (uint32 i = 0; i < 1000; ++i)
+			a.Append((uint8)i, (uint64)i, (uint16)i);
+
+		EXPECT_EQ(1u, heap.GetStats().allocationCount);
+		EXPECT_EQ(0u, (uintptr_t)a.Data<0>() % TSoAArray<uint8>::COLUMN_ALIGN);
+		EXPECT_EQ(0u, (uintptr_t)a.Data<1>() % TSoAArray<uint8>::COLUMN_ALIGN);
+		EXPECT_EQ(0u, (uintptr_t)a.Data<2>() % TSoAArray<uint8>::COLUMN_ALIGN);
+	}
+
+	EXPECT_EQ(0u, heap.GetStats().allocationCount);
+}
+
+TEST(TSoAArrayTests, ColumnSpan)
+{
+	TSoAArray<uint32, float> a;
+	uint64 sum = 0;
+
+	for (uint32 i = 0; i < 10; ++i)
+		a.Append(i, 0.5f);
+
+	for (uint32 value : a.Column<0>())
+		sum += value;
+
+	EXPECT_EQ(10u, a.Column<1>().size());
+	EXPECT_EQ(45u, sum);
+}
+
+TEST(TSoAArrayTests, ZippedRows)
+{
+	TSoAArray<uint32, uint32> a;
+
+	for (uint32 i = 0; i < 10; ++i)
+		a.Append(i, 0u);
+
+	for (auto [value, doubled] : a)
+		doubled = value * 2;
+
+	const TSoAArray<uint32, uint32>& constA = a;
+	uint32 count = 0;
+
+	for (auto [value, doubled] : constA)
+	{
+		EXPECT_EQ(value * 2, doubled);
+		++count;
+	}
+
+	EXPECT_EQ(10u, count);
+	EXPECT_EQ(18u, std::get<1>(a[9]));
+}
+
+TEST(TSoAArrayTests, RemoveAtSwap)
+{
+	TSoAArray<uint32, std::string> a;
+
+	a.Append(0u, "zero");
+	a.Append(1u, "one");
+	a.Append(2u, "two");
+
+	a.RemoveAtSwap(0);
+
+	EXPECT_EQ(2u, a.Length());
+	EXPECT_EQ(2u, a.Get<0>(0));
+	EXPECT_EQ("two", a.Get<1>(0));
+
+	a.RemoveAtSwap(1);
+
+	EXPECT_EQ(1u, a.Length());
+	EXPECT_EQ("two", a.Get<1>(0));
+}
+
+TEST(TSoAArrayTests, NonTrivialColumnsGrowAndCopy)
+{
+	TSoAArray<std::string, uint32> a;
+
+	for (uint32 i = 0; i < 100; ++i)
+		a.Append("a string long enough to be allocated " + std::to_string(i), i);
+
+	TSoAArray<std::string, uint32> b(a);
+	TSoAArray<std::string, uint32> c(std::move(a));
+
+	EXPECT_EQ(0u, a.Length());
+	EXPECT_EQ(100u, b.Length());
+	EXPECT_EQ(100u, c.Length());
+	EXPECT_EQ("a string long enough to be allocated 99", b.Get<0>(99));
+	EXPECT_EQ(b.Get<0>(50), c.Get<0>(50));
+
+	c.Resize(10);
+
+	EXPECT_EQ(10u, c.Length());
+	EXPECT_EQ(9u, c.Get<1>(9));
+}
+
+TEST(TSoAArrayTests, AppendOwnRowWhileGrowing)
+{
+	TSoAArray<std::string> a;
+
+	a.Append("first row that lives on the heap");
+
+	for (uint32 i = 0; i < 20; ++i)
+		a.Append(a.Get<0>(0));
+
+	EXPECT_EQ(a.Get<0>(0), a.Get<0>(20));
+}
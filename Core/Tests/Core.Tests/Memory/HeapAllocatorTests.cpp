@@ -14,11 +14,10 @@ TEST(HeapAllocatorTest, AllocCheckBlockValues)
 	constexpr uint8_t HEAP_GUARD_BYTES_VALUE = 0xfd;
 	uint8_t* ptr = (uint8_t*)malloc.Allocate(ALLOC_SIZE);
 
-	// TODO: Find a better way to either handle aligns' extra memory allocation or testing it
-	for (uint32 i = 0; i < ALLOC_SIZE + 4; ++i)
+	for (uint32 i = 0; i < ALLOC_SIZE; ++i)
 		EXPECT_EQ(UNINITIALIZED_HEAP_VALUE, ptr[i]);
 
-	EXPECT_EQ(HEAP_GUARD_BYTES_VALUE, ptr[ALLOC_SIZE + 4]);
+	EXPECT_EQ(HEAP_GUARD_BYTES_VALUE, ptr[ALLOC_SIZE]);
 }
 #endif
 
@@ -27,8 +26,61 @@ TEST(HeapAllocatorTest, AllocAndCheckHeader)
 	HeapAllocator malloc;
 	void* ptr = malloc.Allocate(16);
 	Internal::Memory::Header* header = Internal::Memory::GetHeader(ptr);
-	uint64 expectedAllocSize = 16 + sizeof(Internal::Memory::Header) + IAllocator::DEFAULT_ALIGN;
+	uint64 expectedAllocSize = 16 + sizeof(Internal::Memory::Header);
 
-	EXPECT_EQ(expectedAllocSize, header->totalSize);
+	EXPECT_EQ((char*)ptr - sizeof(Internal::Memory::Header), (char*)header);
+	EXPECT_EQ(16u, header->size);
 	EXPECT_EQ(IAllocator::DEFAULT_ALIGN, header->align);
+	EXPECT_EQ(expectedAllocSize, Internal::Memory::SizeWithHeaderAndAlignment(16, IAllocator::DEFAULT_ALIGN));
+
+	malloc.Free(ptr);
+}
+
+TEST(HeapAllocatorTest, AllocLargeAlignments)
+{
+	HeapAllocator malloc;
+	constexpr uint32 PAGE_ALIGN = 4096;
+	constexpr uint32 HUGE_PAGE_ALIGN = 2 * 1024 * 1024;
+	void* pagePtr = malloc.Allocate(100, PAGE_ALIGN);
+	void* hugePagePtr = malloc.Allocate(100, HUGE_PAGE_ALIGN);
+
+	EXPECT_EQ(0u, (uintptr_t)pagePtr % PAGE_ALIGN);
+	EXPECT_EQ(0u, (uintptr_t)hugePagePtr % HUGE_PAGE_ALIGN);
+	EXPECT_EQ(HUGE_PAGE_ALIGN, Internal::Memory::GetHeader(hugePagePtr)->align);
+
+	malloc.Free(pagePtr);
+	malloc.Free(hugePagePtr);
+}
+
+TEST(HeapAllocatorTest, FreeDataEndingInPadValue)
+{
+	HeapAllocator malloc;
+	uint8_t* ptr = (uint8_t*)malloc.Allocate(8, 64);
+
+	memset(ptr, 0xff, 8);
+
+	EXPECT_EQ(8u, Internal::Memory::GetHeader(ptr)->size);
+
+	malloc.Free(ptr);
+}
+
+TEST(HeapAllocatorTest, ReallocateKeepsAlignmentAndData)
+{
+	HeapAllocator malloc;
+	uint32* ptr = (uint32*)malloc.Allocate(16 * sizeof(uint32), 256);
+
+	for (uint32 i = 0; i < 16; ++i)
+		ptr[i] = i;
+
+	for (uint32 size = 32; size <= 4096; size *= 2)
+	{
+		ptr = (uint32*)malloc.Reallocate(ptr, size * sizeof(uint32));
+
+		EXPECT_EQ(0u, (uintptr_t)ptr % 256);
+
+		for (uint32 i = 0; i < 16; ++i)
+			EXPECT_EQ(i, ptr[i]);
+	}
+
+	malloc.Free(ptr);
 }
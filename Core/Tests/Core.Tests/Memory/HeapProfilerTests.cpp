@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "Core/Memory/HeapAllocator.h"
+#include "Core/Memory/HeapProfiler.h"
+#include "Core/Memory/MemoryTags.h"
+
+using namespace ducklib;
+
+namespace
+{
+void* FakePtr(uint32 i)
+{
+	return (void*)(uintptr_t)(0x10000 + i * 64);
+}
+
+HeapProfileSite SumSites(HeapProfiler& profiler)
+{
+	HeapProfileSite sum = {};
+	const HeapProfileSite* sites = profiler.GetSites();
+
+	for (uint32 i = 0; i < profiler.GetSiteCount(); ++i)
+	{
+		sum.allocCount += sites[i].allocCount;
+		sum.allocSize += sites[i].allocSize;
+		sum.inUseCount += sites[i].inUseCount;
+		sum.inUseSize += sites[i].inUseSize;
+		sum.estimatedAllocSize += sites[i].estimatedAllocSize;
+		sum.estimatedInUseSize += sites[i].estimatedInUseSize;
+	}
+
+	return sum;
+}
+
+FILE* OpenForReading(const char* path)
+{
+#ifdef _WIN32
+	FILE* file;
+
+	return fopen_s(&file, path, "r") == 0 ? file : nullptr;
+#else
+	return fopen(path, "r");
+#endif
+}
+}
+
+TEST(HeapProfilerTest, NotRunningRecordsNothing)
+{
+	HeapProfiler profiler;
+
+	profiler.RecordAllocation(FakePtr(0), 1024);
+
+	EXPECT_EQ(0u, profiler.GetSiteCount());
+}
+
+TEST(HeapProfilerTest, SmallIntervalSamplesEverything)
+{
+	HeapProfiler profiler;
+	constexpr uint32 count = 100;
+
+	profiler.Start(1);
+
+	for (uint32 i = 0; i < count; ++i)
+		profiler.RecordAllocation(FakePtr(i), 64);
+
+	HeapProfileSite sum = SumSites(profiler);
+
+	EXPECT_LE(1u, profiler.GetSiteCount());
+	EXPECT_EQ(count, sum.allocCount);
+	EXPECT_EQ(count * 64u, sum.allocSize);
+	EXPECT_EQ(count, sum.inUseCount);
+
+	for (uint32 i = 0; i < count; i += 2)
+		profiler.RecordFree(FakePtr(i));
+
+	sum = SumSites(profiler);
+
+	EXPECT_EQ(count, sum.allocCount);
+	EXPECT_EQ(count / 2, sum.inUseCount);
+	EXPECT_EQ(count / 2 * 64u, sum.inUseSize);
+
+	// Not sampled
+	profiler.RecordFree(FakePtr(count));
+
+	EXPECT_EQ(count / 2, SumSites(profiler).inUseCount);
+}
+
+TEST(HeapProfilerTest, EstimateCloseToAllocatedSize)
+{
+	HeapProfiler profiler;
+	constexpr uint32 count = 20000;
+	constexpr uint64 size = 64;
+
+	profiler.Start(4096);
+
+	for (uint32 i = 0; i < count; ++i)
+		profiler.RecordAllocation(FakePtr(i), size);
+
+	HeapProfileSite sum = SumSites(profiler);
+	double allocatedSize = (double)(count * size);
+
+	EXPECT_LT(sum.allocCount, count / 10);
+	EXPECT_NEAR(allocatedSize, sum.estimatedAllocSize, allocatedSize * 0.4);
+}
+
+TEST(HeapProfilerTest, ResetClearsSamples)
+{
+	HeapProfiler profiler;
+
+	profiler.Start(1);
+	profiler.RecordAllocation(FakePtr(0), 64);
+	profiler.Reset();
+
+	EXPECT_EQ(0u, profiler.GetSiteCount());
+
+	profiler.RecordFree(FakePtr(0));
+
+	EXPECT_EQ(0u, profiler.GetSiteCount());
+}
+
+TEST(HeapProfilerTest, AllocatorsReportToProfiler)
+{
+	HeapProfiler& profiler = GetHeapProfiler();
+	HeapAllocator alloc;
+
+	profiler.Reset();
+	profiler.Start(1);
+	void* ptr = alloc.Allocate(256);
+	profiler.Stop();
+
+	EXPECT_EQ(1u, SumSites(profiler).inUseCount);
+
+	alloc.Free(ptr);
+
+	EXPECT_EQ(0u, SumSites(profiler).inUseCount);
+	EXPECT_EQ(256u, SumSites(profiler).allocSize);
+
+	profiler.Reset();
+}
+
+TEST(HeapProfilerTest, NestedAllocatorsRecordOnce)
+{
+	HeapProfiler& profiler = GetHeapProfiler();
+	// Large enough for the thread cache to pass it on to its backing allocator
+	constexpr uint64 size = 100000;
+	IAllocator* allocators[] = { DefAlloc(), TagAlloc(MemoryTag::CORE) };
+
+	for (IAllocator* alloc : allocators)
+	{
+		profiler.Reset();
+		profiler.Start(1);
+		void* ptr = alloc->Allocate(size);
+		profiler.Stop();
+
+		HeapProfileSite sum = SumSites(profiler);
+
+		EXPECT_EQ(1u, sum.allocCount);
+		EXPECT_EQ(size, sum.allocSize);
+		EXPECT_EQ(1u, sum.inUseCount);
+
+		alloc->Free(ptr);
+
+		EXPECT_EQ(0u, SumSites(profiler).inUseCount);
+	}
+
+	profiler.Reset();
+}
+
+TEST(HeapProfilerTest, WriteProfiles)
+{
+	HeapProfiler profiler;
+	const char* path = "HeapProfilerTest.prof";
+	char line[256] = {};
+
+	profiler.Start(1);
+	profiler.RecordAllocation(FakePtr(0), 64);
+
+	ASSERT_TRUE(profiler.WritePprof(path));
+
+	FILE* file = OpenForReading(path);
+	ASSERT_NE(nullptr, file);
+	fgets(line, sizeof(line), file);
+	fclose(file);
+
+	EXPECT_STREQ("heap profile: 1: 64 [1: 64] @ heap_v2/1\n", line);
+
+	ASSERT_TRUE(profiler.WriteCollapsedStacks(path, HeapProfileView::ALLOCATED));
+
+	file = OpenForReading(path);
+	ASSERT_NE(nullptr, file);
+	ASSERT_NE(nullptr, fgets(line, sizeof(line), file));
+	fclose(file);
+
+	EXPECT_NE(nullptr, strstr(line, " 64\n"));
+
+	remove(path);
+}
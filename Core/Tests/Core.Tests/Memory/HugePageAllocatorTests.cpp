@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "Core/Memory/HugePageAllocator.h"
+#include "Core/Memory/HeapAllocator.h"
+
+using namespace ducklib;
+
+namespace
+{
+constexpr uint64 THRESHOLD = 64 * 1024;
+}
+
+TEST(HugePageAllocatorTest, SmallAllocationsUseBackingAllocator)
+{
+	HeapAllocator heap;
+	HugePageAllocator alloc(THRESHOLD, false, &heap);
+
+	void* ptr = alloc.Allocate(128, 64);
+
+	EXPECT_EQ(0u, (uintptr_t)ptr % 64);
+	EXPECT_EQ(1u, heap.GetStats().allocationCount);
+	EXPECT_EQ(0u, alloc.GetHugePageStats().largeAllocationCount);
+
+	alloc.Free(ptr);
+
+	EXPECT_EQ(0u, heap.GetStats().allocationCount);
+	EXPECT_EQ(0u, alloc.GetStats().allocationCount);
+}
+
+TEST(HugePageAllocatorTest, SmallAllocationsKeepAlignment)
+{
+	HeapAllocator heap;
+	HugePageAllocator alloc(THRESHOLD, false, &heap);
+
+	// Alignments between the header alignment and the header size
+	for (uint32 align : { 16u, 32u })
+	{
+		void* ptr = alloc.Allocate(100, align);
+
+		EXPECT_EQ(0u, (uintptr_t)ptr % align);
+
+		ptr = alloc.Reallocate(ptr, 200);
+
+		EXPECT_EQ(0u, (uintptr_t)ptr % align);
+
+		alloc.Free(ptr);
+	}
+
+	EXPECT_EQ(0u, heap.GetStats().allocationCount);
+}
+
+TEST(HugePageAllocatorTest, LargeAllocationsAreMapped)
+{
+	HeapAllocator heap;
+	HugePageAllocator alloc(THRESHOLD, true, &heap);
+	constexpr uint64 size = 3 * 1024 * 1024;
+
+	char* ptr = (char*)alloc.Allocate(size, 4096);
+
+	ASSERT_NE(nullptr, ptr);
+	EXPECT_EQ(0u, (uintptr_t)ptr % 4096);
+	EXPECT_EQ(0u, heap.GetStats().allocationCount);
+
+	memset(ptr, 0xAB, size);
+
+	HugePageStats stats = alloc.GetHugePageStats();
+
+	EXPECT_EQ(1u, stats.largeAllocationCount);
+	EXPECT_EQ(0u, stats.mappedSize % HugePageAllocator::HUGE_PAGE_SIZE);
+	EXPECT_LE(size, stats.mappedSize);
+	EXPECT_LE(stats.explicitHugePageSize, stats.mappedSize);
+	EXPECT_LE(stats.transparentHugePageSize, stats.mappedSize);
+	EXPECT_LE(stats.numaBoundCount, 1u);
+	EXPECT_EQ(size, alloc.GetStats().allocatedSize);
+
+	alloc.Free(ptr);
+
+	EXPECT_EQ(0u, alloc.GetHugePageStats().largeAllocationCount);
+	EXPECT_EQ(0u, alloc.GetStats().totalAllocatedSize);
+}
+
+TEST(HugePageAllocatorTest, ReallocateWithinMappingKeepsPointer)
+{
+	HugePageAllocator alloc(THRESHOLD, false);
+
+	char* ptr = (char*)alloc.Allocate(THRESHOLD);
+	ptr[THRESHOLD - 1] = 42;
+
+	EXPECT_EQ(ptr, alloc.Reallocate(ptr, 2 * THRESHOLD));
+	EXPECT_EQ(42, ptr[THRESHOLD - 1]);
+
+	// Shrinking below the threshold stays in the mapping
+	EXPECT_EQ(ptr, alloc.Reallocate(ptr, 16));
+	EXPECT_EQ(1u, alloc.GetHugePageStats().largeAllocationCount);
+
+	alloc.Free(ptr);
+}
+
+TEST(HugePageAllocatorTest, ReallocateMovesBetweenSmallAndLarge)
+{
+	HugePageAllocator alloc(THRESHOLD, false);
+
+	uint32* ptr = (uint32*)alloc.Allocate(64 * sizeof(uint32), 64);
+
+	for (uint32 i = 0; i < 64; ++i)
+		ptr[i] = i;
+
+	ptr = (uint32*)alloc.Reallocate(ptr, 4 * 1024 * 1024);
+
+	EXPECT_EQ(1u, alloc.GetHugePageStats().largeAllocationCount);
+	EXPECT_EQ(0u, (uintptr_t)ptr % 64);
+
+	for (uint32 i = 0; i < 64; ++i)
+		EXPECT_EQ(i, ptr[i]);
+
+	ptr[1024 * 1024 - 1] = 7;
+	ptr = (uint32*)alloc.Reallocate(ptr, 8 * 1024 * 1024);
+
+	EXPECT_EQ(1u, alloc.GetHugePageStats().largeAllocationCount);
+	EXPECT_EQ(7u, ptr[1024 * 1024 - 1]);
+	EXPECT_EQ(63u, ptr[63]);
+	EXPECT_EQ(1u, alloc.GetStats().allocationCount);
+
+	alloc.Free(ptr);
+}
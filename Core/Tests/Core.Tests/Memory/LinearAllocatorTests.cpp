@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include "Core/Memory/LinearAllocator.h"
+#include "Core/Memory/Containers/TArray.h"
+
+using namespace ducklib;
+
+TEST(LinearAllocatorTest, AllocateSequential)
+{
+	LinearAllocator alloc(256);
+	uint32* a = alloc.Allocate<uint32>();
+	uint32* b = alloc.Allocate<uint32>();
+
+	EXPECT_EQ(a + 1, b);
+	EXPECT_EQ(8u, alloc.UsedSize());
+}
+
+TEST(LinearAllocatorTest, AllocateAligned)
+{
+	LinearAllocator alloc(256);
+
+	alloc.Allocate(1, 1);
+	void* ptr = alloc.Allocate(16, 64);
+
+	EXPECT_EQ(0u, (uintptr_t)ptr % 64);
+}
+
+TEST(LinearAllocatorTest, AllocateOutOfMemory)
+{
+	LinearAllocator alloc(64);
+
+	alloc.Allocate(60);
+
+	EXPECT_ANY_THROW(alloc.Allocate(8));
+}
+
+TEST(LinearAllocatorTest, Reset)
+{
+	LinearAllocator alloc(64);
+	void* first = alloc.Allocate(32);
+
+	alloc.Allocate(16);
+	alloc.Reset();
+
+	EXPECT_EQ(0u, alloc.UsedSize());
+	EXPECT_EQ(first, alloc.Allocate(32));
+}
+
+TEST(LinearAllocatorTest, RewindToMarker)
+{
+	LinearAllocator alloc(256);
+
+	alloc.Allocate(16);
+
+	LinearAllocator::Marker marker = alloc.GetMarker();
+	void* ptr = alloc.Allocate(32);
+
+	alloc.Allocate(32);
+	alloc.RewindToMarker(marker);
+
+	EXPECT_EQ(16u, alloc.UsedSize());
+	EXPECT_EQ(ptr, alloc.Allocate(32));
+}
+
+TEST(LinearAllocatorTest, FreeLatest)
+{
+	LinearAllocator alloc(256);
+
+	alloc.Allocate(16);
+	void* ptr = alloc.Allocate(32);
+	alloc.Free(ptr);
+
+	EXPECT_EQ(16u, alloc.UsedSize());
+}
+
+TEST(LinearAllocatorTest, FreeOlderCountsAllocation)
+{
+	LinearAllocator alloc(256);
+
+	void* ptr = alloc.Allocate(16);
+	alloc.Allocate(32);
+	alloc.Free(ptr);
+
+	EXPECT_EQ(48u, alloc.UsedSize());
+	EXPECT_EQ(1u, alloc.GetStats().allocationCount);
+}
+
+TEST(LinearAllocatorTest, ReallocateLatestInPlace)
+{
+	LinearAllocator alloc(256);
+	uint32* ptr = alloc.Allocate<uint32>(4);
+
+	ptr[3] = 1337;
+	uint32* newPtr = (uint32*)alloc.Reallocate(ptr, 32 * sizeof(uint32));
+
+	EXPECT_EQ(ptr, newPtr);
+	EXPECT_EQ(1337u, newPtr[3]);
+	EXPECT_EQ(32 * sizeof(uint32), alloc.UsedSize());
+}
+
+TEST(LinearAllocatorTest, ReallocateOlderCopies)
+{
+	LinearAllocator alloc(256);
+	uint32* ptr = alloc.Allocate<uint32>(4);
+
+	alloc.Allocate(4);
+	ptr[3] = 1337;
+	uint32* newPtr = (uint32*)alloc.Reallocate(ptr, 8 * sizeof(uint32));
+
+	EXPECT_NE(ptr, newPtr);
+	EXPECT_EQ(1337u, newPtr[3]);
+	EXPECT_EQ(2u, alloc.GetStats().allocationCount);
+}
+
+TEST(LinearAllocatorTest, SizedFreeInReverseOrder)
+{
+	LinearAllocator alloc(256);
+	void* a = alloc.Allocate(16);
+	void* b = alloc.Allocate(32);
+	void* c = alloc.Allocate(8);
+
+	alloc.Free(c, 8);
+	alloc.Free(b, 32);
+
+	EXPECT_EQ(16u, alloc.UsedSize());
+
+	alloc.Free(a, 16);
+
+	EXPECT_EQ(0u, alloc.UsedSize());
+	EXPECT_EQ(0u, alloc.GetStats().allocationCount);
+}
+
+TEST(LinearAllocatorTest, SizedReallocateAfterFreeInPlace)
+{
+	LinearAllocator alloc(256);
+	uint32* ptr = alloc.Allocate<uint32>(4);
+	void* tmp = alloc.Allocate(16);
+
+	alloc.Free(tmp, 16);
+	ptr[3] = 1337;
+	uint32* newPtr = (uint32*)alloc.Reallocate(ptr, 4 * sizeof(uint32), 8 * sizeof(uint32), alignof(uint32));
+
+	EXPECT_EQ(ptr, newPtr);
+	EXPECT_EQ(1337u, newPtr[3]);
+	EXPECT_EQ(8 * sizeof(uint32), alloc.UsedSize());
+}
+
+TEST(LinearAllocatorTest, ScopeRewinds)
+{
+	LinearAllocator alloc(1024);
+
+	{
+		LinearAllocatorScope scope(alloc);
+		TArray<uint32> a(&alloc);
+
+		for (uint32 i = 0; i < 100; ++i)
+			a.Append(i);
+
+		EXPECT_EQ(99u, a[99]);
+	}
+
+	EXPECT_EQ(0u, alloc.UsedSize());
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "Core/Memory/HeapAllocator.h"
+#include "Core/Memory/MemoryTags.h"
+
+using namespace ducklib;
+
+// Every allocation with the default alignment carries a header
+constexpr uint64 HEADER_SIZE = sizeof(Internal::Memory::TaggedHeader);
+
+TEST(MemoryTagsTest, CountsAllocationsAndPeak)
+{
+	HeapAllocator heap;
+	TaggedAllocator alloc(MemoryTag::NET, &heap);
+	MemoryTagStats before = GetMemoryTagStats(MemoryTag::NET);
+
+	ResetMemoryTagPeak(MemoryTag::NET);
+	void* a = alloc.Allocate(100);
+	void* b = alloc.Allocate(300);
+
+	EXPECT_EQ(before.allocatedSize + 400 + 2 * HEADER_SIZE, GetMemoryTagStats(MemoryTag::NET).allocatedSize);
+	EXPECT_EQ(before.allocationCount + 2, GetMemoryTagStats(MemoryTag::NET).allocationCount);
+
+	alloc.Free(b);
+	alloc.Free(a);
+
+	MemoryTagStats after = GetMemoryTagStats(MemoryTag::NET);
+
+	EXPECT_EQ(before.allocatedSize, after.allocatedSize);
+	EXPECT_EQ(before.allocationCount, after.allocationCount);
+	EXPECT_EQ(before.allocatedSize + 400 + 2 * HEADER_SIZE, after.peakAllocatedSize);
+	EXPECT_EQ(0u, heap.GetStats().allocationCount);
+}
+
+TEST(MemoryTagsTest, ReallocateKeepsAlignmentAndData)
+{
+	HeapAllocator heap;
+	TaggedAllocator alloc(MemoryTag::NET, &heap);
+	uint64 sizeBefore = GetMemoryTagStats(MemoryTag::NET).allocatedSize;
+	uint32* ptr = (uint32*)alloc.Allocate(4 * sizeof(uint32), 64);
+
+	ptr[3] = 1337;
+	ptr = (uint32*)alloc.Reallocate(ptr, 1024 * sizeof(uint32));
+
+	EXPECT_EQ(0u, (uintptr_t)ptr % 64);
+	EXPECT_EQ(1337u, ptr[3]);
+	// The data stays at an offset of the alignment
+	EXPECT_EQ(sizeBefore + 1024 * sizeof(uint32) + 64, GetMemoryTagStats(MemoryTag::NET).allocatedSize);
+
+	alloc.Free(ptr);
+
+	EXPECT_EQ(sizeBefore, GetMemoryTagStats(MemoryTag::NET).allocatedSize);
+}
+
+TEST(MemoryTagsTest, BudgetThrows)
+{
+	HeapAllocator heap;
+	TaggedAllocator alloc(MemoryTag::NET, &heap);
+	MemoryTagStats before = GetMemoryTagStats(MemoryTag::NET);
+
+	SetMemoryTagBudget(MemoryTag::NET, before.allocatedSize + 256 + HEADER_SIZE);
+	void* ptr = alloc.Allocate(200);
+
+	EXPECT_THROW(alloc.Allocate(100), std::runtime_error);
+	EXPECT_THROW(alloc.Reallocate(ptr, 300), std::runtime_error);
+	EXPECT_EQ(before.allocatedSize + 200 + HEADER_SIZE, GetMemoryTagStats(MemoryTag::NET).allocatedSize);
+	EXPECT_EQ(before.allocationCount + 1, GetMemoryTagStats(MemoryTag::NET).allocationCount);
+
+	alloc.Free(ptr);
+	SetMemoryTagBudget(MemoryTag::NET, 0);
+
+	EXPECT_EQ(0u, heap.GetStats().allocationCount);
+}
+
+TEST(MemoryTagsTest, TagAllocNew)
+{
+	uint64 countBefore = GetMemoryTagStats(MemoryTag::CORE).allocationCount;
+	IAllocator* alloc = TagAlloc(MemoryTag::CORE);
+	uint64* value = alloc->New<uint64>(42ull);
+
+	EXPECT_EQ(42u, *value);
+	EXPECT_EQ(countBefore + 1, GetMemoryTagStats(MemoryTag::CORE).allocationCount);
+	EXPECT_STREQ("Core", GetMemoryTagName(MemoryTag::CORE));
+
+	alloc->Delete(value);
+
+	EXPECT_EQ(countBefore, GetMemoryTagStats(MemoryTag::CORE).allocationCount);
+}
+
+TEST(MemoryTagsTest, BudgetCountsHeader)
+{
+	HeapAllocator heap;
+	TaggedAllocator alloc(MemoryTag::NET, &heap);
+	MemoryTagStats before = GetMemoryTagStats(MemoryTag::NET);
+
+	SetMemoryTagBudget(MemoryTag::NET, before.allocatedSize + 256);
+
+	EXPECT_THROW(alloc.Allocate(256), std::runtime_error);
+
+	void* ptr = alloc.Allocate(256 - HEADER_SIZE);
+
+	EXPECT_EQ(before.allocatedSize + 256, GetMemoryTagStats(MemoryTag::NET).allocatedSize);
+
+	alloc.Free(ptr);
+	SetMemoryTagBudget(MemoryTag::NET, 0);
+
+	EXPECT_EQ(before.allocatedSize, GetMemoryTagStats(MemoryTag::NET).allocatedSize);
+	EXPECT_EQ(0u, heap.GetStats().allocationCount);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "Core/Memory/PoolAllocator.h"
+
+using namespace ducklib;
+
+struct PoolFoo
+{
+	PoolFoo(uint32 v)
+		: v(v) {}
+
+	uint32 v;
+};
+
+TEST(PoolAllocatorTest, BlockSizeAligned)
+{
+	PoolAllocator alloc(20, 4, 16);
+
+	EXPECT_EQ(32u, alloc.BlockSize());
+}
+
+TEST(PoolAllocatorTest, AllocateAligned)
+{
+	PoolAllocator alloc(24, 8);
+
+	for (uint32 i = 0; i < 16; ++i)
+		EXPECT_EQ(0u, (uintptr_t)alloc.Allocate(24) % PoolAllocator::DEFAULT_BLOCK_ALIGN);
+}
+
+TEST(PoolAllocatorTest, FreeReusesBlock)
+{
+	PoolAllocator alloc(32, 4);
+	void* a = alloc.Allocate(32);
+
+	alloc.Allocate(32);
+	alloc.Free(a);
+
+	EXPECT_EQ(a, alloc.Allocate(32));
+}
+
+TEST(PoolAllocatorTest, GrowsByChunk)
+{
+	PoolAllocator alloc(16, 2);
+
+	alloc.Allocate(16);
+	alloc.Allocate(16);
+
+	EXPECT_EQ(0u, alloc.FreeBlockCount());
+
+	alloc.Allocate(16);
+
+	EXPECT_EQ(1u, alloc.FreeBlockCount());
+}
+
+TEST(PoolAllocatorTest, AllocateTooLarge)
+{
+	PoolAllocator alloc(16, 2, 16);
+
+	EXPECT_ANY_THROW(alloc.Allocate(17));
+	EXPECT_ANY_THROW(alloc.Allocate(16, 32));
+}
+
+TEST(PoolAllocatorTest, ZeroAlignUsesDefault)
+{
+	PoolAllocator alloc(16, 2, 16);
+	void* ptr = alloc.Allocate(16, 0);
+
+	EXPECT_EQ(0u, (uintptr_t)ptr % 16);
+	alloc.Free(ptr);
+}
+
+TEST(PoolAllocatorTest, InvalidBlockAlign)
+{
+	EXPECT_ANY_THROW(PoolAllocator(16, 2, 0));
+	EXPECT_ANY_THROW(PoolAllocator(16, 2, 24));
+}
+
+TEST(PoolAllocatorTest, TypedNewDelete)
+{
+	TPoolAllocator<PoolFoo> alloc(4);
+	PoolFoo* foos[8];
+
+	for (uint32 i = 0; i < 8; ++i)
+		foos[i] = alloc.New(i);
+
+	for (uint32 i = 0; i < 8; ++i)
+		EXPECT_EQ(i, foos[i]->v);
+
+	for (uint32 i = 0; i < 8; ++i)
+		alloc.Delete(foos[i]);
+
+	EXPECT_EQ(8u, alloc.FreeBlockCount());
+}
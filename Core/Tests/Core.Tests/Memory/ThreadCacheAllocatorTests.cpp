@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "Core/Memory/HeapAllocator.h"
+#include "Core/Memory/ThreadCacheAllocator.h"
+
+using namespace ducklib;
+
+TEST(ThreadCacheAllocatorTest, AllocateFree)
+{
+	HeapAllocator heap;
+	ThreadCacheAllocator alloc(&heap);
+	uint32* ptr = alloc.Allocate<uint32>(8);
+
+	for (uint32 i = 0; i < 8; ++i)
+		ptr[i] = i;
+
+	EXPECT_EQ(7u, ptr[7]);
+	EXPECT_EQ(1u, alloc.GetStats().allocationCount);
+	EXPECT_EQ(8 * sizeof(uint32), alloc.GetStats().allocatedSize);
+
+	alloc.Free(ptr);
+
+	EXPECT_EQ(0u, alloc.GetStats().allocationCount);
+	EXPECT_EQ(0u, alloc.GetStats().allocatedSize);
+}
+
+TEST(ThreadCacheAllocatorTest, FreeReusesBlock)
+{
+	HeapAllocator heap;
+	ThreadCacheAllocator alloc(&heap);
+	void* ptr = alloc.Allocate(48);
+
+	alloc.Free(ptr);
+
+	EXPECT_EQ(ptr, alloc.Allocate(60));
+}
+
+TEST(ThreadCacheAllocatorTest, LargeAndAligned)
+{
+	HeapAllocator heap;
+	ThreadCacheAllocator alloc(&heap);
+	void* large = alloc.Allocate(ThreadCacheAllocator::MAX_SMALL_SIZE + 1);
+	void* aligned = alloc.Allocate(32, 128);
+
+	EXPECT_EQ(0u, (uintptr_t)aligned % 128);
+	EXPECT_EQ(2u, alloc.GetStats().allocationCount);
+
+	alloc.Free(large);
+	alloc.Free(aligned);
+
+	EXPECT_EQ(0u, alloc.GetStats().allocationCount);
+}
+
+TEST(ThreadCacheAllocatorTest, ReallocateAcrossClasses)
+{
+	HeapAllocator heap;
+	ThreadCacheAllocator alloc(&heap);
+	uint32* ptr = alloc.Allocate<uint32>(4);
+
+	for (uint32 i = 0; i < 4; ++i)
+		ptr[i] = i + 1;
+
+	ptr = (uint32*)alloc.Reallocate(ptr, 100000 * sizeof(uint32));
+
+	for (uint32 i = 0; i < 4; ++i)
+		EXPECT_EQ(i + 1, ptr[i]);
+
+	ptr = (uint32*)alloc.Reallocate(ptr, 2 * sizeof(uint32));
+
+	EXPECT_EQ(2u, ptr[1]);
+	EXPECT_EQ(2 * sizeof(uint32), alloc.GetStats().allocatedSize);
+
+	alloc.Free(ptr);
+}
+
+TEST(ThreadCacheAllocatorTest, CollidingAllocatorsKeepCaches)
+{
+	HeapAllocator backing;
+	ThreadCacheAllocator* allocs[9];
+
+	// Ids are handed out in order, so the first and last one map to the same slot
+	for (ThreadCacheAllocator*& alloc : allocs)
+		alloc = new ThreadCacheAllocator(&backing);
+
+	void* first = allocs[0]->Allocate(16);
+	allocs[0]->Free(first);
+
+	void* last = allocs[8]->Allocate(16);
+	allocs[8]->Free(last);
+
+	// Each cache still hands out its most recently freed block, so neither was drained by the other
+	EXPECT_EQ(first, allocs[0]->Allocate(16));
+	EXPECT_EQ(last, allocs[8]->Allocate(16));
+
+	allocs[0]->Free(first);
+	allocs[8]->Free(last);
+
+	for (ThreadCacheAllocator* alloc : allocs)
+		delete alloc;
+}
+
+TEST(ThreadCacheAllocatorTest, MultipleThreadsStats)
+{
+	HeapAllocator heap;
+	ThreadCacheAllocator alloc(&heap);
+	constexpr uint32 numThreads = 8;
+	constexpr uint32 numAllocs = 1000;
+	std::vector<std::thread> threads;
+	std::vector<void*> kept(numThreads);
+
+	for (uint32 t = 0; t < numThreads; ++t)
+	{
+		threads.emplace_back([&alloc, &kept, t]()
+		{
+			void* ptrs[numAllocs];
+
+			for (uint32 i = 0; i < numAllocs; ++i)
+				ptrs[i] = alloc.Allocate(16 + i % 512);
+
+			for (uint32 i = 0; i < numAllocs; ++i)
+				alloc.Free(ptrs[i]);
+
+			kept[t] = alloc.Allocate(64);
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	EXPECT_EQ(numThreads, alloc.GetStats().allocationCount);
+	EXPECT_EQ(numThreads * 64, alloc.GetStats().allocatedSize);
+
+	// Freed on another thread than allocated
+	for (void* ptr : kept)
+		alloc.Free(ptr);
+
+	EXPECT_EQ(0u, alloc.GetStats().allocationCount);
+	EXPECT_EQ(0u, alloc.GetStats().allocatedSize);
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <vector>
+#include "Core/Memory/TlsfAllocator.h"
+
+using namespace ducklib;
+
+class TlsfAllocatorTest : public testing::Test
+{
+protected:
+	static constexpr uint64 POOL_SIZE = 1 << 20;
+
+	alignas(16) static inline uint8_t memory[POOL_SIZE];
+};
+
+TEST_F(TlsfAllocatorTest, AllocateFree)
+{
+	TlsfAllocator alloc(memory, POOL_SIZE);
+	uint32* ptr = alloc.Allocate<uint32>(16);
+
+	for (uint32 i = 0; i < 16; ++i)
+		ptr[i] = i;
+
+	EXPECT_EQ(15u, ptr[15]);
+	EXPECT_EQ(1u, alloc.GetTlsfStats().usedBlockCount);
+
+	alloc.Free(ptr);
+
+	TlsfStats stats = alloc.GetTlsfStats();
+
+	EXPECT_EQ(0u, stats.usedBlockCount);
+	EXPECT_EQ(1u, stats.freeBlockCount);
+	EXPECT_EQ(stats.poolSize, stats.freeSize);
+	EXPECT_FLOAT_EQ(0.0f, stats.fragmentation);
+}
+
+TEST_F(TlsfAllocatorTest, AllocateAligned)
+{
+	TlsfAllocator alloc(memory, POOL_SIZE);
+
+	alloc.Allocate(3);
+
+	for (uint32 align = 16; align <= 4096; align *= 2)
+	{
+		void* ptr = alloc.Allocate(100, align);
+
+		EXPECT_EQ(0u, (uintptr_t)ptr % align);
+	}
+}
+
+TEST_F(TlsfAllocatorTest, OutOfMemory)
+{
+	TlsfAllocator alloc(memory, 4096);
+
+	EXPECT_ANY_THROW(alloc.Allocate(8192));
+}
+
+TEST_F(TlsfAllocatorTest, MergesNeighboursOnFree)
+{
+	TlsfAllocator alloc(memory, POOL_SIZE);
+	void* a = alloc.Allocate(1000);
+	void* b = alloc.Allocate(1000);
+	void* c = alloc.Allocate(1000);
+
+	alloc.Free(a);
+	alloc.Free(c);
+
+	EXPECT_EQ(2u, alloc.GetTlsfStats().freeBlockCount);
+	EXPECT_GT(alloc.GetTlsfStats().fragmentation, 0.0f);
+
+	alloc.Free(b);
+
+	EXPECT_EQ(1u, alloc.GetTlsfStats().freeBlockCount);
+	EXPECT_FLOAT_EQ(0.0f, alloc.GetTlsfStats().fragmentation);
+}
+
+TEST_F(TlsfAllocatorTest, ReallocateInPlaceAndMove)
+{
+	TlsfAllocator alloc(memory, POOL_SIZE);
+	uint32* ptr = alloc.Allocate<uint32>(4);
+
+	ptr[3] = 1337;
+
+	// Followed by free space, so it can grow in place
+	EXPECT_EQ(ptr, alloc.Reallocate(ptr, 400));
+
+	void* blocker = alloc.Allocate(16);
+	uint32* moved = (uint32*)alloc.Reallocate(ptr, 4000);
+
+	EXPECT_NE(ptr, moved);
+	EXPECT_EQ(1337u, moved[3]);
+
+	alloc.Free(moved);
+	alloc.Free(blocker);
+
+	EXPECT_EQ(1u, alloc.GetTlsfStats().freeBlockCount);
+}
+
+TEST_F(TlsfAllocatorTest, ReallocateMoveKeepsAlignment)
+{
+	TlsfAllocator alloc(memory, POOL_SIZE);
+	void* unaligned = alloc.Allocate(24);
+	void* ptr = alloc.Allocate(32, 64);
+	// Large enough to only fit in the free space after ptr, a small one could take the alignment gap in front of it
+	void* blocker = alloc.Allocate(POOL_SIZE / 2);
+
+	ASSERT_EQ(0u, (uintptr_t)ptr % 64);
+
+	// Unsized keeps the alignment the pointer has, sized the one passed in
+	void* moved = alloc.Reallocate(ptr, 4000);
+
+	EXPECT_NE(ptr, moved);
+	EXPECT_EQ(0u, (uintptr_t)moved % 64);
+
+	void* blocker2 = alloc.Allocate(POOL_SIZE / 4);
+	void* movedSized = alloc.Reallocate(moved, 4000, 8000, 256);
+
+	EXPECT_NE(moved, movedSized);
+	EXPECT_EQ(0u, (uintptr_t)movedSized % 256);
+
+	alloc.Free(movedSized);
+	alloc.Free(blocker2);
+	alloc.Free(blocker);
+	alloc.Free(unaligned);
+
+	EXPECT_EQ(1u, alloc.GetTlsfStats().freeBlockCount);
+}
+
+TEST_F(TlsfAllocatorTest, RandomAllocFreeKeepsConsistency)
+{
+	TlsfAllocator alloc(memory, POOL_SIZE);
+	std::vector<uint8_t*> ptrs;
+	std::vector<uint32> sizes;
+
+	srand(1337);
+
+	for (uint32 i = 0; i < 20000; ++i)
+	{
+		if (ptrs.empty() || rand() % 3 != 0)
+		{
+			uint32 size = 1 + rand() % 2048;
+			uint8_t* ptr = (uint8_t*)alloc.Allocate(size);
+
+			memset(ptr, (uint8_t)size, size);
+			ptrs.push_back(ptr);
+			sizes.push_back(size);
+
+			if (ptrs.size() > 200)
+			{
+				alloc.Free(ptrs.front());
+				ptrs.erase(ptrs.begin());
+				sizes.erase(sizes.begin());
+			}
+		}
+		else
+		{
+			uint32 index = rand() % (uint32)ptrs.size();
+
+			for (uint32 u = 0; u < sizes[index]; ++u)
+				ASSERT_EQ((uint8_t)sizes[index], ptrs[index][u]);
+
+			alloc.Free(ptrs[index]);
+			ptrs.erase(ptrs.begin() + index);
+			sizes.erase(sizes.begin() + index);
+		}
+	}
+
+	for (uint8_t* ptr : ptrs)
+		alloc.Free(ptr);
+
+	TlsfStats stats = alloc.GetTlsfStats();
+
+	EXPECT_EQ(1u, stats.freeBlockCount);
+	EXPECT_EQ(stats.poolSize, stats.freeSize);
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "Core/Memory/VirtualAllocator.h"
+#include "Core/Memory/Containers/TArray.h"
+
+using namespace ducklib;
+
+TEST(VirtualAllocatorTest, AllocateWriteFree)
+{
+	VirtualAllocator alloc(1 << 20);
+	uint8_t* ptr = (uint8_t*)alloc.Allocate(10000);
+
+	for (uint32 i = 0; i < 10000; ++i)
+		ptr[i] = (uint8_t)i;
+
+	EXPECT_EQ((uint8_t)9999, ptr[9999]);
+
+	alloc.Free(ptr);
+}
+
+TEST(VirtualAllocatorTest, AllocateAligned)
+{
+	VirtualAllocator alloc(1 << 20);
+	void* ptr = alloc.Allocate(64, 4096);
+
+	EXPECT_EQ(0u, (uintptr_t)ptr % 4096);
+
+	alloc.Free(ptr);
+}
+
+TEST(VirtualAllocatorTest, ReallocateInPlace)
+{
+	VirtualAllocator alloc(64 << 20);
+	uint32* ptr = alloc.Allocate<uint32>(16);
+
+	ptr[15] = 1337;
+
+	uint32* grownPtr = (uint32*)alloc.Reallocate(ptr, 32 << 20);
+
+	EXPECT_EQ(ptr, grownPtr);
+	EXPECT_EQ(1337u, grownPtr[15]);
+
+	grownPtr[(8 << 20) - 1] = 420;
+
+	EXPECT_EQ(ptr, alloc.Reallocate(ptr, 64));
+	EXPECT_EQ(1337u, ptr[15]);
+
+	alloc.Free(ptr);
+}
+
+TEST(VirtualAllocatorTest, ReallocateBeyondReserve)
+{
+	VirtualAllocator alloc(1 << 20);
+	void* ptr = alloc.Allocate(16);
+
+	EXPECT_ANY_THROW(alloc.Reallocate(ptr, 2 << 20));
+	EXPECT_ANY_THROW(alloc.Allocate(2 << 20));
+
+	alloc.Free(ptr);
+}
+
+TEST(VirtualAllocatorTest, TArrayGrowsInPlace)
+{
+	VirtualAllocator alloc(64 << 20);
+
+	{
+		TArray<uint32> a(&alloc);
+
+		a.Append(0);
+		uint32* data = a.Data();
+
+		for (uint32 i = 1; i < 1000000; ++i)
+			a.Append(i);
+
+		EXPECT_EQ(data, a.Data());
+		EXPECT_EQ(999999u, a[999999]);
+	}
+
+	EXPECT_EQ(0u, alloc.GetStats().allocationCount);
+}
@@ -12,4 +12,6 @@ using uint16 = uint16_t;
 using uint32 = uint32_t;
 using uint64 = uint64_t;
 using uchar = unsigned char;
+
+constexpr uint32 CACHE_LINE_SIZE = 128;
 }
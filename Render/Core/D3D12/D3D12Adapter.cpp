@@ -3,6 +3,7 @@
 #include <dxgi1_3.h>
 #include "D3D12Common.h"
 #include "D3D12Device.h"
+#include "Core/Memory/MemoryTags.h"
 
 namespace ducklib::Render
 {
@@ -28,7 +29,7 @@ IDevice* D3D12Adapter::CreateDevice()
 
 D3D12Adapter::D3D12Adapter(const char* description, bool isHardware, IDXGIAdapter1* apiAdapter, IDXGIFactory4* factory)
 	: IAdapter(description, isHardware)
-	, alloc(DefAlloc())
+	, alloc(TagAlloc(MemoryTag::RENDER))
 	, factory(factory)
 	, apiAdapter(apiAdapter) {}
 
@@ -1,6 +1,7 @@
 #include <exception>
 #include "Lib/d3dx12.h"
 #include "Core/Memory/IAllocator.h"
+#include "Core/Memory/MemoryTags.h"
 #include "D3D12Device.h"
 #include "D3D12CommandBuffer.h"
 #include "D3D12Common.h"
@@ -176,7 +177,7 @@ IFence* D3D12Device::CreateFence()
 }
 
 D3D12Device::D3D12Device(ID3D12Device* d3dDevice, IDXGIFactory4* dxgiFactory)
-	: alloc(DefAlloc())
+	: alloc(TagAlloc(MemoryTag::RENDER))
 {
 	this->d3dFactory = dxgiFactory;
 	this->d3dDevice = d3dDevice;
@@ -4,6 +4,7 @@
 #include "D3D12Device.h"
 #include "Core/Utility.h"
 #include "Core/Memory/IAllocator.h"
+#include "Core/Memory/MemoryTags.h"
 #include "Core/Memory/Containers/Iterators.h"
 
 namespace ducklib::Render
@@ -33,7 +34,7 @@ D3D12RHI::D3D12RHI()
 	: alloc(nullptr)
 	, factory(nullptr)
 {
-	alloc = DefAlloc();
+	alloc = TagAlloc(MemoryTag::RENDER);
 	InitFactory();
 	EnumerateAdapters();
 }
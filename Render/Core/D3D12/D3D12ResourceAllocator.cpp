@@ -1,11 +1,12 @@
 #include "D3D12ResourceAllocator.h"
 #include "Core/Memory/IAllocator.h"
+#include "Core/Memory/MemoryTags.h"
 
 namespace ducklib::Render
 {
 D3D12ResourceAllocator::D3D12ResourceAllocator()
 {
-	alloc = DefAlloc();
+	alloc = TagAlloc(MemoryTag::RENDER);
 }
 
 ImageBuffer* D3D12ResourceAllocator::AllocatorImageBuffer()
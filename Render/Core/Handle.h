@@ -1,12 +1,8 @@
 #pragma once
-#include <cstdint>
+#include "Core/Memory/Containers/TSlotMap.h"
 
 namespace ducklib::Render
 {
-struct Handle
-{
-	uint32 type : 6;
-	uint32 index : 25;
-	// TODO: Consider adding a generation value to detect outdated handles being reused
-};
+// Type and index bits followed by a generation that detects outdated handles being reused, see TSlotMap
+using Handle = SlotHandle;
 }
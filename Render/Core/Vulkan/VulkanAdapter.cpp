@@ -1,6 +1,7 @@
 #include "VulkanAdapter.h"
 
 #include "VulkanDevice.h"
+#include "Core/Memory/MemoryTags.h"
 #include "Core/Memory/Containers/TArray.h"
 
 namespace ducklib::Render
@@ -56,7 +57,7 @@ VulkanAdapter::VulkanAdapter(
 	VkPhysicalDevice apiAdapter,
 	VkInstance vkInstance)
 	: IAdapter(description, isHardware)
-	, alloc(DefAlloc())
+	, alloc(TagAlloc(MemoryTag::RENDER))
 	, vkInstance(vkInstance)
 	, physicalDevice(apiAdapter) {}
 
@@ -4,7 +4,9 @@
 #include "VulkanFrameBuffer.h"
 #include "VulkanPass.h"
 #include "VulkanSwapChain.h"
+#include "Core/Memory/MemoryTags.h"
 #include "Core/Memory/Containers/TArray.h"
+#include "Core/Memory/Containers/TInlineArray.h"
 #include "Lib/vulkan_win32.h"
 #include "Lib/glfw3.h"
 
@@ -31,7 +33,7 @@ ICommandBuffer* VulkanDevice::CreateCommandBuffer()
 
 	DL_VK_CHECK(vkAllocateCommandBuffers(vkDevice, &allocInfo, &vkCommandBuffer), "Failed to create Vulkan command buffer");
 
-	VulkanCommandBuffer* cmdBuffer = alloc->Allocate<VulkanCommandBuffer>();
+	VulkanCommandBuffer* cmdBuffer = commandBufferPool.Allocate<VulkanCommandBuffer>();
 	new(cmdBuffer) VulkanCommandBuffer(vkCommandBuffer);
 
 	return cmdBuffer;
@@ -39,8 +41,10 @@ ICommandBuffer* VulkanDevice::CreateCommandBuffer()
 
 IPass* VulkanDevice::CreatePass(const PassDescription& passDesc)
 {
+	LinearAllocatorScope scratchScope(scratchAlloc);
+
 	// Setup attachments
-	TArray<VkAttachmentDescription> vkAttachmentDescs(nullptr, passDesc.frameBufferDescCount);
+	TInlineArray<VkAttachmentDescription, 8> vkAttachmentDescs(nullptr, passDesc.frameBufferDescCount, passDesc.frameBufferDescCount, &scratchAlloc);
 
 	for (uint32 i = 0; i < passDesc.frameBufferDescCount; ++i)
 	{
@@ -62,9 +66,9 @@ IPass* VulkanDevice::CreatePass(const PassDescription& passDesc)
 	for (uint32 i = 0; i < passDesc.subPassDescCount; ++i)
 		totalAttachmentRefCount += passDesc.subPassDescs[i].frameBufferDescRefCount;
 
-	TArray<VkAttachmentReference> vkAttachmentRefs(totalAttachmentRefCount);
-	TArray<VkAttachmentReference*> vkAttachmentRefPtrs(passDesc.subPassDescCount);
-	TArray<VkSubpassDescription> vkSubPassDescs(nullptr, passDesc.subPassDescCount);
+	TInlineArray<VkAttachmentReference, 8> vkAttachmentRefs(totalAttachmentRefCount, &scratchAlloc);
+	TInlineArray<VkAttachmentReference*, 8> vkAttachmentRefPtrs(passDesc.subPassDescCount, &scratchAlloc);
+	TInlineArray<VkSubpassDescription, 8> vkSubPassDescs(nullptr, passDesc.subPassDescCount, passDesc.subPassDescCount, &scratchAlloc);
 
 	for (uint32 i = 0; i < passDesc.subPassDescCount; ++i)
 	{
@@ -114,7 +118,7 @@ IFrameBuffer* VulkanDevice::CreateFrameBuffer(ImageBuffer** imageBuffers, uint32
 {
 	VkFramebuffer vkFrameBuffer;
 	VkFramebufferCreateInfo frameBufferCreateInfo{};
-	TArray<VkImageView> vkFrameBufferImageViews(nullptr, imageBufferCount);
+	TInlineArray<VkImageView, 8> vkFrameBufferImageViews(nullptr, imageBufferCount);
 
 	// TODO: Loop images
 	for (uint32 i = 0; i < imageBufferCount; ++i)
@@ -139,7 +143,12 @@ IFrameBuffer* VulkanDevice::CreateFrameBuffer(ImageBuffer** imageBuffers, uint32
 
 void VulkanDevice::DestroyCommandBuffer(ICommandBuffer* commandBuffer)
 {
-	// TODO: Implement
+	VulkanCommandBuffer* cmdBuffer = (VulkanCommandBuffer*)commandBuffer;
+
+	vkFreeCommandBuffers(vkDevice, vkCommandPool, 1, &cmdBuffer->vkCommandBuffer);
+
+	cmdBuffer->~VulkanCommandBuffer();
+	commandBufferPool.Free(cmdBuffer);
 }
 
 void VulkanDevice::ExecuteCommandBuffers(
@@ -148,7 +157,8 @@ void VulkanDevice::ExecuteCommandBuffers(
 	void* waitSemaphore,
 	IFence* signalFence)
 {
-	TArray<VkCommandBuffer> vkCommandBuffers(nullptr, commandBufferCount);
+	LinearAllocatorScope scratchScope(scratchAlloc);
+	TArray<VkCommandBuffer> vkCommandBuffers(nullptr, commandBufferCount, commandBufferCount, &scratchAlloc);
 	VkSubmitInfo submitInfo{};
 	VkSemaphore vkWaitSemaphore = (VkSemaphore)waitSemaphore;
 	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
@@ -205,7 +215,7 @@ ISwapChain* VulkanDevice::CreateSwapChain(uint32_t width, uint32_t height, Forma
 
 	// Get image buffers
 	uint32 imageCount = 0;
-	TArray<VkImage> vkImages;
+	TInlineArray<VkImage, ISwapChain::MAX_BUFFERS> vkImages;
 
 	DL_VK_CHECK(vkGetSwapchainImagesKHR(vkDevice, vkSwapChain, &imageCount, nullptr), "Failed to get Vulkan swapchain image count");
 
@@ -287,7 +297,9 @@ VulkanDevice::VulkanDevice(
 	uint32 graphicsQueueFamilyIndex,
 	VkPhysicalDevice physicalDevice,
 	VkInstance vkInstance)
-	: alloc(DefAlloc())
+	: alloc(TagAlloc(MemoryTag::RENDER))
+	, scratchAlloc(SCRATCH_ALLOC_SIZE, alloc)
+	, commandBufferPool(COMMAND_BUFFERS_PER_POOL_CHUNK, alloc)
 	, vkInstance(vkInstance)
 	, physicalDevice(physicalDevice)
 	, vkDevice(vkDevice)
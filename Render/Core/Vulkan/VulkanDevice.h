@@ -1,9 +1,13 @@
 #pragma once
+#include "VulkanCommandBuffer.h"
 #include "VulkanSemaphore.h"
 #include "Lib/vulkan.h"
 #include "../IDevice.h"
 #include "Core/Memory/IAllocator.h"
+#include "Core/Memory/LinearAllocator.h"
+#include "Core/Memory/PoolAllocator.h"
 #include "Core/Memory/Containers/TArray.h"
+#include "Core/Memory/Containers/TInlineArray.h"
 
 namespace ducklib::Render
 {
@@ -44,8 +48,8 @@ protected:
 
 	struct SwapChainSupport
 	{
-		TArray<VkSurfaceFormatKHR> surfaceFormats;
-		TArray<VkPresentModeKHR> presentModes;
+		TInlineArray<VkSurfaceFormatKHR, 8> surfaceFormats;
+		TInlineArray<VkPresentModeKHR, 8> presentModes;
 		VkSurfaceCapabilitiesKHR surfaceCapabilities;
 	};
 
@@ -54,7 +58,12 @@ protected:
 	uint32 SelectPresentModeIndex(const TArray<VkPresentModeKHR>& presentModes);
 	VkExtent2D GetSurfaceExtent(const VkSurfaceCapabilitiesKHR& surfaceCapabilities, uint32 width, uint32 height) const;
 
+	static constexpr uint64 SCRATCH_ALLOC_SIZE = 64 * 1024;
+	static constexpr uint32 COMMAND_BUFFERS_PER_POOL_CHUNK = 32;
+
 	IAllocator* alloc;
+	LinearAllocator scratchAlloc; // For temporary arrays that don't outlive the call creating them
+	TPoolAllocator<VulkanCommandBuffer> commandBufferPool;
 
 	VkInstance vkInstance;
 	VkPhysicalDevice physicalDevice;
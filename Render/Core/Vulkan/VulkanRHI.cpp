@@ -2,6 +2,7 @@
 #include "Lib/glfw3.h"
 #include <stdexcept>
 #include "VulkanAdapter.h"
+#include "Core/Memory/MemoryTags.h"
 
 namespace ducklib::Render
 {
@@ -23,7 +24,7 @@ VulkanRHI::VulkanRHI()
 	: alloc(nullptr)
 	, instance(nullptr)
 {
-	alloc = DefAlloc();
+	alloc = TagAlloc(MemoryTag::RENDER);
 
 	CreateInstance();
 	EnumerateAdapters();
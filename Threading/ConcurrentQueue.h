@@ -1,11 +1,9 @@
 #pragma once
 #include <atomic>
-#include "Core/Memory/IAllocator.h"
+#include "Core/Memory/MemoryTags.h"
 
 namespace ducklib
 {
-constexpr uint32 CACHE_LINE_SIZE = 128;
-
 template <typename T>
 class ConcurrentQueue
 {
@@ -18,6 +16,9 @@ public:
 	uint32 TryPush(T* items, uint32 numItems);
 	bool TryPop(T* item);
 
+	// Only a snapshot while other threads are pushing or popping
+	uint32 Length() const;
+
 private:
 
 	struct alignas(CACHE_LINE_SIZE) Slot
@@ -37,7 +38,7 @@ template <typename T>
 ConcurrentQueue<T>::ConcurrentQueue(uint32 size, T* initialItems, uint32 numInitialItems)
 	: size(size)
 {
-	slots = DefAlloc()->Allocate<Slot>(size);
+	slots = TagAlloc(MemoryTag::THREADING)->Allocate<Slot>(size);
 
 	for (uint32 i = 0; i < numInitialItems; ++i)
 	{
@@ -56,7 +57,7 @@ ConcurrentQueue<T>::ConcurrentQueue(uint32 size, T* initialItems, uint32 numInit
 template <typename T>
 ConcurrentQueue<T>::~ConcurrentQueue()
 {
-	DefAlloc()->Free(slots);
+	TagAlloc(MemoryTag::THREADING)->Free(slots);
 }
 
 template <typename T>
@@ -89,7 +90,9 @@ uint32 ConcurrentQueue<T>::TryPush(T item)
 			uint64 oldCachedTail = cachedTail;
 			cachedTail = tail.load();
 
-			if (cachedTail == oldCachedTail)
+			// The slot's item may have been popped already by a thread that hasn't marked it free yet, so only a queue
+			// that is actually full fails
+			if (cachedTail == oldCachedTail && cachedTail - head.load() >= size)
 				return 0;
 		}
 	}
@@ -137,9 +140,19 @@ bool ConcurrentQueue<T>::TryPop(T* item)
 			uint64 oldCachedHead = cachedHead;
 			cachedHead = head.load();
 
-			if (cachedHead == oldCachedHead)
+			// Same for a slot that has been claimed by a pushing thread that hasn't finished writing it
+			if (cachedHead == oldCachedHead && tail.load() <= cachedHead)
 				return false;
 		}
 	}
 }
-}
\ No newline at end of file
+
+template <typename T>
+uint32 ConcurrentQueue<T>::Length() const
+{
+	uint64 cachedHead = head.load(std::memory_order_relaxed);
+	uint64 cachedTail = tail.load(std::memory_order_relaxed);
+
+	return cachedTail > cachedHead ? (uint32)(cachedTail - cachedHead) : 0;
+}
+}
@@ -0,0 +1,106 @@
+#include <climits>
+#include "EventCount.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#pragma comment(lib, "Synchronization.lib")
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ducklib
+{
+namespace
+{
+void WaitOnEpoch(std::atomic<uint32>* epoch, uint32 key)
+{
+#ifdef _WIN32
+	WaitOnAddress(epoch, &key, sizeof(key), INFINITE);
+#elif defined(__linux__)
+	// Returns right away if the epoch has already moved on, spurious wakeups are handled by the caller
+	syscall(SYS_futex, (uint32*)epoch, FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0);
+#else
+	epoch->wait(key);
+#endif
+}
+
+void WakeOnEpoch(std::atomic<uint32>* epoch, uint32 count)
+{
+#ifdef _WIN32
+	if (count == UINT_MAX)
+		WakeByAddressAll(epoch);
+	else
+	{
+		for (uint32 i = 0; i < count; ++i)
+			WakeByAddressSingle(epoch);
+	}
+#elif defined(__linux__)
+	syscall(SYS_futex, (uint32*)epoch, FUTEX_WAKE_PRIVATE, count > INT_MAX ? INT_MAX : (int)count, nullptr, nullptr, 0);
+#else
+	if (count == UINT_MAX)
+		epoch->notify_all();
+	else
+	{
+		for (uint32 i = 0; i < count; ++i)
+			epoch->notify_one();
+	}
+#endif
+}
+}
+
+EventCount::EventCount()
+	: epoch(0)
+	, numWaiters(0) {}
+
+uint32 EventCount::PrepareWait()
+{
+	// Registering before reading the epoch pairs with Notify checking for waiters after publishing its work
+	numWaiters.fetch_add(1, std::memory_order_seq_cst);
+
+	return epoch.load(std::memory_order_seq_cst);
+}
+
+void EventCount::CancelWait()
+{
+	numWaiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void EventCount::Wait(uint32 key)
+{
+	while (epoch.load(std::memory_order_acquire) == key)
+		WaitOnEpoch(&epoch, key);
+
+	numWaiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void EventCount::Notify(uint32 count)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	uint32 cachedNumWaiters = numWaiters.load(std::memory_order_relaxed);
+
+	if (cachedNumWaiters == 0 || count == 0)
+		return;
+
+	epoch.fetch_add(1, std::memory_order_release);
+	WakeOnEpoch(&epoch, count < cachedNumWaiters ? count : cachedNumWaiters);
+}
+
+void EventCount::NotifyAll()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (numWaiters.load(std::memory_order_relaxed) == 0)
+		return;
+
+	epoch.fetch_add(1, std::memory_order_release);
+	WakeOnEpoch(&epoch, UINT_MAX);
+}
+
+uint32 EventCount::NumWaiters() const
+{
+	return numWaiters.load(std::memory_order_relaxed);
+}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include "Core/Types.h"
+
+namespace ducklib
+{
+/**
+ * Lets threads sleep until some condition they check themselves becomes true, without losing wakeups. A waiter calls
+ * PrepareWait, checks the condition once more and then either calls CancelWait or Wait with the returned key. Any
+ * Notify after PrepareWait makes Wait return, so work published before the Notify is always seen by the waiter.
+ *
+ * Sleeping is done with a futex on Linux and WaitOnAddress on Windows, Notify doesn't make a system call when
+ * nobody is waiting.
+ */
+class EventCount
+{
+public:
+
+	EventCount();
+
+	uint32 PrepareWait();
+	void CancelWait();
+	void Wait(uint32 key);
+
+	// Wakes up to count waiting threads
+	void Notify(uint32 count);
+	void NotifyAll();
+
+	uint32 NumWaiters() const;
+
+private:
+
+	// Bumped by every Notify that finds waiters, the waiters sleep on it
+	std::atomic<uint32> epoch;
+	std::atomic<uint32> numWaiters;
+};
+}
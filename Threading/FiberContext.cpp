@@ -0,0 +1,227 @@
+#include <stdexcept>
+#include "FiberContext.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+// Pushes the callee-saved registers on the current stack, stores the stack pointer to *from and pops the registers
+// saved on the stack of to. Nothing else needs saving since the switch is an ordinary call to the compiler.
+extern "C" void ducklib_switch_fiber_context(void** from, void* to);
+// First code run on a new stack. The initial frame pops the entry and its data into callee-saved registers.
+extern "C" void ducklib_start_fiber_context();
+
+#if defined(__x86_64__)
+asm(R"(
+	.text
+	.globl ducklib_switch_fiber_context
+	.hidden ducklib_switch_fiber_context
+	.type ducklib_switch_fiber_context, @function
+	.p2align 4
+ducklib_switch_fiber_context:
+	pushq %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	subq $8, %rsp
+	stmxcsr (%rsp)
+	fnstcw 4(%rsp)
+	movq %rsp, (%rdi)
+	movq %rsi, %rsp
+	ldmxcsr (%rsp)
+	fldcw 4(%rsp)
+	addq $8, %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size ducklib_switch_fiber_context, .-ducklib_switch_fiber_context
+
+	.globl ducklib_start_fiber_context
+	.hidden ducklib_start_fiber_context
+	.type ducklib_start_fiber_context, @function
+	.p2align 4
+ducklib_start_fiber_context:
+	movq %r13, %rdi
+	callq *%r12
+	ud2
+	.size ducklib_start_fiber_context, .-ducklib_start_fiber_context
+)");
+#elif defined(__aarch64__)
+asm(R"(
+	.text
+	.globl ducklib_switch_fiber_context
+	.hidden ducklib_switch_fiber_context
+	.type ducklib_switch_fiber_context, %function
+	.p2align 4
+ducklib_switch_fiber_context:
+	sub sp, sp, #160
+	stp x19, x20, [sp, #0]
+	stp x21, x22, [sp, #16]
+	stp x23, x24, [sp, #32]
+	stp x25, x26, [sp, #48]
+	stp x27, x28, [sp, #64]
+	stp x29, x30, [sp, #80]
+	stp d8, d9, [sp, #96]
+	stp d10, d11, [sp, #112]
+	stp d12, d13, [sp, #128]
+	stp d14, d15, [sp, #144]
+	mov x2, sp
+	str x2, [x0]
+	mov sp, x1
+	ldp x19, x20, [sp, #0]
+	ldp x21, x22, [sp, #16]
+	ldp x23, x24, [sp, #32]
+	ldp x25, x26, [sp, #48]
+	ldp x27, x28, [sp, #64]
+	ldp x29, x30, [sp, #80]
+	ldp d8, d9, [sp, #96]
+	ldp d10, d11, [sp, #112]
+	ldp d12, d13, [sp, #128]
+	ldp d14, d15, [sp, #144]
+	add sp, sp, #160
+	ret
+	.size ducklib_switch_fiber_context, .-ducklib_switch_fiber_context
+
+	.globl ducklib_start_fiber_context
+	.hidden ducklib_start_fiber_context
+	.type ducklib_start_fiber_context, %function
+	.p2align 4
+ducklib_start_fiber_context:
+	mov x0, x20
+	blr x19
+	brk #0
+	.size ducklib_start_fiber_context, .-ducklib_start_fiber_context
+)");
+#else
+#error "Fibers are only implemented for x86-64 and AArch64 outside of Windows"
+#endif
+#endif
+
+namespace ducklib::Internal
+{
+#ifdef _WIN32
+void CreateFiberContext(FiberContext* context, uint64 stackSize, FiberEntry entry, void* data)
+{
+	context->osFiber = ::CreateFiber(stackSize, entry, data);
+
+	if (!context->osFiber)
+		throw std::runtime_error("Failed to create fiber");
+}
+
+void DeleteFiberContext(FiberContext* context)
+{
+	::DeleteFiber(context->osFiber);
+	context->osFiber = nullptr;
+}
+
+void ConvertThreadToFiberContext(FiberContext* context)
+{
+	context->osFiber = ::ConvertThreadToFiber(nullptr);
+
+	if (!context->osFiber)
+		throw std::runtime_error("Failed to convert thread to fiber");
+}
+
+void ConvertFiberContextToThread(FiberContext* context)
+{
+	::ConvertFiberToThread();
+	context->osFiber = nullptr;
+}
+
+void SwitchFiberContext(FiberContext* from, FiberContext* to)
+{
+	SwitchToFiber(to->osFiber);
+}
+#else
+void CreateFiberContext(FiberContext* context, uint64 stackSize, FiberEntry entry, void* data)
+{
+	uint64 pageSize = (uint64)sysconf(_SC_PAGESIZE);
+	uint64 alignedStackSize = (stackSize + pageSize - 1) / pageSize * pageSize;
+	char* stack = (char*)mmap(
+		nullptr,
+		alignedStackSize + pageSize,
+		PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+		-1,
+		0);
+
+	if (stack == MAP_FAILED)
+		throw std::runtime_error("Failed to map fiber stack");
+
+	// Stacks grow down, so the guard page goes at the lowest address
+	if (mprotect(stack, pageSize, PROT_NONE) != 0)
+	{
+		munmap(stack, alignedStackSize + pageSize);
+		throw std::runtime_error("Failed to protect fiber stack guard page");
+	}
+
+	uint64* top = (uint64*)(stack + pageSize + alignedStackSize);
+
+#if defined(__x86_64__)
+	// Frame popped by the first switch: control words, r15, r14, r13, r12, rbx, rbp and the return address. The
+	// return address sits 8 bytes below a 16 byte boundary, so the stack is aligned when the start function calls the
+	// entry.
+	uint64* frame = top - 8;
+
+	frame[0] = 0x1F80 | (0x037Full << 32);
+	frame[1] = 0;
+	frame[2] = 0;
+	frame[3] = (uint64)data;
+	frame[4] = (uint64)entry;
+	frame[5] = 0;
+	frame[6] = 0;
+	frame[7] = (uint64)&ducklib_start_fiber_context;
+#elif defined(__aarch64__)
+	// Frame popped by the first switch: x19-x28, x29, x30 and d8-d15
+	uint64* frame = top - 20;
+
+	for (uint32 i = 0; i < 20; ++i)
+		frame[i] = 0;
+
+	frame[0] = (uint64)entry;
+	frame[1] = (uint64)data;
+	frame[11] = (uint64)&ducklib_start_fiber_context;
+#endif
+
+	context->stackPointer = frame;
+	context->stack = stack;
+	context->stackSize = alignedStackSize + pageSize;
+}
+
+void DeleteFiberContext(FiberContext* context)
+{
+	munmap(context->stack, context->stackSize);
+	context->stackPointer = nullptr;
+	context->stack = nullptr;
+	context->stackSize = 0;
+}
+
+void ConvertThreadToFiberContext(FiberContext* context)
+{
+	// The thread keeps its own stack, the stack pointer is filled in when switching away from it
+	context->stackPointer = nullptr;
+	context->stack = nullptr;
+	context->stackSize = 0;
+}
+
+void ConvertFiberContextToThread(FiberContext* context)
+{
+	context->stackPointer = nullptr;
+}
+
+void SwitchFiberContext(FiberContext* from, FiberContext* to)
+{
+	ducklib_switch_fiber_context(&from->stackPointer, to->stackPointer);
+}
+#endif
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "Thread.h"
+
+namespace ducklib::Internal
+{
+using FiberEntry = void (DL_STDCALL*)(void*);
+
+/**
+ * Saved execution state of a fiber. On Windows this wraps an OS fiber. Elsewhere it's the stack pointer that the
+ * callee-saved registers were pushed to when switching away, so a switch is a handful of instructions without any
+ * syscalls. Unlike ucontext, the signal mask isn't part of the context.
+ */
+struct FiberContext
+{
+#ifdef _WIN32
+	void* osFiber;
+#else
+	void* stackPointer;
+	void* stack;
+	uint64 stackSize;
+#endif
+};
+
+/**
+ * The stack is rounded up to whole pages and gets a guard page below it, so overflowing it faults instead of silently
+ * corrupting memory. The entry runs on the first switch to the context and must never return.
+ */
+void CreateFiberContext(FiberContext* context, uint64 stackSize, FiberEntry entry, void* data);
+void DeleteFiberContext(FiberContext* context);
+
+// The calling thread has to be converted before it switches to any fiber, its state is saved in the given context
+void ConvertThreadToFiberContext(FiberContext* context);
+void ConvertFiberContextToThread(FiberContext* context);
+
+// Saves the running state to from and resumes to. Returns when something switches back to from.
+void SwitchFiberContext(FiberContext* from, FiberContext* to);
+}
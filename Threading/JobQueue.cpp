@@ -1,10 +1,23 @@
-#include <Windows.h>
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include "JobQueue.h"
+#include "Core/Memory/MemoryTags.h"
 #include <mutex>
 #include <unordered_map>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Fibers can resume on another thread, so code reading thread locals after a switch must not be inlined into code
+// that read them before it. The compiler would be free to reuse the previous thread's addresses otherwise.
+#ifdef _MSC_VER
+#define DL_NOINLINE __declspec(noinline)
+#else
+#define DL_NOINLINE __attribute__((noinline))
+#endif
+
 namespace ducklib
 {
 Job::Job()
@@ -21,64 +34,88 @@ namespace Internal
 {
 std::atomic<bool> runWorkers;
 thread_local Fiber workerThreadFiber{};
-thread_local bool isWorkerThread{ false };
+thread_local Worker* currentWorker{};
 thread_local Fiber* currentFiber{};
 
-void SwitchFiber(const Fiber* fiber)
+void SwitchFiber(Fiber* from, Fiber* to)
 {
-#ifdef _WIN32
-	SwitchToFiber(fiber->osFiber);
-#endif
+	SwitchFiberContext(&from->context, &to->context);
 }
 
-void SwitchToWorker()
+DL_NOINLINE Worker* GetCurrentWorker()
 {
-	SwitchFiber(&workerThreadFiber);
+	return currentWorker;
 }
 
-void InitWorkerThread()
+DL_NOINLINE Fiber* GetCurrentFiber()
 {
-	isWorkerThread = true;
-#ifdef _WIN32
-	workerThreadFiber.osFiber = ConvertThreadToFiber(&workerThreadFiber);
-#endif
+	return currentFiber;
 }
 
-uint32 _stdcall WorkerThreadJob(void* data)
+DL_NOINLINE void SwitchToWorker()
 {
-	JobQueue::WorkerThreadData* workerThreadData = (JobQueue::WorkerThreadData*)data;
-	std::atomic<bool>& runFlag = workerThreadData->runFlag;
-	std::atomic<bool>& startFlag = workerThreadData->startFlag;
-	JobQueue* jobQueue = workerThreadData->jobQueue;
+	SwitchFiber(currentFiber, &workerThreadFiber);
+}
 
-	InitWorkerThread();
+void InitWorkerThread(Worker* worker)
+{
+	currentWorker = worker;
+	ConvertThreadToFiberContext(&workerThreadFiber.context);
+}
+
+uint32 DL_STDCALL WorkerThreadJob(void* data)
+{
+	Worker* worker = (Worker*)data;
+	JobQueue* jobQueue = worker->jobQueue;
+	std::atomic<bool>& runFlag = jobQueue->workerThreadData.runFlag;
+	std::atomic<bool>& startFlag = jobQueue->workerThreadData.startFlag;
+
+	InitWorkerThread(worker);
 
 	while (!startFlag.load())
-		YieldThread(10);
+	{
+		uint32 key = jobQueue->workAvailable.PrepareWait();
+
+		if (startFlag.load())
+		{
+			jobQueue->workAvailable.CancelWait();
+			break;
+		}
+
+		jobQueue->workAvailable.Wait(key);
+	}
 
 	while (runFlag.load())
 	{
-		Fiber* jobFiber = jobQueue->GetReadyJobAndFiber();
+		Fiber* jobFiber = jobQueue->GetReadyJobAndFiber(worker);
 
 		if (!jobFiber)
-		{
-			YieldThread(10);
+			jobFiber = jobQueue->WaitForReadyJobAndFiber(worker);
+
+		// Woken up without finding anything, or shutting down
+		if (!jobFiber)
 			continue;
-		}
 
 		if (!jobFiber->currentJob.jobFunction)
 			throw std::runtime_error("Tried to start a fiber with a nullptr job");
 
 		currentFiber = jobFiber;
-		SwitchFiber(currentFiber);
+		SwitchFiber(&workerThreadFiber, jobFiber);
 		currentFiber = nullptr;
-		jobQueue->ReturnFiberIfJobCompleted(jobFiber);
+
+		if (jobFiber->waitCounter)
+			jobQueue->PauseFiber(jobFiber);
+		else
+			jobQueue->ReturnFiberIfJobCompleted(worker, jobFiber);
 	}
 
+	currentWorker = nullptr;
+	ConvertFiberContextToThread(&workerThreadFiber.context);
+
 	return 0;
 }
 
-void _stdcall FiberJobWrapper(void* data)
+void DL_STDCALL FiberJobWrapper(void* data)
 {
 	Fiber* fiberData = (Fiber*)data;
 
@@ -97,21 +134,22 @@ void _stdcall FiberJobWrapper(void* data)
 void JobCounter::Reset()
 {
 	waitingJobFiber = nullptr;
+	completed.store(false);
 }
 
 void JobCounter::Decrement()
 {
-	if (--counter == 0 && waitingJobFiber)
+	if (--counter == 0)
 		jobQueue->FinalizeCompletedJobCounter(this);
 }
 
 JobQueue::JobQueue(uint32 size, uint32 numFibers, uint32 numWorkers)
-	: alloc(DefAlloc())
+	: alloc(TagAlloc(MemoryTag::THREADING))
 {
 	this->numWorkers = numWorkers == MATCH_NUM_LOGICAL_CORES ? GetNumLogicalCores() : numWorkers;
 	queueSize = size;
 
-	uintptr_t* initPtrArrayBuffer = (uintptr_t*)alloc->Allocate(max(size, numFibers) * sizeof(uintptr_t));
+	uintptr_t* initPtrArrayBuffer = (uintptr_t*)alloc->Allocate((std::max)(size, numFibers) * sizeof(uintptr_t));
 
 	SetupCounters(size, initPtrArrayBuffer);
 	SetupFibers(numFibers, initPtrArrayBuffer);
@@ -121,6 +159,7 @@ JobQueue::JobQueue(uint32 size, uint32 numFibers, uint32 numWorkers)
 	alloc->Free(initPtrArrayBuffer);
 
 	workerThreadData.startFlag.store(true);
+	workAvailable.NotifyAll();
 }
 
 JobQueue::~JobQueue()
@@ -131,75 +170,260 @@ JobQueue::~JobQueue()
 	TearDownCounters();
 }
 
-JobCounter* JobQueue::Push(Job* jobs, uint32 numJobs)
+JobCounter* JobQueue::Push(Job* jobs, uint32 numJobs, JobPriority priority)
 {
 	JobCounter* jobCounter;
 
 	if (!counterQueue->TryPop(&jobCounter))
 		throw std::runtime_error("Failed to acquire job counter");
 
+	// Has to be set before the first job can run and decrement it
+	jobCounter->counter.store(numJobs + 1);
+
+	Internal::Worker* worker = Internal::GetCurrentWorker();
+	WorkStealingDeque<Job>* localJobs = worker && worker->jobQueue == this ? worker->jobs[(uint32)priority] : nullptr;
+	ConcurrentQueue<Job>* sharedJobs = jobQueues[(uint32)priority];
+
 	for (uint32 i = 0; i < numJobs; ++i)
+	{
 		jobs[i].jobCounter = jobCounter;
 
-	uint32 jobsQueued = jobQueue->TryPush(jobs, numJobs);
+		if (localJobs && localJobs->TryPush(jobs[i]))
+			continue;
 
-	if (jobsQueued != numJobs)
-		throw std::runtime_error("Failed to push jobs to queue");
+		if (!sharedJobs->TryPush(jobs[i]))
+			throw std::runtime_error("Failed to push jobs to queue");
+	}
 
-	jobCounter->counter.store(jobsQueued);
+	workAvailable.Notify(numJobs);
 
 	return jobCounter;
 }
 
 void JobQueue::WaitForCounter(JobCounter* counter)
 {
-	if (Internal::isWorkerThread)
+	if (Internal::GetCurrentWorker())
 	{
-		counter->waitingJobFiber = Internal::currentFiber;
-		std::atomic_thread_fence(std::memory_order_release);
+		Internal::GetCurrentFiber()->waitCounter = counter;
 		Internal::SwitchToWorker();
 	}
 	else
 		WaitIdle(counter);
 }
 
-Internal::Fiber* JobQueue::GetReadyJobAndFiber()
+JobQueueStats JobQueue::GetStats() const
+{
+	JobQueueStats stats;
+
+	for (uint32 priority = 0; priority < NUM_JOB_PRIORITIES; ++priority)
+	{
+		stats.numQueuedJobs[priority] = jobQueues[priority]->Length();
+
+		for (uint32 i = 0; i < numWorkers; ++i)
+			stats.numQueuedJobs[priority] += workers[i].jobs[priority]->Length();
+	}
+
+	stats.numReadyFibers = readyFiberQueue->Length();
+
+	for (uint32 i = 0; i < numWorkers; ++i)
+		stats.numReadyFibers += workers[i].readyFibers->Length();
+
+	return stats;
+}
+
+Internal::Fiber* JobQueue::GetReadyJobAndFiber(Internal::Worker* worker)
 {
 	Internal::Fiber* readyPausedJobFiber;
 
-	if (readyPausedJobFiberQueue->TryPop(&readyPausedJobFiber))
+	if (worker->readyFibers->TryPop(&readyPausedJobFiber) || readyFiberQueue->TryPop(&readyPausedJobFiber))
 		return readyPausedJobFiber;
 
+	uint32 firstPriority = GetFirstPriority(worker);
+	Job newJob;
+
+	for (uint32 i = 0; i < NUM_JOB_PRIORITIES; ++i)
+	{
+		uint32 priority = GetSearchPriority(firstPriority, i);
+
+		if (worker->jobs[priority]->TryPop(&newJob) || jobQueues[priority]->TryPop(&newJob))
+			return AcquireFiber(worker, newJob);
+	}
+
+	return StealReadyJobAndFiber(worker, firstPriority);
+}
+
+uint32 JobQueue::GetFirstPriority(const Internal::Worker* worker) const
+{
+	// Quotas rather than strict priorities, lower priorities still get a share of the jobs while higher ones are busy
+	if ((worker->numJobsTaken + 1) % (HIGH_PRIORITY_QUOTA * NORMAL_PRIORITY_QUOTA) == 0)
+		return (uint32)JobPriority::BACKGROUND;
+
+	if ((worker->numJobsTaken + 1) % HIGH_PRIORITY_QUOTA == 0)
+		return (uint32)JobPriority::NORMAL;
+
+	return (uint32)JobPriority::HIGH;
+}
+
+uint32 JobQueue::GetSearchPriority(uint32 firstPriority, uint32 index)
+{
+	// The priority whose turn it is goes first, the rest strictly by priority. Wrapping around instead would let
+	// background jobs ahead of high priority ones whenever normal priority has nothing queued.
+	if (index == 0)
+		return firstPriority;
+
+	return index - 1 < firstPriority ? index - 1 : index;
+}
+
+Internal::Fiber* JobQueue::WaitForReadyJobAndFiber(Internal::Worker* worker)
+{
+	// Jobs tend to come in bursts and waking up a parked thread takes a lot longer than spinning for a bit. The spin
+	// gets longer every time it pays off and shorter every time it doesn't.
+	for (uint32 i = 0; i < worker->spinCount; ++i)
+	{
+		PauseCpu();
+
+		if (Internal::Fiber* jobFiber = GetReadyJobAndFiber(worker))
+		{
+			worker->spinCount = (std::min)(worker->spinCount * 2, Internal::Worker::MAX_SPIN_COUNT);
+			return jobFiber;
+		}
+	}
+
+	worker->spinCount = (std::max)(worker->spinCount / 2, Internal::Worker::MIN_SPIN_COUNT);
+
+	uint32 key = workAvailable.PrepareWait();
+
+	// Anything pushed after PrepareWait changes the key and Wait returns right away, so checking once more here
+	// can't miss work
+	Internal::Fiber* jobFiber = GetReadyJobAndFiber(worker);
+
+	if (jobFiber || !workerThreadData.runFlag.load())
+	{
+		workAvailable.CancelWait();
+		return jobFiber;
+	}
+
+	workAvailable.Wait(key);
+
+	return nullptr;
+}
+
+Internal::Fiber* JobQueue::StealReadyJobAndFiber(Internal::Worker* thief, uint32 firstPriority)
+{
+	// xorshift32, picking a random first victim spreads the thieves over the workers
+	thief->randomState ^= thief->randomState << 13;
+	thief->randomState ^= thief->randomState >> 17;
+	thief->randomState ^= thief->randomState << 5;
+
+	uint32 firstVictim = thief->randomState % numWorkers;
+
+	for (uint32 i = 0; i < numWorkers; ++i)
+	{
+		Internal::Worker* victim = &workers[(firstVictim + i) % numWorkers];
+		Internal::Fiber* readyPausedJobFiber;
+
+		if (victim != thief && victim->readyFibers->TrySteal(&readyPausedJobFiber))
+			return readyPausedJobFiber;
+	}
+
+	// Priorities over victims, so a thief doesn't take lower priority jobs from one worker while another has higher
+	// priority ones queued
 	Job newJob;
-	Internal::Fiber* newJobFiber;
 
-	if (jobQueue->TryPop(&newJob))
+	for (uint32 u = 0; u < NUM_JOB_PRIORITIES; ++u)
 	{
-		if (!fiberQueue->TryPop(&newJobFiber))
-			throw std::runtime_error("Failed to acquire fiber for new job");
+		uint32 priority = GetSearchPriority(firstPriority, u);
 
-		newJobFiber->currentJob = newJob;
-		return newJobFiber;
+		for (uint32 i = 0; i < numWorkers; ++i)
+		{
+			Internal::Worker* victim = &workers[(firstVictim + i) % numWorkers];
+
+			if (victim != thief && victim->jobs[priority]->TrySteal(&newJob))
+				return AcquireFiber(thief, newJob);
+		}
 	}
 
 	return nullptr;
 }
 
-void JobQueue::ReturnFiberIfJobCompleted(Internal::Fiber* completedFiber)
+Internal::Fiber* JobQueue::AcquireFiber(Internal::Worker* worker, const Job& job)
+{
+	Internal::Fiber* newJobFiber = worker->freeFiber;
+
+	if (newJobFiber)
+		worker->freeFiber = nullptr;
+	else if (!fiberQueue->TryPop(&newJobFiber))
+		throw std::runtime_error("Failed to acquire fiber for new job");
+
+	newJobFiber->currentJob = job;
+	++worker->numJobsTaken;
+
+	return newJobFiber;
+}
+
+void JobQueue::ReturnFiberIfJobCompleted(Internal::Worker* worker, Internal::Fiber* completedFiber)
 {
 	// jobFunction == nullptr -> completed, otherwise paused
 	if (completedFiber->currentJob.jobFunction)
 		return;
 
-	if (!fiberQueue->TryPush(completedFiber))
+	if (!worker->freeFiber)
+		worker->freeFiber = completedFiber;
+	else if (!fiberQueue->TryPush(completedFiber))
 		throw std::runtime_error("Failed to push used fiber back on fiber queue. Wtf?");
 }
 
+void JobQueue::PauseFiber(Internal::Fiber* fiber)
+{
+	JobCounter* counter = fiber->waitCounter;
+
+	fiber->waitCounter = nullptr;
+	counter->waitingJobFiber = fiber;
+
+	// Dropping the waiter's count last makes the fiber visible to whoever completes the last job. If that already
+	// happened, the fiber can continue right away.
+	if (--counter->counter == 0)
+		FinalizeCompletedJobCounter(counter);
+}
+
 void JobQueue::FinalizeCompletedJobCounter(JobCounter* counter)
 {
-	if (!readyPausedJobFiberQueue->TryPush(counter->waitingJobFiber))
-		throw std::runtime_error("Failed to push job onto job queue");
+	Internal::Fiber* waitingJobFiber = counter->waitingJobFiber;
+
+	// Other threads wait without a fiber and return the counter themselves
+	if (!waitingJobFiber)
+	{
+		counter->completed.store(true);
+		counter->completedEvent.NotifyAll();
+		return;
+	}
+
+	Internal::Worker* worker = Internal::GetCurrentWorker();
+
+	// Threads helping out in WaitForCounter complete counters too, but can't resume fibers themselves
+	if (!worker)
+	{
+		if (!readyFiberQueue->TryPush(waitingJobFiber))
+			throw std::runtime_error("Failed to push job onto job queue");
+
+		workAvailable.Notify(1);
+	}
+	else
+	{
+		if (!worker->readyFibers->TryPush(waitingJobFiber))
+			throw std::runtime_error("Failed to push job onto job queue");
+
+		// This worker resumes the fiber as soon as it's back in its loop, only wake another one for fibers it won't
+		// get to right away
+		if (worker->readyFibers->Length() > 1)
+			workAvailable.Notify(1);
+	}
 
+	ReleaseCounter(counter);
+}
+
+void JobQueue::ReleaseCounter(JobCounter* counter)
+{
 	counter->Reset();
 
 	if (!counterQueue->TryPush(counter))
@@ -211,21 +435,19 @@ Internal::Fiber JobQueue::CreateFiber(void* fiberData)
 	Internal::Fiber fiber;
 
 	fiber.currentJob = {};
-#ifdef _WIN32
-	fiber.osFiber = ::CreateFiber(
+	fiber.waitCounter = nullptr;
+	Internal::CreateFiberContext(
+		&fiber.context,
 		Internal::Fiber::DEFAULT_STACK_SIZE,
 		&Internal::FiberJobWrapper,
 		fiberData);
-#endif
 
 	return fiber;
 }
 
 void JobQueue::DeleteFiber(Internal::Fiber* fiber)
 {
-#ifdef _WIN32
-	::DeleteFiber(fiber->osFiber);
-#endif
+	Internal::DeleteFiberContext(&fiber->context);
 	fiber->~Fiber();
 }
 
@@ -235,13 +457,59 @@ uint32 JobQueue::GetNumLogicalCores() const
 	SYSTEM_INFO sysInfo;
 	GetSystemInfo(&sysInfo);
 	return sysInfo.dwNumberOfProcessors;
+#else
+	return (uint32)sysconf(_SC_NPROCESSORS_ONLN);
 #endif
 }
 
-void JobQueue::WaitIdle(const JobCounter* counter)
+bool JobQueue::TryTakeQueuedJob(Job* job)
 {
-	while (counter->counter.load() != 0)
-		Sleep(5);
+	// Strictly by priority, the waiting thread only helps out until its counter completes
+	for (uint32 priority = 0; priority < NUM_JOB_PRIORITIES; ++priority)
+	{
+		if (jobQueues[priority]->TryPop(job))
+			return true;
+
+		for (uint32 i = 0; i < numWorkers; ++i)
+		{
+			if (workers[i].jobs[priority]->TrySteal(job))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+void JobQueue::WaitIdle(JobCounter* counter)
+{
+	if (--counter->counter != 0)
+	{
+		Job job;
+
+		while (!counter->completed.load())
+		{
+			// Jobs that haven't started yet run right here on the thread's own stack. Any of them may be holding up
+			// the counter, and the thread would be idle otherwise.
+			if (TryTakeQueuedJob(&job))
+			{
+				job.jobFunction(job.jobData);
+				job.jobCounter->Decrement();
+				continue;
+			}
+
+			uint32 key = counter->completedEvent.PrepareWait();
+
+			if (counter->completed.load())
+			{
+				counter->completedEvent.CancelWait();
+				break;
+			}
+
+			counter->completedEvent.Wait(key);
+		}
+	}
+
+	ReleaseCounter(counter);
 }
 
 void JobQueue::SetupCounters(uint32 numCounters, uintptr_t* initPtrArrayBuffer)
@@ -253,6 +521,7 @@ void JobQueue::SetupCounters(uint32 numCounters, uintptr_t* initPtrArrayBuffer)
 	{
 		new(&counters[i]) JobCounter();
 		counters[i].jobQueue = this;
+		counters[i].Reset();
 		initPtrArrayBuffer[i] = (uintptr_t)&counters[i];
 	}
 
@@ -279,25 +548,46 @@ void JobQueue::SetupFibers(uint32 numFibers, uintptr_t* initPtrArrayBuffer)
 
 void JobQueue::SetupJobStorage(uint32 size)
 {
-	readyPausedJobFiberQueue = alloc->New<ConcurrentQueue<Internal::Fiber*>>(size);
-	jobQueue = alloc->New<ConcurrentQueue<Job>>(size);
+	for (uint32 i = 0; i < NUM_JOB_PRIORITIES; ++i)
+		jobQueues[i] = alloc->New<ConcurrentQueue<Job>>(size);
+
+	readyFiberQueue = alloc->New<ConcurrentQueue<Internal::Fiber*>>(numFibers);
 }
 
 void JobQueue::SetupWorkers(uint32 numWorkers)
 {
+	workers = alloc->Allocate<Internal::Worker>(numWorkers);
 	workerThreads = alloc->Allocate<Thread*>(numWorkers);
 
-	workerThreadData.jobQueue = this;
 	workerThreadData.runFlag.store(true);
 	workerThreadData.startFlag.store(false);
 
 	for (uint32 i = 0; i < numWorkers; ++i)
-		workerThreads[i] = alloc->New<Thread>(Internal::WorkerThreadJob, &workerThreadData);
+	{
+		Internal::Worker* worker = new(&workers[i]) Internal::Worker();
+
+		worker->jobQueue = this;
+
+		for (uint32 u = 0; u < NUM_JOB_PRIORITIES; ++u)
+			worker->jobs[u] = alloc->New<WorkStealingDeque<Job>>(queueSize);
+
+		// Every fiber is in at most one deque, so they never fill up
+		worker->readyFibers = alloc->New<WorkStealingDeque<Internal::Fiber*>>(numFibers);
+		worker->freeFiber = nullptr;
+		worker->numJobsTaken = 0;
+		worker->spinCount = Internal::Worker::MIN_SPIN_COUNT;
+		// xorshift needs a non-zero seed
+		worker->randomState = 0x9E3779B9u * (i + 1);
+	}
+
+	for (uint32 i = 0; i < numWorkers; ++i)
+		workerThreads[i] = alloc->New<Thread>(Internal::WorkerThreadJob, &workers[i]);
 }
 
 void JobQueue::TearDownWorkers()
 {
 	workerThreadData.runFlag.store(false);
+	workAvailable.NotifyAll();
 
 	for (uint32 i = 0; i < numWorkers; ++i)
 	{
@@ -306,13 +596,26 @@ void JobQueue::TearDownWorkers()
 	}
 
 	alloc->Free(workerThreads);
+
+	for (uint32 i = 0; i < numWorkers; ++i)
+	{
+		for (uint32 u = 0; u < NUM_JOB_PRIORITIES; ++u)
+			alloc->Delete(workers[i].jobs[u]);
+
+		alloc->Delete(workers[i].readyFibers);
+		workers[i].~Worker();
+	}
+
+	alloc->Free(workers);
 }
 
 void JobQueue::TearDownJobStorage()
 {
 	// TODO: Consider checking if all jobs have been completed before tearing down? Or quick exit?
-	alloc->Delete(jobQueue);
-	alloc->Delete(readyPausedJobFiberQueue);
+	for (uint32 i = 0; i < NUM_JOB_PRIORITIES; ++i)
+		alloc->Delete(jobQueues[i]);
+
+	alloc->Delete(readyFiberQueue);
 }
 
 void JobQueue::TearDownFibers()
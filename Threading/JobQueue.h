@@ -1,7 +1,10 @@
 #pragma once
 #include <cstdint>
 #include "ConcurrentQueue.h"
+#include "EventCount.h"
+#include "FiberContext.h"
 #include "Thread.h"
+#include "WorkStealingDeque.h"
 
 namespace ducklib
 {
@@ -10,12 +13,32 @@ class JobQueue;
 
 namespace Internal
 {
+struct Worker;
+
 void SwitchToWorker();
-void InitWorkerThread();
-uint32 __stdcall WorkerThreadJob(void* data);
-void __stdcall FiberJobWrapper(void* data);
+void InitWorkerThread(Worker* worker);
+uint32 DL_STDCALL WorkerThreadJob(void* data);
+void DL_STDCALL FiberJobWrapper(void* data);
 }
 
+enum class JobPriority : uint8
+{
+	HIGH,
+	NORMAL,
+	BACKGROUND,
+	COUNT,
+};
+
+constexpr uint32 NUM_JOB_PRIORITIES = (uint32)JobPriority::COUNT;
+
+struct JobQueueStats
+{
+	// Jobs waiting to be started, both in the shared queues and the workers' deques
+	uint32 numQueuedJobs[NUM_JOB_PRIORITIES];
+	// Paused fibers whose counters have completed, waiting to be resumed
+	uint32 numReadyFibers;
+};
+
 struct Job
 {
 	Job();
@@ -23,8 +46,8 @@ struct Job
 
 private:
 
-	friend void __stdcall Internal::FiberJobWrapper(void*);
-	friend uint32 __stdcall Internal::WorkerThreadJob(void*);
+	friend void DL_STDCALL Internal::FiberJobWrapper(void*);
+	friend uint32 DL_STDCALL Internal::WorkerThreadJob(void*);
 	friend class JobQueue;
 
 	JobCounter* jobCounter;
@@ -34,22 +57,49 @@ private:
 
 namespace Internal
 {
-void _stdcall FiberJobWrapper(void*);
+void DL_STDCALL FiberJobWrapper(void*);
 	
 struct alignas(CACHE_LINE_SIZE) Fiber
 {
 	Job currentJob;
-	void* osFiber;
+	FiberContext context;
+	// Set when the job waits for a counter. The worker parks the fiber on the counter after switching away from it,
+	// so that it can't be resumed before its context is saved.
+	JobCounter* waitCounter;
 
 	static const uint32 DEFAULT_STACK_SIZE = 65536;
 };
 
-void SwitchFiber(const Fiber* fiber);
+/**
+ * Workers take jobs from the bottom of their own deques and steal from the top of the other workers' deques when
+ * they run out. Jobs pushed from a worker and fibers made ready by it go to its own deques, so the shared queues are
+ * only used for jobs pushed from other threads.
+ */
+struct alignas(CACHE_LINE_SIZE) Worker
+{
+	JobQueue* jobQueue;
+	WorkStealingDeque<Job>* jobs[NUM_JOB_PRIORITIES];
+	WorkStealingDeque<Fiber*>* readyFibers;
+	// Last completed fiber, reused for the next job without going through the shared fiber pool
+	Fiber* freeFiber;
+	uint32 randomState;
+	// Decides which priority gets looked at first, see JobQueue::GetFirstPriority
+	uint32 numJobsTaken;
+	// Times to look for work before parking, adapted to how often spinning finds some
+	uint32 spinCount;
+
+	static constexpr uint32 MIN_SPIN_COUNT = 16;
+	static constexpr uint32 MAX_SPIN_COUNT = 1024;
+};
+
+void SwitchFiber(Fiber* from, Fiber* to);
+Worker* GetCurrentWorker();
+Fiber* GetCurrentFiber();
 }
 
 struct alignas(CACHE_LINE_SIZE) JobCounter
 {
-	friend void _stdcall Internal::FiberJobWrapper(void*);
+	friend void DL_STDCALL Internal::FiberJobWrapper(void*);
 	friend class JobQueue;
 
 protected:
@@ -58,8 +108,12 @@ protected:
 	void Decrement();
 	
 	JobQueue* jobQueue;
+	// Remaining jobs plus one for the waiter, so whoever takes it to 0 is the last one using the counter
 	std::atomic<uint32> counter;
 	Internal::Fiber* waitingJobFiber;
+	// Set when the counter reaches 0 while a thread other than a worker is waiting for it
+	std::atomic<bool> completed;
+	EventCount completedEvent;
 };
 
 class JobQueue
@@ -71,34 +125,60 @@ public:
 	JobQueue(uint32 size, uint32 numFibers, uint32 numWorkers = MATCH_NUM_LOGICAL_CORES);
 	~JobQueue();
 
-	JobCounter* Push(Job* jobs, uint32 numJobs);
-
+	/**
+	 * Jobs pushed from a worker of this queue go to that worker's own deque, from which the other workers steal them.
+	 * Every returned counter has to be waited for once, which returns it to the pool.
+	 *
+	 * Workers take higher priority jobs first, but every few jobs they start looking at a lower priority instead, so
+	 * a steady stream of high priority work can't starve the rest. Resuming paused fibers comes before all of them.
+	 */
+	JobCounter* Push(Job* jobs, uint32 numJobs, JobPriority priority = JobPriority::NORMAL);
+
+	/**
+	 * Workers switch to other jobs until the counter completes. Other threads run queued jobs themselves in the
+	 * meantime and sleep until the counter completes once there are none left.
+	 */
 	void WaitForCounter(JobCounter* counter);
 
+	// Only a snapshot while the workers are running
+	JobQueueStats GetStats() const;
+
 private:
 
 	friend struct Internal::Fiber;
 	friend struct JobCounter;
-	friend uint32 __stdcall Internal::WorkerThreadJob(void* data);
-	friend void __stdcall Internal::FiberJobWrapper(void* data);
+	friend uint32 DL_STDCALL Internal::WorkerThreadJob(void* data);
+	friend void DL_STDCALL Internal::FiberJobWrapper(void* data);
+
+	// Every HIGH_PRIORITY_QUOTA-th job taken starts looking at normal priority, and every
+	// HIGH_PRIORITY_QUOTA * NORMAL_PRIORITY_QUOTA-th at background priority
+	static constexpr uint32 HIGH_PRIORITY_QUOTA = 8;
+	static constexpr uint32 NORMAL_PRIORITY_QUOTA = 8;
 
 	struct WorkerThreadData
 	{
-		JobQueue* jobQueue;
 		std::atomic<bool> runFlag;
 		std::atomic<bool> startFlag;
 	};
 
-	Internal::Fiber* GetReadyJobAndFiber();
-	void ReturnFiberIfJobCompleted(Internal::Fiber* completedFiber);
+	Internal::Fiber* GetReadyJobAndFiber(Internal::Worker* worker);
+	uint32 GetFirstPriority(const Internal::Worker* worker) const;
+	static uint32 GetSearchPriority(uint32 firstPriority, uint32 index);
+	Internal::Fiber* StealReadyJobAndFiber(Internal::Worker* thief, uint32 firstPriority);
+	Internal::Fiber* WaitForReadyJobAndFiber(Internal::Worker* worker);
+	Internal::Fiber* AcquireFiber(Internal::Worker* worker, const Job& job);
+	void ReturnFiberIfJobCompleted(Internal::Worker* worker, Internal::Fiber* completedFiber);
+	void PauseFiber(Internal::Fiber* fiber);
 
 	void FinalizeCompletedJobCounter(JobCounter* counter);
+	void ReleaseCounter(JobCounter* counter);
 
 	Internal::Fiber CreateFiber(void* fiberData);
 	void DeleteFiber(Internal::Fiber* fiber);
 	uint32 GetNumLogicalCores() const;
 
-	void WaitIdle(const JobCounter* counter);
+	bool TryTakeQueuedJob(Job* job);
+	void WaitIdle(JobCounter* counter);
 
 	void SetupCounters(uint32 numCounters, uintptr_t* initPtrArrayBuffer);
 	void SetupFibers(uint32 numFibers, uintptr_t* initPtrArrayBuffer);
@@ -121,12 +201,17 @@ private:
 	ConcurrentQueue<Internal::Fiber*>* fiberQueue;
 
 	uint32 queueSize;
-	ConcurrentQueue<Internal::Fiber*>* readyPausedJobFiberQueue;
-	ConcurrentQueue<Job>* jobQueue;
+	// Jobs pushed from threads other than the workers, and jobs that didn't fit in a worker's deque
+	ConcurrentQueue<Job>* jobQueues[NUM_JOB_PRIORITIES];
+	// Fibers resumed by jobs that ran on threads other than the workers
+	ConcurrentQueue<Internal::Fiber*>* readyFiberQueue;
 
 	uint32 numWorkers;
+	Internal::Worker* workers;
 	Thread** workerThreads;
 	WorkerThreadData workerThreadData;
+	// Idle workers park here, Push wakes one for every job
+	EventCount workAvailable;
 
 	// TODO: Implement
 #ifdef _DEBUG
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "Threading/FiberContext.h"
+
+#ifndef _WIN32
+#include <ucontext.h>
+#endif
+
+using namespace ducklib;
+using namespace ducklib::Internal;
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32 DEFAULT_SWITCHES = 1000000;
+constexpr uint32 DEFAULT_REPEATS = 15;
+constexpr uint64 STACK_SIZE = 65536;
+
+struct Options
+{
+	uint32 switches = DEFAULT_SWITCHES;
+	uint32 repeats = DEFAULT_REPEATS;
+};
+
+struct PingPong
+{
+	FiberContext threadContext;
+	FiberContext fiberContext;
+};
+
+void DL_STDCALL PingPongFiber(void* data)
+{
+	PingPong* pingPong = (PingPong*)data;
+
+	while (true)
+		SwitchFiberContext(&pingPong->fiberContext, &pingPong->threadContext);
+}
+
+// Each round trip is two switches, so the result is the average latency of one switch
+double MeasureFiberContext(uint32 switches)
+{
+	PingPong pingPong;
+
+	ConvertThreadToFiberContext(&pingPong.threadContext);
+	CreateFiberContext(&pingPong.fiberContext, STACK_SIZE, &PingPongFiber, &pingPong);
+
+	// The first switch runs into the fiber's entry and touches its stack
+	SwitchFiberContext(&pingPong.threadContext, &pingPong.fiberContext);
+
+	Clock::time_point start = Clock::now();
+
+	for (uint32 i = 0; i < switches / 2; ++i)
+		SwitchFiberContext(&pingPong.threadContext, &pingPong.fiberContext);
+
+	double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+	DeleteFiberContext(&pingPong.fiberContext);
+	ConvertFiberContextToThread(&pingPong.threadContext);
+
+	return ns / (double)(switches / 2 * 2);
+}
+
+#ifndef _WIN32
+// ucontext as the baseline, it saves and restores the signal mask with a syscall on every switch
+ucontext_t ucontextThread;
+ucontext_t ucontextFiber;
+
+void UcontextPingPong()
+{
+	while (true)
+		swapcontext(&ucontextFiber, &ucontextThread);
+}
+
+double MeasureUcontext(uint32 switches)
+{
+	std::vector<char> stack(STACK_SIZE);
+
+	getcontext(&ucontextFiber);
+	ucontextFiber.uc_stack.ss_sp = stack.data();
+	ucontextFiber.uc_stack.ss_size = stack.size();
+	ucontextFiber.uc_link = nullptr;
+	makecontext(&ucontextFiber, &UcontextPingPong, 0);
+	swapcontext(&ucontextThread, &ucontextFiber);
+
+	Clock::time_point start = Clock::now();
+
+	for (uint32 i = 0; i < switches / 2; ++i)
+		swapcontext(&ucontextThread, &ucontextFiber);
+
+	double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+	return ns / (double)(switches / 2 * 2);
+}
+#endif
+
+void Report(const char* backend, const Options& options, double (*measure)(uint32))
+{
+	std::vector<double> samples;
+
+	for (uint32 i = 0; i < options.repeats; ++i)
+		samples.push_back(measure(options.switches));
+
+	std::sort(samples.begin(), samples.end());
+	printf("%s,%u,%.2f,%.2f\n", backend, options.switches, samples.front(), samples[samples.size() / 2]);
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		bool hasValue = i + 1 < argc;
+
+		if (hasValue && strcmp(argv[i], "--switches") == 0)
+			options.switches = (std::max)(2, atoi(argv[++i]));
+		else if (hasValue && strcmp(argv[i], "--repeats") == 0)
+			options.repeats = (std::max)(1, atoi(argv[++i]));
+		else
+		{
+			fprintf(stderr, "Usage: Threading.FiberBenchmark [--switches N] [--repeats N]\n");
+			return 1;
+		}
+	}
+
+	printf("backend,switches,min_ns_per_switch,median_ns_per_switch\n");
+	Report("fiber_context", options, &MeasureFiberContext);
+#ifndef _WIN32
+	Report("ucontext", options, &MeasureUcontext);
+#endif
+
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include "Threading/EventCount.h"
+#include "Threading/Thread.h"
+
+using namespace ducklib;
+
+constexpr uint32 NUM_EVENT_ITEMS = 20000;
+constexpr uint32 NUM_CONSUMERS = 4;
+
+struct ConsumerTestData
+{
+	EventCount* eventCount;
+	std::atomic<uint32>* available;
+	std::atomic<uint32>* consumed;
+};
+
+uint32 ConsumerThread(void* data)
+{
+	ConsumerTestData* testData = (ConsumerTestData*)data;
+
+	while (true)
+	{
+		uint32 cachedAvailable = testData->available->load();
+
+		if (cachedAvailable > 0)
+		{
+			if (testData->available->compare_exchange_weak(cachedAvailable, cachedAvailable - 1))
+			{
+				// Poison pill, there's one per consumer
+				if (++*testData->consumed > NUM_EVENT_ITEMS)
+					return 0;
+			}
+
+			continue;
+		}
+
+		uint32 key = testData->eventCount->PrepareWait();
+
+		if (testData->available->load() > 0)
+		{
+			testData->eventCount->CancelWait();
+			continue;
+		}
+
+		testData->eventCount->Wait(key);
+	}
+}
+
+TEST(EventCountTest, NotifyAfterPrepareWaitReleasesWait)
+{
+	EventCount eventCount;
+	uint32 key = eventCount.PrepareWait();
+
+	EXPECT_EQ(1u, eventCount.NumWaiters());
+
+	eventCount.Notify(1);
+	// Would block forever if the notification got lost
+	eventCount.Wait(key);
+
+	EXPECT_EQ(0u, eventCount.NumWaiters());
+}
+
+TEST(EventCountTest, CancelWait)
+{
+	EventCount eventCount;
+
+	eventCount.PrepareWait();
+	eventCount.CancelWait();
+
+	EXPECT_EQ(0u, eventCount.NumWaiters());
+
+	// Nothing to wake, the next wait has to block until notified again
+	eventCount.Notify(1);
+	uint32 key = eventCount.PrepareWait();
+	eventCount.NotifyAll();
+	eventCount.Wait(key);
+
+	EXPECT_EQ(0u, eventCount.NumWaiters());
+}
+
+TEST(EventCountTest, ConsumersSeeEveryItem)
+{
+	EventCount eventCount;
+	std::atomic<uint32> available{ 0 };
+	std::atomic<uint32> consumed{ 0 };
+	ConsumerTestData testData = { &eventCount, &available, &consumed };
+	Thread* consumers[NUM_CONSUMERS];
+
+	for (uint32 i = 0; i < NUM_CONSUMERS; ++i)
+		consumers[i] = new Thread(ConsumerThread, &testData);
+
+	for (uint32 i = 0; i < NUM_EVENT_ITEMS + NUM_CONSUMERS; ++i)
+	{
+		++available;
+		eventCount.Notify(1);
+
+		// Lets the consumers run dry and park now and then
+		if (i % 1000 == 0)
+			YieldThread(1);
+	}
+
+	for (uint32 i = 0; i < NUM_CONSUMERS; ++i)
+	{
+		consumers[i]->Join();
+		delete consumers[i];
+	}
+
+	EXPECT_EQ(NUM_EVENT_ITEMS + NUM_CONSUMERS, consumed.load());
+	EXPECT_EQ(0u, available.load());
+	EXPECT_EQ(0u, eventCount.NumWaiters());
+}
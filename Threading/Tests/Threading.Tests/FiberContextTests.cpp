@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include "Threading/FiberContext.h"
+
+using namespace ducklib;
+using namespace ducklib::Internal;
+
+struct PingPongData
+{
+	FiberContext* threadContext;
+	FiberContext* fiberContext;
+	uint32 value;
+};
+
+void DL_STDCALL PingPongFiber(void* data)
+{
+	PingPongData* pingPong = (PingPongData*)data;
+
+	while (true)
+	{
+		++pingPong->value;
+		SwitchFiberContext(pingPong->fiberContext, pingPong->threadContext);
+	}
+}
+
+struct CalleeSavedData
+{
+	FiberContext* threadContext;
+	FiberContext* fiberContext;
+};
+
+void DL_STDCALL ClobberFiber(void* data)
+{
+	CalleeSavedData* calleeSaved = (CalleeSavedData*)data;
+	volatile double sum = 0.0;
+
+	// Keeps values live in registers across the switch in the fiber too
+	while (true)
+	{
+		for (uint32 i = 0; i < 16; ++i)
+			sum = sum + i * 0.5;
+
+		SwitchFiberContext(calleeSaved->fiberContext, calleeSaved->threadContext);
+	}
+}
+
+uint32 DeepRecursion(uint32 depth)
+{
+	volatile char buffer[256];
+
+	buffer[0] = (char)depth;
+
+	return depth == 0 ? buffer[0] : DeepRecursion(depth - 1) + 1;
+}
+
+struct StackData
+{
+	FiberContext* threadContext;
+	FiberContext* fiberContext;
+	uint32 result;
+};
+
+void DL_STDCALL StackFiber(void* data)
+{
+	StackData* stackData = (StackData*)data;
+
+	stackData->result = DeepRecursion(100);
+	SwitchFiberContext(stackData->fiberContext, stackData->threadContext);
+}
+
+TEST(FiberContextTest, SwitchBackAndForth)
+{
+	FiberContext threadContext;
+	FiberContext fiberContext;
+	PingPongData data = { &threadContext, &fiberContext, 0 };
+
+	ConvertThreadToFiberContext(&threadContext);
+	CreateFiberContext(&fiberContext, 65536, &PingPongFiber, &data);
+
+	for (uint32 i = 1; i <= 1000; ++i)
+	{
+		SwitchFiberContext(&threadContext, &fiberContext);
+		ASSERT_EQ(i, data.value);
+	}
+
+	DeleteFiberContext(&fiberContext);
+	ConvertFiberContextToThread(&threadContext);
+}
+
+TEST(FiberContextTest, MultipleFibers)
+{
+	FiberContext threadContext;
+	FiberContext fiberContexts[8];
+	PingPongData data[8];
+
+	ConvertThreadToFiberContext(&threadContext);
+
+	for (uint32 i = 0; i < 8; ++i)
+	{
+		data[i] = { &threadContext, &fiberContexts[i], i * 100 };
+		CreateFiberContext(&fiberContexts[i], 16384, &PingPongFiber, &data[i]);
+	}
+
+	for (uint32 round = 1; round <= 10; ++round)
+	{
+		for (uint32 i = 0; i < 8; ++i)
+			SwitchFiberContext(&threadContext, &fiberContexts[i]);
+	}
+
+	for (uint32 i = 0; i < 8; ++i)
+	{
+		EXPECT_EQ(i * 100 + 10, data[i].value);
+		DeleteFiberContext(&fiberContexts[i]);
+	}
+
+	ConvertFiberContextToThread(&threadContext);
+}
+
+TEST(FiberContextTest, PreservesCalleeSavedState)
+{
+	FiberContext threadContext;
+	FiberContext fiberContext;
+	CalleeSavedData data = { &threadContext, &fiberContext };
+	uint64 a = 0x0123456789ABCDEFull;
+	uint64 b = 0xFEDCBA9876543210ull;
+	double c = 1.25;
+	double d = -3.5;
+
+	ConvertThreadToFiberContext(&threadContext);
+	CreateFiberContext(&fiberContext, 65536, &ClobberFiber, &data);
+
+	for (uint32 i = 0; i < 100; ++i)
+	{
+		SwitchFiberContext(&threadContext, &fiberContext);
+		a = (a << 1) | (a >> 63);
+		b ^= a;
+		c *= 1.5;
+		d -= c;
+	}
+
+	uint64 expectedA = 0x0123456789ABCDEFull;
+	uint64 expectedB = 0xFEDCBA9876543210ull;
+	double expectedC = 1.25;
+	double expectedD = -3.5;
+
+	for (uint32 i = 0; i < 100; ++i)
+	{
+		expectedA = (expectedA << 1) | (expectedA >> 63);
+		expectedB ^= expectedA;
+		expectedC *= 1.5;
+		expectedD -= expectedC;
+	}
+
+	EXPECT_EQ(expectedA, a);
+	EXPECT_EQ(expectedB, b);
+	EXPECT_EQ(expectedC, c);
+	EXPECT_EQ(expectedD, d);
+
+	DeleteFiberContext(&fiberContext);
+	ConvertFiberContextToThread(&threadContext);
+}
+
+TEST(FiberContextTest, FiberUsesItsOwnStack)
+{
+	FiberContext threadContext;
+	FiberContext fiberContext;
+	StackData data = { &threadContext, &fiberContext, 0 };
+
+	ConvertThreadToFiberContext(&threadContext);
+	CreateFiberContext(&fiberContext, 65536, &StackFiber, &data);
+	SwitchFiberContext(&threadContext, &fiberContext);
+
+	EXPECT_EQ(100u, data.result);
+
+	DeleteFiberContext(&fiberContext);
+	ConvertFiberContextToThread(&threadContext);
+}
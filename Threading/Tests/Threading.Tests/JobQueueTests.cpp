@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "Threading/JobQueue.h"
+
+using namespace ducklib;
+
+constexpr uint32 NUM_HELPED_JOBS = 32;
+constexpr uint32 NUM_JOBS_PER_PRIORITY = 16;
+
+struct BlockingJobData
+{
+	std::atomic<bool> started;
+	std::atomic<bool> release;
+};
+
+struct HelpedJobData
+{
+	std::thread::id waitingThread;
+	std::atomic<uint32> numOnWaitingThread;
+};
+
+struct PriorityJobData
+{
+	std::atomic<uint32> numCompleted;
+	JobPriority order[NUM_JOBS_PER_PRIORITY * NUM_JOB_PRIORITIES];
+};
+
+struct PriorityJob
+{
+	PriorityJobData* data;
+	JobPriority priority;
+};
+
+void BlockingJob(void* data)
+{
+	BlockingJobData* jobData = (BlockingJobData*)data;
+
+	jobData->started.store(true);
+
+	while (!jobData->release.load())
+		YieldThread(0);
+}
+
+void HelpedJob(void* data)
+{
+	HelpedJobData* jobData = (HelpedJobData*)data;
+
+	if (std::this_thread::get_id() == jobData->waitingThread)
+		++jobData->numOnWaitingThread;
+}
+
+void RecordPriorityJob(void* data)
+{
+	PriorityJob* job = (PriorityJob*)data;
+
+	job->data->order[job->data->numCompleted.fetch_add(1)] = job->priority;
+}
+
+void ReleaseJob(void* data)
+{
+	((BlockingJobData*)data)->release.store(true);
+}
+
+TEST(JobQueueTest, ExternalWaitRunsQueuedJobs)
+{
+	JobQueue jobQueue(64, 16, 1);
+	BlockingJobData blockingData{ false, false };
+	HelpedJobData helpedData{ std::this_thread::get_id(), 0 };
+	Job blockingJob(&BlockingJob, &blockingData);
+	Job helpedJobs[NUM_HELPED_JOBS];
+
+	JobCounter* blockingCounter = jobQueue.Push(&blockingJob, 1);
+
+	while (!blockingData.started.load())
+		YieldThread(0);
+
+	for (uint32 i = 0; i < NUM_HELPED_JOBS; ++i)
+		helpedJobs[i] = Job(&HelpedJob, &helpedData);
+
+	// The only worker is stuck, so the waiting thread has to run the jobs itself
+	jobQueue.WaitForCounter(jobQueue.Push(helpedJobs, NUM_HELPED_JOBS));
+
+	EXPECT_EQ(NUM_HELPED_JOBS, helpedData.numOnWaitingThread.load());
+
+	blockingData.release.store(true);
+	jobQueue.WaitForCounter(blockingCounter);
+}
+
+TEST(JobQueueTest, ExternalWaitWakesOnCompletion)
+{
+	JobQueue jobQueue(64, 16, 2);
+	BlockingJobData blockingData{ false, false };
+	Job blockingJob(&BlockingJob, &blockingData);
+	Job releaseJob(&ReleaseJob, &blockingData);
+
+	JobCounter* blockingCounter = jobQueue.Push(&blockingJob, 1);
+
+	while (!blockingData.started.load())
+		YieldThread(0);
+
+	// Once the release job has been taken there's nothing left to help with, so this parks until the blocking job
+	// completes
+	JobCounter* releaseCounter = jobQueue.Push(&releaseJob, 1);
+	jobQueue.WaitForCounter(blockingCounter);
+
+	EXPECT_TRUE(blockingData.release.load());
+
+	jobQueue.WaitForCounter(releaseCounter);
+}
+
+TEST(JobQueueTest, HigherPrioritiesRunFirstWithoutStarvingLowerOnes)
+{
+	JobQueue jobQueue(64, 16, 1);
+	BlockingJobData blockingData{ false, false };
+	PriorityJobData priorityData{ 0 };
+	PriorityJob priorityJobs[NUM_JOB_PRIORITIES][NUM_JOBS_PER_PRIORITY];
+	Job jobs[NUM_JOB_PRIORITIES][NUM_JOBS_PER_PRIORITY];
+	JobCounter* counters[NUM_JOB_PRIORITIES];
+	Job blockingJob(&BlockingJob, &blockingData);
+
+	JobCounter* blockingCounter = jobQueue.Push(&blockingJob, 1);
+
+	while (!blockingData.started.load())
+		YieldThread(0);
+
+	// Pushed lowest priority first, so plain FIFO order would run background jobs first
+	for (int32 priority = NUM_JOB_PRIORITIES - 1; priority >= 0; --priority)
+	{
+		for (uint32 i = 0; i < NUM_JOBS_PER_PRIORITY; ++i)
+		{
+			priorityJobs[priority][i] = { &priorityData, (JobPriority)priority };
+			jobs[priority][i] = Job(&RecordPriorityJob, &priorityJobs[priority][i]);
+		}
+
+		counters[priority] = jobQueue.Push(jobs[priority], NUM_JOBS_PER_PRIORITY, (JobPriority)priority);
+	}
+
+	JobQueueStats stats = jobQueue.GetStats();
+
+	for (uint32 priority = 0; priority < NUM_JOB_PRIORITIES; ++priority)
+		EXPECT_EQ(NUM_JOBS_PER_PRIORITY, stats.numQueuedJobs[priority]);
+
+	blockingData.release.store(true);
+
+	// Waiting on the counters from here would run the jobs on this thread instead
+	while (priorityData.numCompleted.load() < NUM_JOBS_PER_PRIORITY * NUM_JOB_PRIORITIES)
+		YieldThread(0);
+
+	jobQueue.WaitForCounter(blockingCounter);
+
+	for (uint32 priority = 0; priority < NUM_JOB_PRIORITIES; ++priority)
+		jobQueue.WaitForCounter(counters[priority]);
+
+	uint32 lastHigh = 0;
+	uint32 firstNormal = ~0u;
+	uint32 firstBackground = ~0u;
+
+	for (uint32 i = 0; i < NUM_JOBS_PER_PRIORITY * NUM_JOB_PRIORITIES; ++i)
+	{
+		if (priorityData.order[i] == JobPriority::HIGH)
+			lastHigh = i;
+		else if (priorityData.order[i] == JobPriority::NORMAL && firstNormal == ~0u)
+			firstNormal = i;
+		else if (priorityData.order[i] == JobPriority::BACKGROUND && firstBackground == ~0u)
+			firstBackground = i;
+	}
+
+	EXPECT_EQ(JobPriority::HIGH, priorityData.order[0]);
+	// The normal priority quota lets some through while high priority jobs are still queued
+	EXPECT_LT(firstNormal, lastHigh);
+	EXPECT_GT(firstBackground, lastHigh);
+
+	stats = jobQueue.GetStats();
+
+	for (uint32 priority = 0; priority < NUM_JOB_PRIORITIES; ++priority)
+		EXPECT_EQ(0u, stats.numQueuedJobs[priority]);
+}
+
+TEST(JobQueueTest, EmptyNormalPriorityDoesNotLetBackgroundJobsAhead)
+{
+	JobQueue jobQueue(64, 16, 1);
+	BlockingJobData blockingData{ false, false };
+	PriorityJobData priorityData{ 0 };
+	PriorityJob highJobData[NUM_JOBS_PER_PRIORITY];
+	PriorityJob backgroundJobData[NUM_JOBS_PER_PRIORITY];
+	Job highJobs[NUM_JOBS_PER_PRIORITY];
+	Job backgroundJobs[NUM_JOBS_PER_PRIORITY];
+	Job blockingJob(&BlockingJob, &blockingData);
+
+	JobCounter* blockingCounter = jobQueue.Push(&blockingJob, 1);
+
+	while (!blockingData.started.load())
+		YieldThread(0);
+
+	for (uint32 i = 0; i < NUM_JOBS_PER_PRIORITY; ++i)
+	{
+		highJobData[i] = { &priorityData, JobPriority::HIGH };
+		backgroundJobData[i] = { &priorityData, JobPriority::BACKGROUND };
+		highJobs[i] = Job(&RecordPriorityJob, &highJobData[i]);
+		backgroundJobs[i] = Job(&RecordPriorityJob, &backgroundJobData[i]);
+	}
+
+	JobCounter* backgroundCounter = jobQueue.Push(backgroundJobs, NUM_JOBS_PER_PRIORITY, JobPriority::BACKGROUND);
+	JobCounter* highCounter = jobQueue.Push(highJobs, NUM_JOBS_PER_PRIORITY, JobPriority::HIGH);
+
+	blockingData.release.store(true);
+
+	while (priorityData.numCompleted.load() < 2 * NUM_JOBS_PER_PRIORITY)
+		YieldThread(0);
+
+	jobQueue.WaitForCounter(blockingCounter);
+	jobQueue.WaitForCounter(highCounter);
+	jobQueue.WaitForCounter(backgroundCounter);
+
+	// Normal priority's turns fall back to high priority, background priority's first turn is further out than this
+	for (uint32 i = 0; i < NUM_JOBS_PER_PRIORITY; ++i)
+		EXPECT_EQ(JobPriority::HIGH, priorityData.order[i]);
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include "Threading/Thread.h"
+#include "Threading/WorkStealingDeque.h"
+
+using namespace ducklib;
+
+constexpr uint32 NUM_STEAL_ITEMS = 100000;
+constexpr uint32 NUM_THIEVES = 3;
+
+struct StealTestData
+{
+	WorkStealingDeque<uint32>* deque;
+	std::atomic<uint32>* taken;
+	std::atomic<bool>* done;
+	std::atomic<uint32>* numTaken;
+};
+
+uint32 ThiefThread(void* data)
+{
+	StealTestData* testData = (StealTestData*)data;
+	uint32 item;
+
+	while (!testData->done->load() || testData->deque->Length() > 0)
+	{
+		if (testData->deque->TrySteal(&item))
+		{
+			++testData->taken[item];
+			++*testData->numTaken;
+		}
+	}
+
+	return 0;
+}
+
+TEST(WorkStealingDequeTest, PopIsLifo)
+{
+	WorkStealingDeque<uint32> deque(8);
+	uint32 result;
+
+	EXPECT_TRUE(deque.TryPush(1));
+	EXPECT_TRUE(deque.TryPush(2));
+	EXPECT_TRUE(deque.TryPush(3));
+
+	EXPECT_TRUE(deque.TryPop(&result));
+	EXPECT_EQ(3, result);
+	EXPECT_TRUE(deque.TryPop(&result));
+	EXPECT_EQ(2, result);
+	EXPECT_TRUE(deque.TryPop(&result));
+	EXPECT_EQ(1, result);
+	EXPECT_FALSE(deque.TryPop(&result));
+}
+
+TEST(WorkStealingDequeTest, StealIsFifo)
+{
+	WorkStealingDeque<uint32> deque(8);
+	uint32 result;
+
+	EXPECT_TRUE(deque.TryPush(1));
+	EXPECT_TRUE(deque.TryPush(2));
+	EXPECT_TRUE(deque.TryPush(3));
+
+	EXPECT_TRUE(deque.TrySteal(&result));
+	EXPECT_EQ(1, result);
+	EXPECT_TRUE(deque.TryPop(&result));
+	EXPECT_EQ(3, result);
+	EXPECT_TRUE(deque.TrySteal(&result));
+	EXPECT_EQ(2, result);
+	EXPECT_FALSE(deque.TrySteal(&result));
+	EXPECT_FALSE(deque.TryPop(&result));
+}
+
+TEST(WorkStealingDequeTest, TryPushFull)
+{
+	WorkStealingDeque<uint32> deque(3);
+	uint32 result;
+
+	// Rounded up to 4
+	for (uint32 i = 0; i < 4; ++i)
+		EXPECT_TRUE(deque.TryPush(i));
+
+	EXPECT_FALSE(deque.TryPush(4));
+	EXPECT_TRUE(deque.TrySteal(&result));
+	EXPECT_TRUE(deque.TryPush(4));
+	EXPECT_EQ(4u, deque.Length());
+}
+
+TEST(WorkStealingDequeTest, MultiWordItems)
+{
+	struct Item
+	{
+		uint64 a;
+		uint32 b;
+	};
+
+	WorkStealingDeque<Item> deque(4);
+	Item result;
+
+	EXPECT_TRUE(deque.TryPush({ 1ull << 40, 7 }));
+	EXPECT_TRUE(deque.TrySteal(&result));
+	EXPECT_EQ(1ull << 40, result.a);
+	EXPECT_EQ(7u, result.b);
+}
+
+TEST(WorkStealingDequeTest, ConcurrentStealsTakeEachItemOnce)
+{
+	WorkStealingDeque<uint32> deque(1024);
+	std::atomic<uint32>* taken = new std::atomic<uint32>[NUM_STEAL_ITEMS]();
+	std::atomic<bool> done{ false };
+	std::atomic<uint32> numTaken{ 0 };
+	StealTestData testData = { &deque, taken, &done, &numTaken };
+	Thread* thieves[NUM_THIEVES];
+	uint32 item;
+
+	for (uint32 i = 0; i < NUM_THIEVES; ++i)
+		thieves[i] = new Thread(ThiefThread, &testData);
+
+	// The owner pushes everything and pops some back, racing the thieves for the last items
+	for (uint32 i = 0; i < NUM_STEAL_ITEMS; ++i)
+	{
+		while (!deque.TryPush(i))
+		{
+			if (deque.TryPop(&item))
+			{
+				++taken[item];
+				++numTaken;
+			}
+		}
+
+		if (i % 3 == 0 && deque.TryPop(&item))
+		{
+			++taken[item];
+			++numTaken;
+		}
+	}
+
+	done.store(true);
+
+	for (uint32 i = 0; i < NUM_THIEVES; ++i)
+	{
+		thieves[i]->Join();
+		delete thieves[i];
+	}
+
+	while (deque.TryPop(&item))
+	{
+		++taken[item];
+		++numTaken;
+	}
+
+	EXPECT_EQ(NUM_STEAL_ITEMS, numTaken.load());
+
+	for (uint32 i = 0; i < NUM_STEAL_ITEMS; ++i)
+		ASSERT_EQ(1u, taken[i].load());
+
+	delete[] taken;
+}
@@ -1,5 +1,15 @@
+#include <stdexcept>
 #include "Thread.h"
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <sched.h>
+#include <unistd.h>
+#endif
+
 namespace ducklib
 {
 Thread::Thread(uint32 (* func)(void*), void* data)
@@ -13,18 +23,53 @@ Thread::Thread(uint32 (* func)(void*), void* data)
 		data,
 		0,
 		(LPDWORD)&threadId);
+#else
+	this->func = func;
+	this->data = data;
+
+	if (pthread_create(&osHandle, nullptr, &StartThread, this) != 0)
+		throw std::runtime_error("Failed to create thread");
 #endif
 }
 
 void Thread::Join()
 {
+#ifdef _WIN32
 	WaitForSingleObject(osHandle, INFINITE);
+#else
+	pthread_join(osHandle, nullptr);
+#endif
+}
+
+#ifndef _WIN32
+void* Thread::StartThread(void* thread)
+{
+	Thread* self = (Thread*)thread;
+
+	self->func(self->data);
+
+	return nullptr;
 }
+#endif
 
 void YieldThread(uint32 ms)
 {
 #ifdef _WIN32
 	::Sleep(ms);
+#else
+	if (ms == 0)
+		sched_yield();
+	else
+		usleep(ms * 1000);
 #endif
 }
-}
\ No newline at end of file
+
+void PauseCpu()
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	_mm_pause();
+#elif defined(__aarch64__)
+	asm volatile("yield");
+#endif
+}
+}
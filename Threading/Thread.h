@@ -1,7 +1,14 @@
 #pragma once
-#include <Windows.h>
 #include "Core/Types.h"
 
+#ifdef _WIN32
+#include <Windows.h>
+#define DL_STDCALL __stdcall
+#else
+#include <pthread.h>
+#define DL_STDCALL
+#endif
+
 namespace ducklib
 {
 class Thread
@@ -17,9 +24,15 @@ private:
 #ifdef _WIN32
 	HANDLE osHandle;
 #else
-	void* osHandle;
+	static void* StartThread(void* thread);
+
+	pthread_t osHandle;
+	uint32 (*func)(void*);
+	void* data;
 #endif
 };
 
 void YieldThread(uint32 ms);
-}
\ No newline at end of file
+// Hint for spin-wait loops, lets the other hardware thread on the core run
+void PauseCpu();
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include "Core/Memory/MemoryTags.h"
+
+namespace ducklib
+{
+/**
+ * Chase-Lev work-stealing deque. Only the owning thread may push and pop, which happens at the bottom without any
+ * atomic read-modify-writes unless the deque is down to its last item. Any thread may steal from the top. The capacity
+ * is fixed and rounded up to a power of two, pushing to a full deque fails.
+ *
+ * A thief only learns that it lost the race for an item after reading it, by which time the owner may be overwriting
+ * the slot. Items are therefore copied word by word with relaxed atomics and T has to be trivially copyable.
+ */
+template <typename T>
+class WorkStealingDeque
+{
+public:
+
+	explicit WorkStealingDeque(uint32 capacity);
+	~WorkStealingDeque();
+
+	bool TryPush(const T& item);
+	bool TryPop(T* item);
+	// Also fails when losing a race with the owner or another thief, so an empty result isn't final
+	bool TrySteal(T* item);
+
+	// Only a snapshot while other threads are stealing
+	uint32 Length() const;
+
+private:
+
+	static_assert(std::is_trivially_copyable_v<T>, "Work-stealing deque items are copied without their constructors");
+
+	static constexpr uint32 WORDS_PER_ITEM = (sizeof(T) + sizeof(uintptr_t) - 1) / sizeof(uintptr_t);
+
+	struct Slot
+	{
+		std::atomic<uintptr_t> words[WORDS_PER_ITEM];
+	};
+
+	void Store(int64 index, const T& item);
+	void Load(int64 index, T* item) const;
+
+	Slot* slots;
+	uint32 mask;
+
+	alignas(CACHE_LINE_SIZE) std::atomic<int64> top;
+	alignas(CACHE_LINE_SIZE) std::atomic<int64> bottom;
+};
+
+template <typename T>
+WorkStealingDeque<T>::WorkStealingDeque(uint32 capacity)
+{
+	uint32 powerOfTwoCapacity = 1;
+
+	while (powerOfTwoCapacity < capacity)
+		powerOfTwoCapacity <<= 1;
+
+	slots = TagAlloc(MemoryTag::THREADING)->Allocate<Slot>(powerOfTwoCapacity);
+	mask = powerOfTwoCapacity - 1;
+	top.store(0);
+	bottom.store(0);
+}
+
+template <typename T>
+WorkStealingDeque<T>::~WorkStealingDeque()
+{
+	TagAlloc(MemoryTag::THREADING)->Free(slots);
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::TryPush(const T& item)
+{
+	int64 cachedBottom = bottom.load(std::memory_order_relaxed);
+	int64 cachedTop = top.load(std::memory_order_acquire);
+
+	if (cachedBottom - cachedTop > (int64)mask)
+		return false;
+
+	Store(cachedBottom, item);
+	// Publishes the item before the thieves can see the new bottom
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom.store(cachedBottom + 1, std::memory_order_relaxed);
+
+	return true;
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::TryPop(T* item)
+{
+	int64 newBottom = bottom.load(std::memory_order_relaxed) - 1;
+
+	// Claims the bottom item before looking at top, so a thief either sees the claim or the owner sees the steal
+	bottom.store(newBottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	int64 cachedTop = top.load(std::memory_order_relaxed);
+
+	if (cachedTop > newBottom)
+	{
+		bottom.store(newBottom + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	Load(newBottom, item);
+
+	if (cachedTop != newBottom)
+		return true;
+
+	// Last item, race the thieves for it
+	bool won = top.compare_exchange_strong(cachedTop, cachedTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+
+	bottom.store(newBottom + 1, std::memory_order_relaxed);
+
+	return won;
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::TrySteal(T* item)
+{
+	int64 cachedTop = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64 cachedBottom = bottom.load(std::memory_order_acquire);
+
+	if (cachedTop >= cachedBottom)
+		return false;
+
+	Load(cachedTop, item);
+
+	return top.compare_exchange_strong(cachedTop, cachedTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+template <typename T>
+uint32 WorkStealingDeque<T>::Length() const
+{
+	int64 length = bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_relaxed);
+
+	return length > 0 ? (uint32)length : 0;
+}
+
+template <typename T>
+void WorkStealingDeque<T>::Store(int64 index, const T& item)
+{
+	uintptr_t words[WORDS_PER_ITEM] = {};
+	Slot& slot = slots[index & mask];
+
+	memcpy(words, &item, sizeof(T));
+
+	for (uint32 i = 0; i < WORDS_PER_ITEM; ++i)
+		slot.words[i].store(words[i], std::memory_order_relaxed);
+}
+
+template <typename T>
+void WorkStealingDeque<T>::Load(int64 index, T* item) const
+{
+	uintptr_t words[WORDS_PER_ITEM];
+	const Slot& slot = slots[index & mask];
+
+	for (uint32 i = 0; i < WORDS_PER_ITEM; ++i)
+		words[i] = slot.words[i].load(std::memory_order_relaxed);
+
+	memcpy(item, words, sizeof(T));
+}
+}